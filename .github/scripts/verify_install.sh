@@ -7,7 +7,7 @@ SHARE_LOCATION="/usr/share"
 echo "Verifying installation..."
 
 # Check executables
-for exe in jesd_eye_scan jesd_status jesd204_topology; do
+for exe in jesd_eye_scan jesd_eye_scan_cli jesd_status jesd204_topology jesd_exporter jesd_monitord; do
     if [ -e "$EXECUTABLE_LOCATION/$exe" ]; then
         echo "[OK] $EXECUTABLE_LOCATION/$exe exists"
     else
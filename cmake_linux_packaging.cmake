@@ -17,7 +17,7 @@ if (DEBBUILD_CMD)
     set(CPACK_GENERATOR DEB)
     
     # Debian package dependencies
-    set(CPACK_DEBIAN_PACKAGE_DEPENDS "libgtk-3-0, libncurses6, gnuplot")
+    set(CPACK_DEBIAN_PACKAGE_DEPENDS "libgtk-3-0, libncurses6")
     
     # Package metadata
     set(CPACK_PACKAGE_CONTACT "Engineerzone <https://ez.analog.com/sw-interface-tools>")
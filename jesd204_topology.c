@@ -22,8 +22,11 @@
 #include <unistd.h>
 #include <getopt.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <ctype.h>
 #include <sys/stat.h>
 #include <limits.h>
+#include <pthread.h>
 
 #define JESD204_SYSFS_PATH	"/sys/bus/jesd204/devices"
 #define MAX_PATH_LEN		PATH_MAX
@@ -31,6 +34,7 @@
 #define MAX_DEVICES		64
 #define MAX_LINKS		16
 #define MAX_CONNECTIONS		128
+#define MAX_JOBS		16
 
 /* JESD204 link parameters */
 struct jesd204_link_info {
@@ -101,6 +105,7 @@ static struct {
 	bool set_ignore_errors;
 	bool clear_ignore_errors;
 	int ignore_errors_link;  /* -1 for all links, >= 0 for specific link */
+	unsigned int jobs;       /* parser threads, 0 for one per online CPU */
 	char dot_filename[MAX_PATH_LEN];
 	char sysfs_path[MAX_PATH_LEN];
 } options = {
@@ -110,6 +115,7 @@ static struct {
 	.set_ignore_errors = false,
 	.clear_ignore_errors = false,
 	.ignore_errors_link = -1,
+	.jobs = 0,
 	.dot_filename = "jesd204_topology.dot",
 	.sysfs_path = JESD204_SYSFS_PATH,
 };
@@ -126,6 +132,7 @@ static void print_usage(const char *progname)
 	printf("  -g, --graph             Display ASCII topology graph\n");
 	printf("  -d, --dot <file>        Generate DOT file for graphviz visualization\n");
 	printf("  -p, --path <path>       Override sysfs path (default: %s)\n", JESD204_SYSFS_PATH);
+	printf("  -j, --jobs <n>          Parse sysfs with n threads (default: one per CPU, max %d)\n", MAX_JOBS);
 	printf("  -i, --ignore-errors [link]   Set fsm_ignore_errors for link (or all if no link specified)\n");
 	printf("  -I, --no-ignore-errors [link] Clear fsm_ignore_errors for link (or all if no link specified)\n");
 	printf("\n");
@@ -142,21 +149,27 @@ static void print_usage(const char *progname)
 	printf("  dot -Tsvg topology.dot -o topology.svg\n");
 }
 
-static int read_sysfs_string(const char *path, char *buf, size_t len)
+/*
+ * Attributes are read relative to the device directory's fd, so every read is
+ * a single lookup of the attribute name instead of a walk of the full path.
+ */
+static int read_device_attr_string(int dirfd, const char *attr,
+				   char *buf, size_t len)
 {
-	FILE *f;
 	char *newline;
+	ssize_t ret;
+	int fd;
 
-	f = fopen(path, "r");
-	if (!f)
+	fd = openat(dirfd, attr, O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
 		return -errno;
 
-	if (!fgets(buf, len, f)) {
-		fclose(f);
+	ret = read(fd, buf, len - 1);
+	close(fd);
+	if (ret <= 0)
 		return -EIO;
-	}
 
-	fclose(f);
+	buf[ret] = '\0';
 
 	/* Remove trailing newline */
 	newline = strchr(buf, '\n');
@@ -166,12 +179,12 @@ static int read_sysfs_string(const char *path, char *buf, size_t len)
 	return 0;
 }
 
-static int read_sysfs_uint(const char *path, unsigned int *val)
+static int read_device_attr_uint(int dirfd, const char *attr, unsigned int *val)
 {
 	char buf[64];
 	int ret;
 
-	ret = read_sysfs_string(path, buf, sizeof(buf));
+	ret = read_device_attr_string(dirfd, attr, buf, sizeof(buf));
 	if (ret)
 		return ret;
 
@@ -179,12 +192,12 @@ static int read_sysfs_uint(const char *path, unsigned int *val)
 	return 0;
 }
 
-static int read_sysfs_int(const char *path, int *val)
+static int read_device_attr_int(int dirfd, const char *attr, int *val)
 {
 	char buf[64];
 	int ret;
 
-	ret = read_sysfs_string(path, buf, sizeof(buf));
+	ret = read_device_attr_string(dirfd, attr, buf, sizeof(buf));
 	if (ret)
 		return ret;
 
@@ -192,12 +205,12 @@ static int read_sysfs_int(const char *path, int *val)
 	return 0;
 }
 
-static int read_sysfs_bool(const char *path, bool *val)
+static int read_device_attr_bool(int dirfd, const char *attr, bool *val)
 {
 	unsigned int tmp;
 	int ret;
 
-	ret = read_sysfs_uint(path, &tmp);
+	ret = read_device_attr_uint(dirfd, attr, &tmp);
 	if (ret)
 		return ret;
 
@@ -205,12 +218,13 @@ static int read_sysfs_bool(const char *path, bool *val)
 	return 0;
 }
 
-static int read_sysfs_ull(const char *path, unsigned long long *val)
+static int read_device_attr_ull(int dirfd, const char *attr,
+				unsigned long long *val)
 {
 	char buf[64];
 	int ret;
 
-	ret = read_sysfs_string(path, buf, sizeof(buf));
+	ret = read_device_attr_string(dirfd, attr, buf, sizeof(buf));
 	if (ret)
 		return ret;
 
@@ -254,54 +268,8 @@ static bool sysfs_file_exists(const char *device_path, const char *attr)
 	return (stat(path, &st) == 0);
 }
 
-/* Read a sysfs attribute from device path */
-static int read_device_attr_string(const char *device_path, const char *attr,
-				   char *buf, size_t len)
-{
-	char path[MAX_PATH_LEN];
-
-	snprintf(path, sizeof(path), "%s/%s", device_path, attr);
-	return read_sysfs_string(path, buf, len);
-}
-
-static int read_device_attr_uint(const char *device_path, const char *attr,
-				 unsigned int *val)
-{
-	char path[MAX_PATH_LEN];
-
-	snprintf(path, sizeof(path), "%s/%s", device_path, attr);
-	return read_sysfs_uint(path, val);
-}
-
-static int read_device_attr_int(const char *device_path, const char *attr,
-				int *val)
-{
-	char path[MAX_PATH_LEN];
-
-	snprintf(path, sizeof(path), "%s/%s", device_path, attr);
-	return read_sysfs_int(path, val);
-}
-
-static int read_device_attr_bool(const char *device_path, const char *attr,
-				 bool *val)
-{
-	char path[MAX_PATH_LEN];
-
-	snprintf(path, sizeof(path), "%s/%s", device_path, attr);
-	return read_sysfs_bool(path, val);
-}
-
-static int read_device_attr_ull(const char *device_path, const char *attr,
-				unsigned long long *val)
-{
-	char path[MAX_PATH_LEN];
-
-	snprintf(path, sizeof(path), "%s/%s", device_path, attr);
-	return read_sysfs_ull(path, val);
-}
-
 /* Parse link info from flat sysfs attributes (link0_xxx, link1_xxx, etc.) */
-static int parse_link_info(const char *device_path, unsigned int link_idx,
+static int parse_link_info(int dirfd, unsigned int link_idx,
 			   struct jesd204_link_info *link)
 {
 	char attr[64];
@@ -309,87 +277,87 @@ static int parse_link_info(const char *device_path, unsigned int link_idx,
 	memset(link, 0, sizeof(*link));
 
 	snprintf(attr, sizeof(attr), "link%u_link_id", link_idx);
-	if (read_device_attr_uint(device_path, attr, &link->link_id) != 0)
+	if (read_device_attr_uint(dirfd, attr, &link->link_id) != 0)
 		return -ENOENT;
 
 	snprintf(attr, sizeof(attr), "link%u_error", link_idx);
-	read_device_attr_int(device_path, attr, &link->error);
+	read_device_attr_int(dirfd, attr, &link->error);
 
 	snprintf(attr, sizeof(attr), "link%u_state", link_idx);
-	read_device_attr_string(device_path, attr, link->state, sizeof(link->state));
+	read_device_attr_string(dirfd, attr, link->state, sizeof(link->state));
 
 	snprintf(attr, sizeof(attr), "link%u_fsm_paused", link_idx);
-	read_device_attr_bool(device_path, attr, &link->fsm_paused);
+	read_device_attr_bool(dirfd, attr, &link->fsm_paused);
 
 	snprintf(attr, sizeof(attr), "link%u_fsm_ignore_errors", link_idx);
-	read_device_attr_bool(device_path, attr, &link->fsm_ignore_errors);
+	read_device_attr_bool(dirfd, attr, &link->fsm_ignore_errors);
 
 	snprintf(attr, sizeof(attr), "link%u_sample_rate", link_idx);
-	read_device_attr_ull(device_path, attr, &link->sample_rate);
+	read_device_attr_ull(dirfd, attr, &link->sample_rate);
 
 	snprintf(attr, sizeof(attr), "link%u_sample_rate_div", link_idx);
-	if (read_device_attr_uint(device_path, attr, &link->sample_rate_div) != 0)
+	if (read_device_attr_uint(dirfd, attr, &link->sample_rate_div) != 0)
 		link->sample_rate_div = 1; /* Default to 1 if not present */
 
 	snprintf(attr, sizeof(attr), "link%u_is_transmit", link_idx);
-	read_device_attr_bool(device_path, attr, &link->is_transmit);
+	read_device_attr_bool(dirfd, attr, &link->is_transmit);
 
 	snprintf(attr, sizeof(attr), "link%u_num_lanes", link_idx);
-	read_device_attr_uint(device_path, attr, &link->num_lanes);
+	read_device_attr_uint(dirfd, attr, &link->num_lanes);
 
 	snprintf(attr, sizeof(attr), "link%u_num_converters", link_idx);
-	read_device_attr_uint(device_path, attr, &link->num_converters);
+	read_device_attr_uint(dirfd, attr, &link->num_converters);
 
 	snprintf(attr, sizeof(attr), "link%u_octets_per_frame", link_idx);
-	read_device_attr_uint(device_path, attr, &link->octets_per_frame);
+	read_device_attr_uint(dirfd, attr, &link->octets_per_frame);
 
 	snprintf(attr, sizeof(attr), "link%u_frames_per_multiframe", link_idx);
-	read_device_attr_uint(device_path, attr, &link->frames_per_multiframe);
+	read_device_attr_uint(dirfd, attr, &link->frames_per_multiframe);
 
 	snprintf(attr, sizeof(attr), "link%u_num_of_multiblocks_in_emb", link_idx);
-	read_device_attr_uint(device_path, attr, &link->num_of_multiblocks_in_emb);
+	read_device_attr_uint(dirfd, attr, &link->num_of_multiblocks_in_emb);
 
 	snprintf(attr, sizeof(attr), "link%u_bits_per_sample", link_idx);
-	read_device_attr_uint(device_path, attr, &link->bits_per_sample);
+	read_device_attr_uint(dirfd, attr, &link->bits_per_sample);
 
 	snprintf(attr, sizeof(attr), "link%u_converter_resolution", link_idx);
-	read_device_attr_uint(device_path, attr, &link->converter_resolution);
+	read_device_attr_uint(dirfd, attr, &link->converter_resolution);
 
 	snprintf(attr, sizeof(attr), "link%u_jesd_version", link_idx);
-	read_device_attr_uint(device_path, attr, &link->jesd_version);
+	read_device_attr_uint(dirfd, attr, &link->jesd_version);
 
 	snprintf(attr, sizeof(attr), "link%u_jesd_encoder", link_idx);
-	read_device_attr_uint(device_path, attr, &link->jesd_encoder);
+	read_device_attr_uint(dirfd, attr, &link->jesd_encoder);
 
 	snprintf(attr, sizeof(attr), "link%u_subclass", link_idx);
-	read_device_attr_uint(device_path, attr, &link->subclass);
+	read_device_attr_uint(dirfd, attr, &link->subclass);
 
 	snprintf(attr, sizeof(attr), "link%u_device_id", link_idx);
-	read_device_attr_uint(device_path, attr, &link->device_id);
+	read_device_attr_uint(dirfd, attr, &link->device_id);
 
 	snprintf(attr, sizeof(attr), "link%u_bank_id", link_idx);
-	read_device_attr_uint(device_path, attr, &link->bank_id);
+	read_device_attr_uint(dirfd, attr, &link->bank_id);
 
 	snprintf(attr, sizeof(attr), "link%u_scrambling", link_idx);
-	read_device_attr_bool(device_path, attr, &link->scrambling);
+	read_device_attr_bool(dirfd, attr, &link->scrambling);
 
 	snprintf(attr, sizeof(attr), "link%u_high_density", link_idx);
-	read_device_attr_bool(device_path, attr, &link->high_density);
+	read_device_attr_bool(dirfd, attr, &link->high_density);
 
 	snprintf(attr, sizeof(attr), "link%u_ctrl_words_per_frame_clk", link_idx);
-	read_device_attr_uint(device_path, attr, &link->ctrl_words_per_frame_clk);
+	read_device_attr_uint(dirfd, attr, &link->ctrl_words_per_frame_clk);
 
 	snprintf(attr, sizeof(attr), "link%u_ctrl_bits_per_sample", link_idx);
-	read_device_attr_uint(device_path, attr, &link->ctrl_bits_per_sample);
+	read_device_attr_uint(dirfd, attr, &link->ctrl_bits_per_sample);
 
 	snprintf(attr, sizeof(attr), "link%u_samples_per_conv_frame", link_idx);
-	read_device_attr_uint(device_path, attr, &link->samples_per_conv_frame);
+	read_device_attr_uint(dirfd, attr, &link->samples_per_conv_frame);
 
 	return 0;
 }
 
 /* Parse input connection (in0_xxx, in1_xxx, etc.) */
-static int parse_input_connection(const char *device_path, const char *device_name,
+static int parse_input_connection(int dirfd, const char *device_name,
 				  unsigned int con_idx, struct jesd204_connection *con)
 {
 	char attr[64];
@@ -399,30 +367,30 @@ static int parse_input_connection(const char *device_path, const char *device_na
 	con->is_input = true;
 
 	snprintf(attr, sizeof(attr), "in%u_to", con_idx);
-	if (read_device_attr_string(device_path, attr, con->to_device,
+	if (read_device_attr_string(dirfd, attr, con->to_device,
 				    sizeof(con->to_device)) != 0)
 		return -ENOENT;
 
 	snprintf(attr, sizeof(attr), "in%u_id", con_idx);
-	read_device_attr_uint(device_path, attr, &con->con_id);
+	read_device_attr_uint(dirfd, attr, &con->con_id);
 
 	snprintf(attr, sizeof(attr), "in%u_topo_id", con_idx);
-	read_device_attr_uint(device_path, attr, &con->topo_id);
+	read_device_attr_uint(dirfd, attr, &con->topo_id);
 
 	snprintf(attr, sizeof(attr), "in%u_link_id", con_idx);
-	read_device_attr_uint(device_path, attr, &con->link_id);
+	read_device_attr_uint(dirfd, attr, &con->link_id);
 
 	snprintf(attr, sizeof(attr), "in%u_state", con_idx);
-	read_device_attr_string(device_path, attr, con->state, sizeof(con->state));
+	read_device_attr_string(dirfd, attr, con->state, sizeof(con->state));
 
 	snprintf(attr, sizeof(attr), "in%u_error", con_idx);
-	read_device_attr_int(device_path, attr, &con->error);
+	read_device_attr_int(dirfd, attr, &con->error);
 
 	return 0;
 }
 
 /* Parse output connection (out0_xxx, out1_xxx, etc.) */
-static int parse_output_connection(const char *device_path, const char *device_name,
+static int parse_output_connection(int dirfd, const char *device_name,
 				   unsigned int con_idx, struct jesd204_connection *con)
 {
 	char attr[64];
@@ -432,115 +400,386 @@ static int parse_output_connection(const char *device_path, const char *device_n
 	con->is_input = false;
 
 	snprintf(attr, sizeof(attr), "out%u_to", con_idx);
-	if (read_device_attr_string(device_path, attr, con->to_device,
+	if (read_device_attr_string(dirfd, attr, con->to_device,
 				    sizeof(con->to_device)) != 0)
 		return -ENOENT;
 
 	snprintf(attr, sizeof(attr), "out%u_id", con_idx);
-	read_device_attr_uint(device_path, attr, &con->con_id);
+	read_device_attr_uint(dirfd, attr, &con->con_id);
 
 	snprintf(attr, sizeof(attr), "out%u_topo_id", con_idx);
-	read_device_attr_uint(device_path, attr, &con->topo_id);
+	read_device_attr_uint(dirfd, attr, &con->topo_id);
 
 	snprintf(attr, sizeof(attr), "out%u_link_id", con_idx);
-	read_device_attr_uint(device_path, attr, &con->link_id);
+	read_device_attr_uint(dirfd, attr, &con->link_id);
 
 	snprintf(attr, sizeof(attr), "out%u_state", con_idx);
-	read_device_attr_string(device_path, attr, con->state, sizeof(con->state));
+	read_device_attr_string(dirfd, attr, con->state, sizeof(con->state));
 
 	snprintf(attr, sizeof(attr), "out%u_error", con_idx);
-	read_device_attr_int(device_path, attr, &con->error);
+	read_device_attr_int(dirfd, attr, &con->error);
 
 	return 0;
 }
 
-static int parse_device(const char *sysfs_path, const char *dev_name)
+/*
+ * Devices and their links are parsed on a small work-stealing pool, every
+ * sysfs read is a syscall and on large systems they add up to seconds. Each
+ * worker owns a deque, it pops its own tasks from the bottom and steals from
+ * the top of the others' when it runs dry. A device task reads the device
+ * attributes, pushes one task per link onto its own deque and parses the
+ * connections while idle workers take the links. Results land in the slot of
+ * the device's readdir index and scan_devices() compacts them in order, so
+ * the output does not depend on the job count.
+ */
+#define TOPO_QUEUE_LEN		(MAX_DEVICES * (MAX_LINKS + 1))
+
+struct topo_task {
+	unsigned int dev;
+	int link;		/* -1 for the device task */
+};
+
+struct topo_worker {
+	pthread_mutex_t lock;
+	pthread_t thread;
+	bool started;
+	unsigned int id;
+	unsigned int top;	/* thieves take from here */
+	unsigned int bottom;	/* owner pushes and pops here */
+	struct topo_task task[TOPO_QUEUE_LEN];
+};
+
+#define INDEX_WORDS(n)		(((n) + 63) / 64)
+
+/*
+ * Which linkN_link_id, inN_to and outN_to exist, filled from one readdir of
+ * the device directory instead of probing every index with stat()
+ */
+struct topo_index {
+	unsigned long long links[INDEX_WORDS(MAX_LINKS)];
+	unsigned long long in[INDEX_WORDS(MAX_CONNECTIONS)];
+	unsigned long long out[INDEX_WORDS(MAX_CONNECTIONS)];
+};
+
+/* Parse result of one readdir entry */
+struct topo_slot {
+	char dev_name[MAX_NAME_LEN];
+	int err;
+	DIR *dir;		/* open until the link tasks are done */
+	struct topo_index index;
+	unsigned int probed_links;
+	bool link_ok[MAX_LINKS];
+};
+
+static struct {
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	unsigned long pushes;	/* wakes workers waiting for something to steal */
+	unsigned int pending;	/* queued or running tasks */
+	unsigned int jobs;
+	const char *sysfs_path;
+	int bus_fd;
+	struct topo_slot slot[MAX_DEVICES];
+	struct topo_worker worker[MAX_JOBS];
+} pool = {
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+	.cond = PTHREAD_COND_INITIALIZER,
+};
+
+static void pool_push(struct topo_worker *w, unsigned int dev, int link)
+{
+	/* Count it first, a thief may finish it before we get the lock back */
+	pthread_mutex_lock(&pool.lock);
+	pool.pending++;
+	pthread_mutex_unlock(&pool.lock);
+
+	pthread_mutex_lock(&w->lock);
+	w->task[w->bottom].dev = dev;
+	w->task[w->bottom].link = link;
+	w->bottom++;
+	pthread_mutex_unlock(&w->lock);
+
+	pthread_mutex_lock(&pool.lock);
+	pool.pushes++;
+	pthread_cond_broadcast(&pool.cond);
+	pthread_mutex_unlock(&pool.lock);
+}
+
+static bool pool_pop(struct topo_worker *w, struct topo_task *task)
+{
+	bool found = false;
+
+	pthread_mutex_lock(&w->lock);
+	if (w->top < w->bottom) {
+		*task = w->task[--w->bottom];
+		found = true;
+	}
+	pthread_mutex_unlock(&w->lock);
+
+	return found;
+}
+
+static bool pool_steal(struct topo_worker *w, struct topo_task *task)
 {
-	struct jesd204_device *dev;
-	char attr[64];
 	unsigned int i;
-	unsigned int num_links_attr = 0;
-	int topo_id = -1;
 
-	if (num_devices >= MAX_DEVICES) {
-		fprintf(stderr, "Too many devices (max %d)\n", MAX_DEVICES);
-		return -ENOMEM;
+	for (i = 1; i < pool.jobs; i++) {
+		struct topo_worker *victim = &pool.worker[(w->id + i) % pool.jobs];
+		bool found = false;
+
+		pthread_mutex_lock(&victim->lock);
+		if (victim->top < victim->bottom) {
+			*task = victim->task[victim->top++];
+			found = true;
+		}
+		pthread_mutex_unlock(&victim->lock);
+
+		if (found)
+			return true;
 	}
 
-	dev = &devices[num_devices];
+	return false;
+}
+
+static bool index_test(const unsigned long long *map, unsigned int n)
+{
+	return map[n / 64] & (1ULL << (n % 64));
+}
+
+/* Sets bit N in @map if @name is <prefix>N<suffix> and N < @max */
+static void index_add(unsigned long long *map, unsigned int max, const char *name,
+		      const char *prefix, const char *suffix)
+{
+	size_t len = strlen(prefix);
+	unsigned long n;
+	char *end;
+
+	if (strncmp(name, prefix, len) || !isdigit((unsigned char)name[len]))
+		return;
+
+	n = strtoul(name + len, &end, 10);
+	if (!strcmp(end, suffix) && n < max)
+		map[n / 64] |= 1ULL << (n % 64);
+}
+
+static void index_device(DIR *dir, struct topo_index *index)
+{
+	struct dirent *entry;
+
+	memset(index, 0, sizeof(*index));
+
+	while ((entry = readdir(dir)) != NULL) {
+		switch (entry->d_name[0]) {
+		case 'l':
+			index_add(index->links, MAX_LINKS, entry->d_name,
+				  "link", "_link_id");
+			break;
+		case 'i':
+			index_add(index->in, MAX_CONNECTIONS, entry->d_name,
+				  "in", "_to");
+			break;
+		case 'o':
+			index_add(index->out, MAX_CONNECTIONS, entry->d_name,
+				  "out", "_to");
+			break;
+		}
+	}
+}
+
+static void parse_link(unsigned int idx, unsigned int link_idx)
+{
+	struct jesd204_device *dev = &devices[idx];
+
+	struct topo_slot *slot = &pool.slot[idx];
+
+	slot->link_ok[link_idx] = parse_link_info(dirfd(slot->dir), link_idx,
+						  &dev->links[link_idx]) == 0;
+}
+
+static int parse_device(struct topo_worker *w, unsigned int idx)
+{
+	struct jesd204_device *dev = &devices[idx];
+	struct topo_slot *slot = &pool.slot[idx];
+	const char *dev_name = slot->dev_name;
+	unsigned int i, max_links;
+	unsigned int num_links_attr = 0;
+	int topo_id = -1;
+	int fd;
+
 	memset(dev, 0, sizeof(*dev));
 
 	snprintf(dev->sysfs_name, sizeof(dev->sysfs_name), "%s", dev_name);
 	if (snprintf(dev->sysfs_path, sizeof(dev->sysfs_path), "%s/%s",
-		     sysfs_path, dev_name) >= (int)sizeof(dev->sysfs_path)) {
-		fprintf(stderr, "Path too long: %s/%s\n", sysfs_path, dev_name);
+		     pool.sysfs_path, dev_name) >= (int)sizeof(dev->sysfs_path)) {
+		fprintf(stderr, "Path too long: %s/%s\n", pool.sysfs_path, dev_name);
 		return -ENAMETOOLONG;
 	}
 
+	/* An unreadable device is still listed, under its sysfs name */
+	fd = openat(pool.bus_fd, dev_name, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if (fd >= 0) {
+		slot->dir = fdopendir(fd);
+		if (!slot->dir)
+			close(fd);
+	}
+
+	if (!slot->dir) {
+		snprintf(dev->name, sizeof(dev->name), "%s", dev_name);
+		dev->topology_id = -1;
+		return 0;
+	}
+
+	index_device(slot->dir, &slot->index);
+
 	/* Read device name from sysfs */
-	if (read_device_attr_string(dev->sysfs_path, "name", dev->name,
+	if (read_device_attr_string(fd, "name", dev->name,
 				    sizeof(dev->name)) != 0) {
 		snprintf(dev->name, sizeof(dev->name), "%s", dev_name);
 	}
 
 	/* Check if this is a top device (has num_links attribute) */
-	if (read_device_attr_uint(dev->sysfs_path, "num_links", &num_links_attr) == 0) {
+	if (read_device_attr_uint(fd, "num_links", &num_links_attr) == 0) {
 		dev->is_top = true;
 	}
 
 	/* Read topology_id if present */
-	if (read_device_attr_int(dev->sysfs_path, "topology_id", &topo_id) == 0) {
+	if (read_device_attr_int(fd, "topology_id", &topo_id) == 0) {
 		dev->topology_id = topo_id;
 	} else {
 		dev->topology_id = -1;
 	}
 
 	/* Read num_retries if present */
-	read_device_attr_uint(dev->sysfs_path, "num_retries", &dev->num_retries);
-
-	/* Parse links (link0_xxx, link1_xxx, etc.) - use num_links if available */
-	for (i = 0; i < (num_links_attr > 0 ? num_links_attr : MAX_LINKS); i++) {
-		snprintf(attr, sizeof(attr), "link%u_link_id", i);
-		if (!sysfs_file_exists(dev->sysfs_path, attr))
-			break;
+	read_device_attr_uint(fd, "num_retries", &dev->num_retries);
 
-		if (parse_link_info(dev->sysfs_path, i, &dev->links[dev->num_links]) == 0) {
-			dev->num_links++;
-			dev->is_top = true;
-		}
-	}
+	/*
+	 * Queue links (link0_xxx, link1_xxx, etc.) - use num_links if available.
+	 * Each one parses into links[i], scan_devices() drops the failed ones.
+	 * Like the connections below, numbering stops at the first gap.
+	 */
+	max_links = num_links_attr > 0 && num_links_attr < MAX_LINKS ?
+		    num_links_attr : MAX_LINKS;
+	for (i = 0; i < max_links && index_test(slot->index.links, i); i++)
+		pool_push(w, idx, i);
+	slot->probed_links = i;
 
 	/* Parse input connections (in0_xxx, in1_xxx, etc.) */
-	for (i = 0; i < MAX_CONNECTIONS; i++) {
-		snprintf(attr, sizeof(attr), "in%u_to", i);
-		if (!sysfs_file_exists(dev->sysfs_path, attr))
-			break;
-
-		if (parse_input_connection(dev->sysfs_path, dev->name, i,
+	for (i = 0; i < MAX_CONNECTIONS && index_test(slot->index.in, i); i++) {
+		if (parse_input_connection(fd, dev->name, i,
 					   &dev->input_cons[dev->num_input_cons]) == 0) {
 			dev->num_input_cons++;
 		}
 	}
 
 	/* Parse output connections (out0_xxx, out1_xxx, etc.) */
-	for (i = 0; i < MAX_CONNECTIONS; i++) {
-		snprintf(attr, sizeof(attr), "out%u_to", i);
-		if (!sysfs_file_exists(dev->sysfs_path, attr))
-			break;
-
-		if (parse_output_connection(dev->sysfs_path, dev->name, i,
+	for (i = 0; i < MAX_CONNECTIONS && index_test(slot->index.out, i); i++) {
+		if (parse_output_connection(fd, dev->name, i,
 					    &dev->output_cons[dev->num_output_cons]) == 0) {
 			dev->num_output_cons++;
 		}
 	}
 
-	num_devices++;
 	return 0;
 }
 
+static void *pool_worker(void *arg)
+{
+	struct topo_worker *w = arg;
+	struct topo_task task;
+	unsigned long seen;
+
+	for (;;) {
+		pthread_mutex_lock(&pool.lock);
+		seen = pool.pushes;
+		if (!pool.pending) {
+			pthread_mutex_unlock(&pool.lock);
+			break;
+		}
+		pthread_mutex_unlock(&pool.lock);
+
+		if (pool_pop(w, &task) || pool_steal(w, &task)) {
+			if (task.link < 0)
+				pool.slot[task.dev].err = parse_device(w, task.dev);
+			else
+				parse_link(task.dev, task.link);
+
+			pthread_mutex_lock(&pool.lock);
+			if (!--pool.pending)
+				pthread_cond_broadcast(&pool.cond);
+			pthread_mutex_unlock(&pool.lock);
+			continue;
+		}
+
+		/* Nothing to steal, sleep until a push or the last task is done */
+		pthread_mutex_lock(&pool.lock);
+		while (pool.pending && pool.pushes == seen)
+			pthread_cond_wait(&pool.cond, &pool.lock);
+		pthread_mutex_unlock(&pool.lock);
+	}
+
+	return NULL;
+}
+
+static unsigned int pool_jobs(unsigned int count)
+{
+	long cpus;
+	unsigned int jobs = options.jobs;
+
+	if (!jobs) {
+		cpus = sysconf(_SC_NPROCESSORS_ONLN);
+		jobs = cpus > 0 ? (cpus < MAX_JOBS ? cpus : MAX_JOBS) : 1;
+	}
+
+	if (jobs > count)
+		jobs = count;
+
+	return jobs ? jobs : 1;
+}
+
+/* Runs the device tasks queued in pool.slot[0..count) to completion */
+static void pool_run(unsigned int count)
+{
+	unsigned int i;
+
+	pool.jobs = pool_jobs(count);
+	pool.pending = 0;
+	pool.pushes = 0;
+
+	for (i = 0; i < pool.jobs; i++) {
+		struct topo_worker *w = &pool.worker[i];
+
+		pthread_mutex_init(&w->lock, NULL);
+		w->id = i;
+		w->top = 0;
+		w->bottom = 0;
+		w->started = false;
+	}
+
+	for (i = 0; i < count; i++)
+		pool_push(&pool.worker[i % pool.jobs], i, -1);
+
+	/* The calling thread is worker 0, the others steal what nobody runs */
+	for (i = 1; i < pool.jobs; i++) {
+		struct topo_worker *w = &pool.worker[i];
+
+		w->started = pthread_create(&w->thread, NULL, pool_worker, w) == 0;
+	}
+
+	pool_worker(&pool.worker[0]);
+
+	for (i = 0; i < pool.jobs; i++) {
+		struct topo_worker *w = &pool.worker[i];
+
+		if (w->started)
+			pthread_join(w->thread, NULL);
+		pthread_mutex_destroy(&w->lock);
+	}
+}
+
 static int scan_devices(const char *sysfs_path)
 {
 	struct dirent *entry;
+	unsigned int count = 0, i, j;
 	DIR *dir;
 
 	dir = opendir(sysfs_path);
@@ -554,15 +793,67 @@ static int scan_devices(const char *sysfs_path)
 		if (entry->d_name[0] == '.')
 			continue;
 
-		if (entry->d_type == DT_LNK || entry->d_type == DT_DIR) {
-			parse_device(sysfs_path, entry->d_name);
+		if (entry->d_type != DT_LNK && entry->d_type != DT_DIR)
+			continue;
+
+		if (count >= MAX_DEVICES) {
+			fprintf(stderr, "Too many devices (max %d)\n", MAX_DEVICES);
+			continue;
 		}
+
+		memset(&pool.slot[count], 0, sizeof(pool.slot[count]));
+		snprintf(pool.slot[count].dev_name, sizeof(pool.slot[count].dev_name),
+			 "%s", entry->d_name);
+		count++;
 	}
 
+	/* Device directories are opened relative to the bus directory */
+	pool.sysfs_path = sysfs_path;
+	pool.bus_fd = dirfd(dir);
+	pool_run(count);
 	closedir(dir);
+
+	/* Merge in readdir order, dropping what failed to parse */
+	num_devices = 0;
+	for (i = 0; i < count; i++) {
+		struct topo_slot *slot = &pool.slot[i];
+		struct jesd204_device *dev = &devices[num_devices];
+
+		if (slot->dir)
+			closedir(slot->dir);
+
+		if (slot->err)
+			continue;
+
+		if (dev != &devices[i])
+			memcpy(dev, &devices[i], sizeof(*dev));
+
+		for (j = 0; j < slot->probed_links; j++) {
+			if (!slot->link_ok[j])
+				continue;
+
+			if (dev->num_links != j)
+				dev->links[dev->num_links] = dev->links[j];
+			dev->num_links++;
+			dev->is_top = true;
+		}
+
+		num_devices++;
+	}
+
 	return 0;
 }
 
+/* Scans @sysfs_path from scratch, returns the number of devices (jesd_bench) */
+int jesd204_topology_scan(const char *sysfs_path)
+{
+	int ret;
+
+	ret = scan_devices(sysfs_path);
+
+	return ret ? ret : num_devices;
+}
+
 static const char *jesd_version_str(unsigned int version)
 {
 	switch (version) {
@@ -1582,13 +1873,14 @@ static int parse_options(int argc, char *argv[])
 		{"graph",            no_argument,       NULL, 'g'},
 		{"dot",              required_argument, NULL, 'd'},
 		{"path",             required_argument, NULL, 'p'},
+		{"jobs",             required_argument, NULL, 'j'},
 		{"ignore-errors",    optional_argument, NULL, 'i'},
 		{"no-ignore-errors", optional_argument, NULL, 'I'},
 		{NULL,               0,                 NULL, 0}
 	};
 	int opt;
 
-	while ((opt = getopt_long(argc, argv, "hvgd:p:i::I::", long_options, NULL)) != -1) {
+	while ((opt = getopt_long(argc, argv, "hvgd:p:j:i::I::", long_options, NULL)) != -1) {
 		switch (opt) {
 		case 'h':
 			print_usage(argv[0]);
@@ -1620,6 +1912,13 @@ static int parse_options(int argc, char *argv[])
 		case 'p':
 			strncpy(options.sysfs_path, optarg, sizeof(options.sysfs_path) - 1);
 			break;
+		case 'j':
+			options.jobs = atoi(optarg);
+			if (options.jobs < 1 || options.jobs > MAX_JOBS) {
+				fprintf(stderr, "Invalid job count: %s (1-%d)\n", optarg, MAX_JOBS);
+				return -EINVAL;
+			}
+			break;
 		default:
 			print_usage(argv[0]);
 			return -EINVAL;
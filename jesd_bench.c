@@ -0,0 +1,966 @@
+/***************************************************************************//**
+*   @file   jesd_bench.c
+*   @brief  JESD204 Eye Scan Micro Benchmarks
+*   @author Michael Hennerich (michael.hennerich@analog.com)
+********************************************************************************
+* Copyright 2026(c) Analog Devices, Inc. All rights reserved.
+*
+* An ADI specific BSD license, which can be found in the top level directory
+* of this repository (LICENSE.txt), and also on-line at:
+* https://github.com/analogdevicesinc/jesd-eye-scan-gtk/blob/main/LICENSE.txt
+*******************************************************************************/
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <ctype.h>
+#include <errno.h>
+#include <limits.h>
+#include <math.h>
+#include <dirent.h>
+#include <ftw.h>
+#include <libgen.h>
+#include <sys/stat.h>
+
+#include "jesd_common.h"
+#include "jesd_eye_data.h"
+
+#define BENCH_HSIZE		128
+#define BENCH_VSIZE		256
+#define BENCH_CHUNK		4095
+#define BENCH_NAME_LEN		96
+
+static unsigned iterations = 50;
+
+struct bench_result {
+	char name[BENCH_NAME_LEN];
+	unsigned iter;
+	double us_per_op;
+	double mb_s;
+};
+
+static struct bench_result *results;
+static unsigned num_results;
+
+/* jesd204_topology.c, built into jesd_bench with its main() renamed */
+int jesd204_topology_scan(const char *sysfs_path);
+
+int print_output_sys(void *err, const char *str, ...)
+{
+	va_list args;
+	int ret;
+
+	va_start(args, str);
+	ret = vfprintf(err, str, args);
+	va_end(args);
+
+	return ret;
+}
+
+static void bench_report(const char *name, unsigned iter,
+			 unsigned long long us, size_t bytes)
+{
+	double per_op = (double)us / iter;
+	struct bench_result *r;
+
+	printf("%-56s %6u %12.1f us/op", name, iter, per_op);
+	if (bytes && per_op > 0)
+		printf(" %10.1f MB/s", bytes / per_op);
+	printf("\n");
+
+	r = realloc(results, (num_results + 1) * sizeof(*results));
+	if (!r)
+		return;
+
+	results = r;
+	r = &results[num_results++];
+	snprintf(r->name, sizeof(r->name), "%s", name);
+	r->iter = iter;
+	r->us_per_op = per_op;
+	r->mb_s = bytes && per_op > 0 ? bytes / per_op : 0;
+}
+
+static int bench_save_json(const char *file)
+{
+	unsigned i;
+	FILE *f;
+	int ret;
+
+	f = fopen(file, "w");
+	if (f == NULL)
+		return -errno;
+
+	fprintf(f, "{\n  \"iterations\": %u,\n  \"results\": [\n", iterations);
+
+	/* Names are built from fixture and device names, no escaping needed */
+	for (i = 0; i < num_results; i++)
+		fprintf(f, "    { \"name\": \"%s\", \"iterations\": %u, "
+			"\"us_per_op\": %.3f, \"mb_per_s\": %.3f }%s\n",
+			results[i].name, results[i].iter, results[i].us_per_op,
+			results[i].mb_s, i + 1 < num_results ? "," : "");
+
+	fprintf(f, "  ]\n}\n");
+
+	ret = ferror(f) ? -EIO : 0;
+	if (fclose(f) && !ret)
+		ret = -errno;
+
+	return ret;
+}
+
+/* Synthetic DFE samples: sample count in the upper, errors in the lower half */
+static void bench_fill_samples(uint64_t *smpl, unsigned cnt)
+{
+	unsigned i;
+
+	srand(1);
+
+	for (i = 0; i < cnt; i++) {
+		uint64_t err = (i % 5) ? 0 : rand() & 0xFFFF;
+
+		smpl[i] = 0xFFFF0000FFFF0000ULL | (err << 32) | err;
+	}
+}
+
+static size_t bench_format_hex(const uint64_t *smpl, unsigned cnt, char *out)
+{
+	size_t len = 0;
+	unsigned i;
+
+	for (i = 0; i < cnt; i++)
+		len += sprintf(out + len, "%llx,", (unsigned long long)smpl[i]);
+
+	return len;
+}
+
+/* eye_data_partial decoding as done before the streaming decoder */
+static unsigned decode_strtok(const char *hex, size_t len, char *chunk,
+			      uint64_t *out, unsigned cnt)
+{
+	unsigned idx = 0;
+	size_t off, n;
+
+	for (off = 0; off < len && idx < cnt; off += n) {
+		char *saveptr = NULL, *token;
+
+		n = MIN(len - off, BENCH_CHUNK);
+		memcpy(chunk, hex + off, n);
+		chunk[n] = 0;
+
+		token = strtok_r(chunk, ",", &saveptr);
+		while (token && idx < cnt) {
+			out[idx++] = strtoull(token, NULL, 16);
+			token = strtok_r(NULL, ",", &saveptr);
+		}
+	}
+
+	return idx;
+}
+
+static unsigned decode_stream(const char *hex, size_t len, char *chunk,
+			      uint64_t *out, unsigned cnt)
+{
+	struct jesd_hex_decoder dec;
+	size_t off, n;
+
+	jesd_hex_decoder_init(&dec, out, sizeof(*out), cnt);
+
+	for (off = 0; off < len && dec.idx < cnt; off += n) {
+		n = MIN(len - off, BENCH_CHUNK);
+		memcpy(chunk, hex + off, n);
+		jesd_hex_decode(&dec, chunk, n);
+	}
+	jesd_hex_decoder_finish(&dec);
+
+	return dec.idx;
+}
+
+static int bench_hex_decode(void)
+{
+	unsigned cnt = BENCH_HSIZE * BENCH_VSIZE, i;
+	uint64_t *smpl, *out;
+	unsigned long long start;
+	char *hex, *chunk;
+	size_t len;
+	int ret = 0;
+
+	smpl = malloc(cnt * sizeof(*smpl));
+	out = malloc(cnt * sizeof(*out));
+	hex = malloc(cnt * 18 + 1);
+	chunk = malloc(BENCH_CHUNK + 1);
+	if (!smpl || !out || !hex || !chunk) {
+		ret = -1;
+		goto out;
+	}
+
+	bench_fill_samples(smpl, cnt);
+	len = bench_format_hex(smpl, cnt, hex);
+
+	start = jesd_time_us();
+	for (i = 0; i < iterations; i++)
+		decode_strtok(hex, len, chunk, out, cnt);
+	bench_report("hex_decode/strtok", iterations, jesd_time_us() - start, len);
+
+	start = jesd_time_us();
+	for (i = 0; i < iterations; i++)
+		decode_stream(hex, len, chunk, out, cnt);
+	bench_report("hex_decode/stream", iterations, jesd_time_us() - start, len);
+
+	if (memcmp(out, smpl, cnt * sizeof(*out))) {
+		fprintf(stderr, "hex_decode/stream: decoded data mismatch\n");
+		ret = -1;
+	}
+out:
+	free(smpl);
+	free(out);
+	free(hex);
+	free(chunk);
+
+	return ret;
+}
+
+/* Per point log10(calc_ber()) as plot() used to do vs. the batch kernel */
+static int bench_ber_map_one(const char *name, int lpm, const uint64_t *smpl,
+			     unsigned cnt, float *ref, float *out)
+{
+	struct jesd204b_xcvr_eyescan_info info = {
+		.es_hsize = BENCH_HSIZE,
+		.es_vsize = BENCH_VSIZE,
+		.cdr_data_width = 40,
+		.lpm = lpm,
+	};
+	const uint32_t *smpl_u32 = (const uint32_t *)smpl;
+	unsigned long long start;
+	unsigned i, j, prescale = 8;
+	char label[64];
+	float err = 0;
+
+	start = jesd_time_us();
+	for (i = 0; i < iterations; i++)
+		for (j = 0; j < cnt; j++)
+			ref[j] = log10(calc_ber(&info, lpm ? smpl_u32[j] : smpl[j],
+						prescale));
+	snprintf(label, sizeof(label), "ber_map/%s/scalar", name);
+	bench_report(label, iterations, jesd_time_us() - start,
+		     cnt * (lpm ? 4 : 8));
+
+	start = jesd_time_us();
+	for (i = 0; i < iterations; i++)
+		jesd_eye_log_ber_map(&info, prescale, smpl, cnt, out);
+	snprintf(label, sizeof(label), "ber_map/%s/batch", name);
+	bench_report(label, iterations, jesd_time_us() - start,
+		     cnt * (lpm ? 4 : 8));
+
+	for (j = 0; j < cnt; j++)
+		err = MAX(err, fabsf(out[j] - ref[j]));
+
+	if (err > 1e-4f) {
+		fprintf(stderr, "ber_map/%s: max error %g\n", name, err);
+		return -1;
+	}
+
+	return 0;
+}
+
+static int bench_ber_map(void)
+{
+	unsigned cnt = BENCH_HSIZE * BENCH_VSIZE;
+	float *ref, *out;
+	uint64_t *smpl;
+	int ret = 0;
+
+	smpl = malloc(cnt * sizeof(*smpl));
+	ref = malloc(cnt * sizeof(*ref));
+	out = malloc(cnt * sizeof(*out));
+	if (!smpl || !ref || !out) {
+		ret = -1;
+		goto out;
+	}
+
+	/* The same buffer reads as twice the LPM samples, use the first half */
+	bench_fill_samples(smpl, cnt);
+	ret |= bench_ber_map_one("dfe", 0, smpl, cnt, ref, out);
+	ret |= bench_ber_map_one("lpm", 1, smpl, cnt, ref, out);
+out:
+	free(smpl);
+	free(ref);
+	free(out);
+
+	return ret;
+}
+
+/* =================================================================== */
+/* sysfs fixture trees */
+/* =================================================================== */
+
+/*
+ * Synthetic captures of a board with one JESD204 RX link, its transceiver and
+ * the jesd204 framework topology, laid out like /sys so every tool reads them
+ * through -p PATH.
+ */
+struct bench_fixture {
+	const char *name;
+	int encoder;		/* JESD204_ENCODER_* */
+	unsigned lanes;
+	unsigned hsize;
+	unsigned vsize;
+	int lpm;
+};
+
+static const struct bench_fixture fixtures[] = {
+	{ "8b10b-l1", JESD204_ENCODER_8B10B, 1, 65, 255, 1 },
+	{ "8b10b-l4", JESD204_ENCODER_8B10B, 4, 65, 255, 1 },
+	{ "8b10b-l8", JESD204_ENCODER_8B10B, 8, 129, 255, 0 },
+	{ "8b10b-l16", JESD204_ENCODER_8B10B, 16, 129, 255, 0 },
+	{ "64b66b-l2", JESD204_ENCODER_64B66B, 2, 129, 255, 1 },
+	{ "64b66b-l8", JESD204_ENCODER_64B66B, 8, 257, 255, 0 },
+	{ "64b66b-l16", JESD204_ENCODER_64B66B, 16, 257, 255, 0 },
+	{ "64b66b-l32", JESD204_ENCODER_64B66B, 32, 257, 255, 1 },
+};
+
+#define BENCH_JESD_DEV		"84aa0000.axi-jesd204-rx"
+#define BENCH_XCVR_DEV		"84a60000.axi-adxcvr-rx"
+
+static int bench_mkdirs(const char *path)
+{
+	char temp[PATH_MAX];
+	char *p;
+
+	snprintf(temp, sizeof(temp), "%s", path);
+
+	for (p = temp + 1; *p; p++) {
+		if (*p != '/')
+			continue;
+
+		*p = '\0';
+		if (mkdir(temp, 0755) && errno != EEXIST)
+			return -errno;
+		*p = '/';
+	}
+
+	if (mkdir(temp, 0755) && errno != EEXIST)
+		return -errno;
+
+	return 0;
+}
+
+static int bench_write_attr(const char *dir, const char *attr,
+			    const char *fmt, ...)
+{
+	char temp[PATH_MAX];
+	va_list args;
+	FILE *f;
+	int ret;
+
+	snprintf(temp, sizeof(temp), "%s/%s", dir, attr);
+	f = fopen(temp, "w");
+	if (f == NULL)
+		return -errno;
+
+	va_start(args, fmt);
+	vfprintf(f, fmt, args);
+	va_end(args);
+
+	ret = ferror(f) ? -EIO : 0;
+	if (fclose(f) && !ret)
+		ret = -errno;
+
+	return ret;
+}
+
+/* @dev under sys/devices, linked from sys/bus/<bus>/<name> like sysfs does */
+static int bench_add_device(const char *prefix, const char *bus,
+			    const char *dev, char *path)
+{
+	char temp[PATH_MAX], target[PATH_MAX] = "../";
+	const char *p;
+	int ret;
+
+	snprintf(path, PATH_MAX, "%s/sys/devices/%s", prefix, dev);
+	ret = bench_mkdirs(path);
+	if (ret)
+		return ret;
+
+	snprintf(temp, sizeof(temp), "%s/sys/bus/%s", prefix, bus);
+	ret = bench_mkdirs(temp);
+	if (ret)
+		return ret;
+
+	/* Relative like in sysfs, one ../ per level below sys/ */
+	for (p = bus; *p; p++)
+		if (*p == '/')
+			strcat(target, "../");
+	snprintf(target + strlen(target), sizeof(target) - strlen(target),
+		 "../devices/%s", dev);
+
+	snprintf(temp, sizeof(temp), "%s/sys/bus/%s/%s", prefix, bus,
+		 strrchr(dev, '/') ? strrchr(dev, '/') + 1 : dev);
+
+	if (symlink(target, temp) && errno != EEXIST)
+		return -errno;
+
+	return 0;
+}
+
+static int bench_add_jesd(const char *prefix, const struct bench_fixture *fx)
+{
+	char path[PATH_MAX], attr[32];
+	int c = fx->encoder == JESD204_ENCODER_64B66B;
+	unsigned i;
+	int ret;
+
+	ret = bench_add_device(prefix, "platform/drivers/" JESD204_RX_DRIVER_NAME,
+			       "platform/axi/" BENCH_JESD_DEV, path);
+	if (ret)
+		return ret;
+
+	ret = bench_write_attr(path, "encoder", c ? "64b66b\n" : "8b10b\n");
+	if (ret)
+		return ret;
+
+	if (c)
+		ret = bench_write_attr(path, "status",
+			"Link is enabled\n"
+			"Measured Link Clock: 250.000 MHz\n"
+			"Reported Link Clock: 250.000 MHz\n"
+			"Measured Device Clock: 250.001 MHz\n"
+			"Reported Device Clock: 250.000 MHz\n"
+			"Desired Device Clock: 250.000 MHz\n"
+			"Lane rate: 16500.000 MHz\n"
+			"Lane rate / 66: 250.000 MHz\n"
+			"LEMC rate: 7.812 MHz\n"
+			"Link status: DATA\n"
+			"SYSREF captured: Yes\n"
+			"SYSREF alignment error: No\n");
+	else
+		ret = bench_write_attr(path, "status",
+			"Link is enabled\n"
+			"Measured Link Clock: 245.761 MHz\n"
+			"Reported Link Clock: 245.760 MHz\n"
+			"Lane rate: 9830.400 MHz\n"
+			"Lane rate / 40: 245.760 MHz\n"
+			"LMFC rate: 7.680 MHz\n"
+			"Link status: DATA\n"
+			"SYSREF captured: Yes\n"
+			"SYSREF alignment error: No\n");
+	if (ret)
+		return ret;
+
+	for (i = 0; i < fx->lanes && !ret; i++) {
+		snprintf(attr, sizeof(attr), "lane%u_info", i);
+
+		if (c)
+			ret = bench_write_attr(path, attr,
+				"Errors: %u\n"
+				"State of Extended multiblock alignment:EMB_LOCK\n"
+				"Lane Latency: %u (min/max 40/44)\n",
+				i % 3, 40 + i % 5);
+		else
+			ret = bench_write_attr(path, attr,
+				"Errors: %u\n"
+				"CGS state: DATA\n"
+				"Initial Frame Synchronization: Yes\n"
+				"Lane Latency: 1 Multi-frames and %u Octets\n"
+				"Initial Lane Alignment Sequence: Yes\n"
+				"DID: 0, BID: 0, LID: %u, L: %u, SCR: 1, F: 4\n"
+				"K: 32, M: %u, N: 16, CS: 0, N': 16, S: 1, HD: 0\n"
+				"FCHK: 0x%X, CF: 0\n"
+				"ADJCNT: 0, PHADJ: 0, ADJDIR: 0, JESDV: 1, SUBCLASS: 1\n"
+				"FC: 9830400\n",
+				i % 3, 60 + i % 5, i, fx->lanes, 2 * fx->lanes,
+				(0x3C + i) & 0xFF);
+	}
+
+	return ret;
+}
+
+/* Errors rise towards the edges of an open eye around the center */
+static unsigned bench_eye_errors(unsigned x, unsigned y,
+				 const struct bench_fixture *fx)
+{
+	double dx = fabs(2.0 * x / (fx->hsize - 1) - 1) / 0.6;
+	double dy = fabs(2.0 * y / (fx->vsize - 1) - 1) / 0.7;
+	double d = MAX(dx, dy);
+
+	if (d < 1)
+		return 0;
+
+	return MIN((d - 1) * 40000 + 1, 0xFFFF);
+}
+
+static int bench_add_xcvr(const char *prefix, const struct bench_fixture *fx)
+{
+	size_t elem_size = fx->lpm ? 4 : 8;
+	unsigned x, y, i = 0;
+	char path[PATH_MAX], temp[PATH_MAX];
+	uint64_t smpl;
+	uint32_t err;
+	void *data;
+	FILE *f;
+	int ret;
+
+	ret = bench_add_device(prefix, "platform/drivers/" XCVR_DRIVER_NAME,
+			       BENCH_XCVR_DEV, path);
+	if (ret)
+		return ret;
+
+	ret = bench_write_attr(path, "eyescan_info",
+			       "x%u,y%u CDRDW: 40 LPM: %d NL: %u LR: %u\n",
+			       fx->hsize, fx->vsize, fx->lpm, fx->lanes,
+			       fx->encoder == JESD204_ENCODER_64B66B ?
+			       16500000 : 9830400);
+	ret = ret ? ret : bench_write_attr(path, "prescale", "0\n");
+	ret = ret ? ret : bench_write_attr(path, "enable", "0\n");
+	ret = ret ? ret : bench_write_attr(path, "eye_data_available", "1\n");
+	if (ret)
+		return ret;
+
+	data = malloc((size_t)fx->hsize * fx->vsize * elem_size);
+	if (!data)
+		return -ENOMEM;
+
+	for (y = 0; y < fx->vsize; y++)
+		for (x = 0; x < fx->hsize; x++) {
+			err = 0xFFFF0000 | bench_eye_errors(x, y, fx);
+			smpl = (uint64_t)err << 32 | err;
+
+			if (fx->lpm)
+				((uint32_t *)data)[i++] = err;
+			else
+				((uint64_t *)data)[i++] = smpl;
+		}
+
+	if (snprintf(temp, sizeof(temp), "%s/%s", path,
+		     JESD204B_EYE_DATA) >= (int)sizeof(temp)) {
+		ret = -ENAMETOOLONG;
+		goto out;
+	}
+
+	f = fopen(temp, "w");
+	if (f == NULL) {
+		ret = -errno;
+		goto out;
+	}
+
+	if (fwrite(data, elem_size, i, f) != i)
+		ret = -EIO;
+	if (fclose(f) && !ret)
+		ret = -errno;
+out:
+	free(data);
+
+	return ret;
+}
+
+static int bench_topo_con(const char *path, const char *dir, unsigned idx,
+			  const char *to, unsigned link_id)
+{
+	char attr[32];
+	int ret;
+
+	snprintf(attr, sizeof(attr), "%s%u_to", dir, idx);
+	ret = bench_write_attr(path, attr, "%s\n", to);
+	snprintf(attr, sizeof(attr), "%s%u_id", dir, idx);
+	ret = ret ? ret : bench_write_attr(path, attr, "%u\n", idx);
+	snprintf(attr, sizeof(attr), "%s%u_topo_id", dir, idx);
+	ret = ret ? ret : bench_write_attr(path, attr, "0\n");
+	snprintf(attr, sizeof(attr), "%s%u_link_id", dir, idx);
+	ret = ret ? ret : bench_write_attr(path, attr, "%u\n", link_id);
+	snprintf(attr, sizeof(attr), "%s%u_state", dir, idx);
+	ret = ret ? ret : bench_write_attr(path, attr, "opt_post_running_stage\n");
+	snprintf(attr, sizeof(attr), "%s%u_error", dir, idx);
+	ret = ret ? ret : bench_write_attr(path, attr, "0\n");
+
+	return ret;
+}
+
+static int bench_topo_link(const char *path, unsigned idx, unsigned link_id,
+			   int tx, const struct bench_fixture *fx)
+{
+	int c = fx->encoder == JESD204_ENCODER_64B66B;
+	const struct {
+		const char *attr;
+		unsigned long long val;
+	} attrs[] = {
+		{ "link_id", link_id },
+		{ "error", 0 },
+		{ "fsm_paused", 0 },
+		{ "fsm_ignore_errors", 0 },
+		{ "sample_rate", c ? 250000000 : 245760000 },
+		{ "sample_rate_div", 1 },
+		{ "is_transmit", tx },
+		{ "num_lanes", fx->lanes },
+		{ "num_converters", 2 * fx->lanes },
+		{ "octets_per_frame", 4 },
+		{ "frames_per_multiframe", 32 },
+		{ "num_of_multiblocks_in_emb", c },
+		{ "bits_per_sample", 16 },
+		{ "converter_resolution", 16 },
+		{ "jesd_version", c ? 2 : 1 },
+		{ "jesd_encoder", c ? 2 : 1 },	/* 64B66B : 8B10B */
+		{ "subclass", 1 },
+		{ "device_id", 0 },
+		{ "bank_id", 0 },
+		{ "scrambling", 1 },
+		{ "high_density", 0 },
+		{ "ctrl_words_per_frame_clk", 0 },
+		{ "ctrl_bits_per_sample", 0 },
+		{ "samples_per_conv_frame", 1 },
+	};
+	char attr[64];
+	unsigned i;
+	int ret;
+
+	snprintf(attr, sizeof(attr), "link%u_state", idx);
+	ret = bench_write_attr(path, attr, "opt_post_running_stage\n");
+
+	for (i = 0; i < ARRAY_SIZE(attrs) && !ret; i++) {
+		snprintf(attr, sizeof(attr), "link%u_%s", idx, attrs[i].attr);
+		ret = bench_write_attr(path, attr, "%llu\n", attrs[i].val);
+	}
+
+	return ret;
+}
+
+/*
+ * hmc7044 -> axi-adxcvr -> axi-jesd204 -> axi-ad9081-hpc -> ad9081 for the
+ * TX (link 0) and RX (link 2) paths, as on an AD9081 evaluation board.
+ */
+static int bench_add_topology(const char *prefix, const struct bench_fixture *fx)
+{
+	static const char *const chain[] = {
+		"axi-adxcvr-%s@8", "axi-jesd204-%s@8", "axi-ad9081-%s-hpc@8",
+	};
+	static const char *const dirs[] = { "tx", "rx" };
+	char path[PATH_MAX], dev[32], name[3][2][32];
+	unsigned d, i, n = 0;
+	int ret;
+
+	for (d = 0; d < 2; d++)
+		for (i = 0; i < ARRAY_SIZE(chain); i++)
+			snprintf(name[i][d], sizeof(name[i][d]), chain[i], dirs[d]);
+
+	snprintf(dev, sizeof(dev), "jesd204:%u", n++);
+	ret = bench_add_device(prefix, "jesd204/devices", dev, path);
+	ret = ret ? ret : bench_write_attr(path, "name", "hmc7044@0\n");
+	ret = ret ? ret : bench_topo_con(path, "out", 0, name[0][0], 0);
+	ret = ret ? ret : bench_topo_con(path, "out", 1, name[0][1], 2);
+
+	for (d = 0; d < 2 && !ret; d++)
+		for (i = 0; i < ARRAY_SIZE(chain) && !ret; i++) {
+			snprintf(dev, sizeof(dev), "jesd204:%u", n++);
+			ret = bench_add_device(prefix, "jesd204/devices", dev, path);
+			ret = ret ? ret : bench_write_attr(path, "name", "%s\n",
+							   name[i][d]);
+			ret = ret ? ret : bench_topo_con(path, "in", 0,
+							 i ? name[i - 1][d] : "hmc7044@0",
+							 d * 2);
+			ret = ret ? ret : bench_topo_con(path, "out", 0,
+							 i + 1 < ARRAY_SIZE(chain) ?
+							 name[i + 1][d] : "ad9081@0",
+							 d * 2);
+		}
+
+	snprintf(dev, sizeof(dev), "jesd204:%u", n++);
+	ret = ret ? ret : bench_add_device(prefix, "jesd204/devices", dev, path);
+	ret = ret ? ret : bench_write_attr(path, "name", "ad9081@0\n");
+	ret = ret ? ret : bench_write_attr(path, "num_links", "2\n");
+	ret = ret ? ret : bench_write_attr(path, "topology_id", "0\n");
+	ret = ret ? ret : bench_write_attr(path, "num_retries", "3\n");
+	ret = ret ? ret : bench_topo_link(path, 0, 0, 1, fx);
+	ret = ret ? ret : bench_topo_link(path, 1, 2, 0, fx);
+	ret = ret ? ret : bench_topo_con(path, "in", 0, name[2][0], 0);
+	ret = ret ? ret : bench_topo_con(path, "in", 1, name[2][1], 2);
+
+	return ret;
+}
+
+static int bench_fixtures_create(const char *dir)
+{
+	char prefix[PATH_MAX];
+	unsigned i;
+	int ret = 0;
+
+	for (i = 0; i < ARRAY_SIZE(fixtures) && !ret; i++) {
+		snprintf(prefix, sizeof(prefix), "%s/%s", dir, fixtures[i].name);
+
+		ret = bench_add_jesd(prefix, &fixtures[i]);
+		ret = ret ? ret : bench_add_xcvr(prefix, &fixtures[i]);
+		ret = ret ? ret : bench_add_topology(prefix, &fixtures[i]);
+	}
+
+	if (ret)
+		fprintf(stderr, "Failed to create fixture %s: %s\n", prefix,
+			strerror(-ret));
+
+	return ret;
+}
+
+static int bench_remove_cb(const char *path, const struct stat *sb, int flag,
+			   struct FTW *ftw)
+{
+	(void)sb;
+	(void)flag;
+	(void)ftw;
+
+	return remove(path);
+}
+
+/* =================================================================== */
+/* sysfs benchmarks */
+/* =================================================================== */
+
+static int bench_jesd(const char *name, const char *path, const char *dev)
+{
+	struct jesd204b_laneinfo lane_info[MAX_LANES];
+	struct jesd204b_jesd204_status status;
+	unsigned long long start;
+	char label[BENCH_NAME_LEN];
+	unsigned i;
+	int lanes;
+
+	lanes = read_all_laneinfo(path, lane_info);
+	if (lanes < 0 || read_jesd204_status(path, &status) < 0) {
+		fprintf(stderr, "%s: failed to read %s\n", name, path);
+		return -1;
+	}
+
+	start = jesd_time_us();
+	for (i = 0; i < iterations; i++)
+		read_all_laneinfo(path, lane_info);
+	snprintf(label, sizeof(label), "%s/read_all_laneinfo/%s", name, dev);
+	bench_report(label, iterations, jesd_time_us() - start, 0);
+
+	start = jesd_time_us();
+	for (i = 0; i < iterations; i++)
+		read_jesd204_status(path, &status);
+	snprintf(label, sizeof(label), "%s/read_jesd204_status/%s", name, dev);
+	bench_report(label, iterations, jesd_time_us() - start, 0);
+
+	return 0;
+}
+
+static int bench_xcvr(const char *name, char *path, const char *dev)
+{
+	struct jesd204b_xcvr_eyescan_info info = { 0 };
+	unsigned long long start, smpl;
+	char label[BENCH_NAME_LEN];
+	unsigned cnt, i, j;
+	volatile double ber = 0;
+	void *data = NULL;
+	size_t size;
+	int ret;
+
+	ret = read_eyescan_info(path, &info);
+	if (!ret)
+		ret = get_eye_data(&info, JESD204B_EYE_DATA, path, 0, NULL, &data);
+	if (ret) {
+		fprintf(stderr, "%s: failed to read eye data of %s\n", name, path);
+		return -1;
+	}
+
+	cnt = info.es_hsize * info.es_vsize;
+	size = cnt * (info.lpm ? 4 : 8);
+	free(data);
+
+	start = jesd_time_us();
+	for (i = 0; i < iterations; i++) {
+		get_eye_data(&info, JESD204B_EYE_DATA, path, 0, NULL, &data);
+		free(data);
+	}
+	snprintf(label, sizeof(label), "%s/get_eye_data/%s", name, dev);
+	bench_report(label, iterations, jesd_time_us() - start, size);
+
+	ret = get_eye_data(&info, JESD204B_EYE_DATA, path, 0, NULL, &data);
+	if (ret)
+		return -1;
+
+	start = jesd_time_us();
+	for (i = 0; i < iterations; i++)
+		for (j = 0; j < cnt; j++) {
+			smpl = info.lpm ? ((uint32_t *)data)[j] : ((uint64_t *)data)[j];
+			ber += calc_ber(&info, smpl, 0);
+		}
+	snprintf(label, sizeof(label), "%s/calc_ber/%ux%u", name, info.es_hsize,
+		 info.es_vsize);
+	bench_report(label, iterations, jesd_time_us() - start, size);
+	free(data);
+
+	return 0;
+}
+
+static int bench_topology(const char *name, const char *path)
+{
+	unsigned long long start;
+	char label[BENCH_NAME_LEN];
+	unsigned i;
+
+	if (jesd204_topology_scan(path) <= 0) {
+		fprintf(stderr, "%s: no jesd204 devices in %s\n", name, path);
+		return -1;
+	}
+
+	start = jesd_time_us();
+	for (i = 0; i < iterations; i++)
+		jesd204_topology_scan(path);
+	snprintf(label, sizeof(label), "%s/scan_devices", name);
+	bench_report(label, iterations, jesd_time_us() - start, 0);
+
+	return 0;
+}
+
+/* One captured board, @prefix/sys/... */
+static int bench_tree(const char *prefix, const char *name)
+{
+	char devices[MAX_DEVICES][PATH_MAX];
+	char basedir[PATH_MAX];
+	struct stat st;
+	int i, num, ret = 0;
+	char *path;
+
+	snprintf(basedir, sizeof(basedir), "%s/sys/bus/platform/drivers", prefix);
+
+	num = jesd_find_devices(basedir, JESD204_RX_DRIVER_NAME, "status", devices, 0);
+
+	/* Captures of RX only designs have no TX driver directory */
+	path = get_full_device_path(basedir, JESD204_TX_DRIVER_NAME);
+	if (path && !stat(path, &st))
+		num = jesd_find_devices(basedir, JESD204_TX_DRIVER_NAME, "status",
+					devices, num);
+	free(path);
+
+	for (i = 0; i < num; i++) {
+		path = get_full_device_path(basedir, devices[i]);
+		if (!path)
+			return -1;
+
+		ret |= bench_jesd(name, path, strrchr(devices[i], '/') + 1);
+		free(path);
+	}
+
+	num = jesd_find_xcvr_devices(basedir, devices);
+	for (i = 0; i < num; i++) {
+		path = get_full_device_path(basedir, devices[i]);
+		if (!path)
+			return -1;
+
+		ret |= bench_xcvr(name, path, strrchr(devices[i], '/') + 1);
+		free(path);
+	}
+
+	path = get_full_device_path(prefix, "sys/bus/jesd204/devices");
+	if (path && !stat(path, &st))
+		ret |= bench_topology(name, path);
+	free(path);
+
+	return ret;
+}
+
+/* Either a single capture (@path/sys exists) or a directory of them */
+static int bench_trees(const char *path)
+{
+	char prefix[PATH_MAX], name[PATH_MAX];
+	struct dirent **list;
+	struct stat st;
+	int i, num, ret = 0;
+
+	snprintf(prefix, sizeof(prefix), "%s/sys", path);
+	if (!stat(prefix, &st)) {
+		snprintf(name, sizeof(name), "%s", path);
+		return bench_tree(path, basename(name));
+	}
+
+	num = scandir(path, &list, NULL, versionsort);
+	if (num < 0) {
+		fprintf(stderr, "Failed to open %s: %s\n", path, strerror(errno));
+		return -1;
+	}
+
+	for (i = 0; i < num; i++) {
+		snprintf(prefix, sizeof(prefix), "%s/%s/sys", path, list[i]->d_name);
+		if (list[i]->d_name[0] != '.' && !stat(prefix, &st)) {
+			snprintf(prefix, sizeof(prefix), "%s/%s", path,
+				 list[i]->d_name);
+			ret |= bench_tree(prefix, list[i]->d_name);
+		}
+		free(list[i]);
+	}
+	free(list);
+
+	return ret;
+}
+
+int main(int argc, char *argv[])
+{
+	char tmpdir[] = "/tmp/jesd_bench.XXXXXX";
+	const char *path = NULL, *gen = NULL, *json = NULL;
+	int c, ret = 0;
+
+	opterr = 0;
+
+	while ((c = getopt(argc, argv, "n:p:g:j:")) != -1)
+		switch (c) {
+		case 'n':
+			iterations = strtoul(optarg, NULL, 0);
+			if (!iterations)
+				iterations = 1;
+			break;
+		case 'p':
+			path = optarg;
+			break;
+		case 'g':
+			gen = optarg;
+			break;
+		case 'j':
+			json = optarg;
+			break;
+		case '?':
+			if (strchr("npgj", optopt))
+				fprintf(stderr, "Option -%c requires an argument.\n", optopt);
+			else if (isprint(optopt))
+				fprintf(stderr, "Unknown option `-%c'.\n"
+					"%s [-n ITERATIONS] [-p PATH] [-g DIR] [-j JSON]\n",
+					optopt, argv[0]);
+			else
+				fprintf(stderr, "Unknown option character `\\x%x'.\n", optopt);
+
+			return 1;
+
+		default:
+			abort();
+		}
+
+	if (gen)
+		return bench_fixtures_create(gen) ? EXIT_FAILURE : EXIT_SUCCESS;
+
+	ret |= bench_hex_decode();
+	ret |= bench_ber_map();
+
+	/* Without -p run on fixtures generated for this run only */
+	if (!path) {
+		path = mkdtemp(tmpdir);
+		if (!path || bench_fixtures_create(path)) {
+			fprintf(stderr, "Failed to create fixtures in %s\n", tmpdir);
+			return EXIT_FAILURE;
+		}
+	}
+
+	ret |= bench_trees(path);
+
+	if (path == tmpdir)
+		nftw(tmpdir, bench_remove_cb, 16, FTW_DEPTH | FTW_PHYS);
+
+	if (json && bench_save_json(json)) {
+		fprintf(stderr, "Failed to write %s\n", json);
+		ret = -1;
+	}
+
+	free(results);
+
+	return ret ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -17,10 +17,17 @@
 #include <ctype.h>
 #include <string.h>
 #include <errno.h>
+#include <stddef.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <time.h>
+#include <pthread.h>
 #include <sys/stat.h>
 
 #include "jesd_common.h"
 
+#define JESD_ATTR_BUF_SIZE	4096	/* One sysfs page */
+
 char *get_full_device_path(const char *basedir, const char *device)
 {
 	char *path = malloc(PATH_MAX);
@@ -42,6 +49,9 @@ int jesd_find_devices(const char *basedir, const char *driver, const char *file_
 	DIR *dr;
 	int num = start, use = 1;
 
+	if (jesd_backend_path(basedir))
+		return g_jesd_attr_backend->find_devices(driver, devices, start);
+
 	snprintf(path, sizeof(path), "%s/%s", basedir, driver);
 	dr = opendir(path);
 	if (dr == NULL) {
@@ -127,88 +137,296 @@ int read_encoding(const char *basedir)
 	return ret;
 }
 
-int read_laneinfo(const char *basedir, unsigned lane,
-		  struct jesd204b_laneinfo *info)
+/* =================================================================== */
+/* status and laneN_info parser, shared by sysfs and libiio */
+/* =================================================================== */
+
+/*
+ * Single pass over the attribute text without stdio. Every line starts with a
+ * key from the tables below, lines like "DID: 0, BID: 0, ..." carry several
+ * comma separated keys. Lines without a known key are skipped.
+ */
+enum jesd_field_type {
+	JESD_FIELD_UINT,	/* decimal or 0x hex */
+	JESD_FIELD_ULONG,
+	JESD_FIELD_STR,		/* first word */
+	JESD_FIELD_LATENCY,	/* 8b10b or 64b66b lane latency */
+};
+
+struct jesd_field {
+	const char *key;	/* up to and including the delimiter */
+	unsigned char len;
+	unsigned char type;
+	unsigned short offset;
+};
+
+#define JESD_FIELD(k, t, s, m)	{ k, sizeof(k) - 1, JESD_FIELD_##t, offsetof(s, m) }
+#define LANE_FIELD(k, t, m)	JESD_FIELD(k, t, struct jesd204b_laneinfo, m)
+#define STATUS_FIELD(k, m)	JESD_FIELD(k, STR, struct jesd204b_jesd204_status, m)
+
+static const struct jesd_field laneinfo_fields[] = {
+	LANE_FIELD("Errors:", UINT, lane_errors),
+	LANE_FIELD("CGS state:", STR, cgs_state),
+	LANE_FIELD("Initial Frame Synchronization:", STR, init_frame_sync),
+	LANE_FIELD("Lane Latency:", LATENCY, lane_latency_octets),
+	LANE_FIELD("Initial Lane Alignment Sequence:", STR, init_lane_align_seq),
+	LANE_FIELD("State of Extended multiblock alignment:", STR,
+		   ext_multiblock_align_state),
+	LANE_FIELD("DID:", UINT, did),
+	LANE_FIELD("BID:", UINT, bid),
+	LANE_FIELD("LID:", UINT, lid),
+	LANE_FIELD("L:", UINT, l),
+	LANE_FIELD("SCR:", UINT, scr),
+	LANE_FIELD("F:", UINT, f),
+	LANE_FIELD("K:", UINT, k),
+	LANE_FIELD("M:", UINT, m),
+	LANE_FIELD("N:", UINT, n),
+	LANE_FIELD("CS:", UINT, cs),
+	LANE_FIELD("N':", UINT, nd),
+	LANE_FIELD("S:", UINT, s),
+	LANE_FIELD("HD:", UINT, hd),
+	LANE_FIELD("FCHK:", UINT, fchk),
+	LANE_FIELD("CF:", UINT, cf),
+	LANE_FIELD("ADJCNT:", UINT, adjcnt),
+	LANE_FIELD("PHADJ:", UINT, phyadj),
+	LANE_FIELD("ADJDIR:", UINT, adjdir),
+	LANE_FIELD("JESDV:", UINT, jesdv),
+	LANE_FIELD("SUBCLASS:", UINT, subclassv),
+	LANE_FIELD("FC:", ULONG, fc),
+};
+
+static const struct jesd_field status_fields[] = {
+	STATUS_FIELD("Link is ", link_state),
+	STATUS_FIELD("Measured Link Clock:", measured_link_clock),
+	STATUS_FIELD("Reported Link Clock:", reported_link_clock),
+	STATUS_FIELD("Measured Device Clock:", measured_device_clock),
+	STATUS_FIELD("Reported Device Clock:", reported_device_clock),
+	STATUS_FIELD("Desired Device Clock:", desired_device_clock),
+	STATUS_FIELD("Lane rate:", lane_rate),
+	STATUS_FIELD("Lane rate / 40:", lane_rate_div),
+	STATUS_FIELD("Lane rate / 66:", lane_rate_div),
+	STATUS_FIELD("LMFC rate:", lmfc_rate),
+	STATUS_FIELD("LEMC rate:", lmfc_rate),
+	STATUS_FIELD("SYNC~:", sync_state),
+	STATUS_FIELD("Link status:", link_status),
+	STATUS_FIELD("SYSREF captured:", sysref_captured),
+	STATUS_FIELD("SYSREF alignment error:", sysref_alignment_error),
+	STATUS_FIELD("External reset is ", external_reset),
+};
+
+static const char *jesd_skip_blank(const char *p)
 {
-	FILE *pFile;
-	char temp[PATH_MAX];
-	int ret = 0;
-	int encoder = read_encoding(basedir);
+	while (*p == ' ' || *p == '\t')
+		p++;
+
+	return p;
+}
+
+/* Returns @p unchanged if there is no number */
+static const char *jesd_parse_uint(const char *p, unsigned long *val)
+{
+	unsigned long v = 0;
+	unsigned d;
+
+	if (p[0] == '0' && (p[1] == 'x' || p[1] == 'X') && isxdigit((unsigned char)p[2])) {
+		for (p += 2; isxdigit((unsigned char)*p); p++) {
+			d = *p <= '9' ? *p - '0' : (*p | 0x20) - 'a' + 10;
+			v = v * 16 + d;
+		}
+	} else {
+		for (; *p >= '0' && *p <= '9'; p++)
+			v = v * 10 + *p - '0';
+	}
+
+	*val = v;
+
+	return p;
+}
 
-	if (encoder < 0)
-		return encoder;
+/* Next number on the current line */
+static const char *jesd_next_uint(const char *p, unsigned long *val)
+{
+	while (*p && *p != '\n' && !(*p >= '0' && *p <= '9'))
+		p++;
+
+	return jesd_parse_uint(p, val);
+}
+
+/*
+ * 8b10b: "1 Multi-frames and 65 Octets"
+ * 64b66b: "42 (min/max 40/44)"
+ */
+static const char *jesd_parse_latency(const char *p,
+				      struct jesd204b_laneinfo *info)
+{
+	unsigned long a, b, c;
 
+	p = jesd_parse_uint(p, &a);
+	p = jesd_skip_blank(p);
+
+	if (*p == '(') {
+		p = jesd_next_uint(p, &b);
+		p = jesd_next_uint(p, &c);
+		info->lane_latency_octets = a;
+		info->lane_latency_min = b;
+		info->lane_latency_max = c;
+	} else {
+		p = jesd_next_uint(p, &b);
+		info->lane_latency_multiframes = a;
+		info->lane_latency_octets = b;
+	}
+
+	return p;
+}
+
+static const struct jesd_field *jesd_find_field(const char *p,
+						const struct jesd_field *fields,
+						unsigned num)
+{
+	unsigned i;
+
+	for (i = 0; i < num; i++)
+		if (p[0] == fields[i].key[0] &&
+		    !strncmp(p, fields[i].key, fields[i].len))
+			return &fields[i];
+
+	return NULL;
+}
+
+static int jesd_parse_fields(const char *buf, const struct jesd_field *fields,
+			     unsigned num, void *out)
+{
+	const struct jesd_field *f;
+	const char *p = buf, *v;
+	unsigned long val;
+	char *str;
+	int found = 0;
+	unsigned i;
+
+	while (*p) {
+		p = jesd_skip_blank(p);
+		f = jesd_find_field(p, fields, num);
+
+		if (f) {
+			v = jesd_skip_blank(p + f->len);
+
+			switch (f->type) {
+			case JESD_FIELD_UINT:
+			case JESD_FIELD_ULONG:
+				p = jesd_parse_uint(v, &val);
+				if (p == v)
+					break;
+
+				if (f->type == JESD_FIELD_UINT)
+					*(unsigned *)((char *)out + f->offset) = val;
+				else
+					*(unsigned long *)((char *)out + f->offset) = val;
+				found++;
+				break;
+			case JESD_FIELD_STR:
+				str = (char *)out + f->offset;
+				for (i = 0; i < MAX_SYSFS_STRING_SIZE - 1 &&
+				     v[i] && !isspace((unsigned char)v[i]); i++)
+					str[i] = v[i];
+				str[i] = '\0';
+				p = v + i;
+				found += i > 0;
+				break;
+			case JESD_FIELD_LATENCY:
+				p = jesd_parse_latency(v, out);
+				found++;
+				break;
+			}
+		}
+
+		/* Next key on this line, or the next line */
+		while (*p && *p != '\n' && *p != ',')
+			p++;
+		if (*p)
+			p++;
+	}
+
+	return found;
+}
+
+/* Parses the text of laneN_info, returns the number of fields found */
+int jesd_parse_laneinfo(const char *buf, struct jesd204b_laneinfo *info)
+{
 	memset(info, 0, sizeof(*info));
 
-	snprintf(temp, sizeof(temp), "%s/lane%d_info", basedir, lane);
+	return jesd_parse_fields(buf, laneinfo_fields,
+				 ARRAY_SIZE(laneinfo_fields), info);
+}
 
-	pFile = fopen(temp, "r");
+/* Parses the text of status, returns the number of fields found */
+int jesd_parse_jesd204_status(const char *buf,
+			      struct jesd204b_jesd204_status *info)
+{
+	int ret;
 
-	if (pFile == NULL)
-		return -errno;
+	memset(info, 0, sizeof(*info));
 
-	ret = fscanf(pFile, "Errors: %u\n", &info->lane_errors);
-	if (encoder == JESD204_ENCODER_64B66B) {
-
-
-		ret += fscanf(pFile, "State of Extended multiblock alignment:%s\n",
-			      (char *)&info->ext_multiblock_align_state);
-		/* Optional field - ignore if not present */
-		int latency_ret = fscanf(pFile, "Lane Latency: %u (min/max %u/%u)\n",
-		       &info->lane_latency_octets,
-		       &info->lane_latency_min, &info->lane_latency_max);
-		(void)latency_ret; /* Suppress unused variable warning */
-
-		goto close_f;
-	};
-	ret += fscanf(pFile, "CGS state: %s\n", (char *)&info->cgs_state);
-	ret += fscanf(pFile, "Initial Frame Synchronization: %s\n",
-		      (char *)&info->init_frame_sync);
-	ret += fscanf(pFile, "Lane Latency: %d Multi-frames and %d Octets\n",
-		      &info->lane_latency_multiframes, &info->lane_latency_octets);
-	ret += fscanf(pFile, "Initial Lane Alignment Sequence: %s\n",
-		      (char *)&info->init_lane_align_seq);
-
-	ret += fscanf(pFile,
-		      "DID: %d, BID: %d, LID: %d, L: %d, SCR: %d, F: %d\n",
-		      &info->did,
-		      &info->bid,
-		      &info->lid,
-		      &info->l,
-		      &info->scr, &info->f);
-
-	if (ret <= 0) {
-		int saved_errno = errno;
-		fclose(pFile);
-		return -saved_errno;
-	}
-
-	ret += fscanf(pFile,
-		      "K: %d, M: %d, N: %d, CS: %d, N': %d, S: %d, HD: %d\n",
-		      &info->k,
-		      &info->m,
-		      &info->n,
-		      &info->cs,
-		      &info->nd,
-		      &info->s, &info->hd);
-
-	ret += fscanf(pFile, "FCHK: 0x%X, CF: %d\n",
-		      &info->fchk, &info->cf);
-
-	ret += fscanf(pFile,
-		      "ADJCNT: %d, PHADJ: %d, ADJDIR: %d, JESDV: %d, SUBCLASS: %d\n",
-		      &info->adjcnt,
-		      &info->phyadj,
-		      &info->adjdir,
-		      &info->jesdv, &info->subclassv);
-
-	ret += fscanf(pFile, "FC: %lu\n", &info->fc);
-close_f:
-	fclose(pFile);
+	ret = jesd_parse_fields(buf, status_fields,
+				ARRAY_SIZE(status_fields), info);
+
+	/* Device clocks are only reported by newer cores */
+	if (!info->measured_device_clock[0])
+		strcpy(info->measured_device_clock, "N/A");
+	if (!info->reported_device_clock[0])
+		strcpy(info->reported_device_clock, "N/A");
+	if (!info->desired_device_clock[0])
+		strcpy(info->desired_device_clock, "N/A");
 
 	return ret;
 }
 
+/* Reads a whole sysfs attribute into @buf, NUL terminated */
+static int jesd_read_file(const char *path, char *buf, size_t len)
+{
+	ssize_t ret;
+	size_t pos = 0;
+	int fd;
+
+	fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return -errno;
+
+	while (pos < len - 1) {
+		ret = read(fd, buf + pos, len - 1 - pos);
+		if (ret < 0) {
+			ret = -errno;
+			close(fd);
+			return ret;
+		}
+
+		if (!ret)
+			break;
+
+		pos += ret;
+	}
+
+	close(fd);
+	buf[pos] = '\0';
+
+	return pos;
+}
+
+int read_laneinfo(const char *basedir, unsigned lane,
+		  struct jesd204b_laneinfo *info)
+{
+	char temp[PATH_MAX];
+	char buf[JESD_ATTR_BUF_SIZE];
+	int ret;
+
+	snprintf(temp, sizeof(temp), "%s/lane%d_info", basedir, lane);
+
+	ret = jesd_read_file(temp, buf, sizeof(buf));
+	if (ret < 0)
+		return ret;
+
+	return jesd_parse_laneinfo(buf, info);
+}
+
 int read_all_laneinfo(const char *path, struct jesd204b_laneinfo lane_info[MAX_LANES])
 {
 	struct stat buf;
@@ -236,98 +454,38 @@ int read_all_laneinfo(const char *path, struct jesd204b_laneinfo lane_info[MAX_L
 	return cnt;
 }
 
-void set_not_availabe(char *str)
-{
-	str[0] = 'N';
-	str[1] = '/';
-	str[2] = 'A';
-	str[3] = 0;
-}
-
 int read_jesd204_status(const char *basedir,
 			struct jesd204b_jesd204_status *info)
 {
-	FILE *pFile;
 	char temp[PATH_MAX];
-	long pos;
-	int ret = 0;
-	int encoder = read_encoding(basedir);
-
-	if (encoder < 0)
-		return encoder;
+	char buf[JESD_ATTR_BUF_SIZE];
+	int ret;
 
 	snprintf(temp, sizeof(temp), "%s/status", basedir);
 
-	memset(info, 0, sizeof(*info));
-
-	pFile = fopen(temp, "r");
-
-	if (pFile == NULL) {
+	ret = jesd_read_file(temp, buf, sizeof(buf));
+	if (ret < 0) {
 		fprintf(stderr, "Failed to read JESD204 device file: %s\n",
 			temp);
-		return -errno;
-	}
-
-	ret = fscanf(pFile, "Link is %s\n", (char *)&info->link_state);
-	ret = fscanf(pFile, "Measured Link Clock: %s MHz\n",
-		     (char *)&info->measured_link_clock);
-	ret = fscanf(pFile, "Reported Link Clock: %s MHz\n",
-		     (char *)&info->reported_link_clock);
-
-	pos = ftell(pFile);
-	ret = fscanf(pFile, "Measured Device Clock: %s MHz\n",
-		     (char *)&info->measured_device_clock);
-
-	if (ret == 1) {
-		ret = fscanf(pFile, "Reported Device Clock: %s MHz\n",
-			     (char *)&info->reported_device_clock);
-		ret = fscanf(pFile, "Desired Device Clock: %s MHz\n",
-			     (char *)&info->desired_device_clock);
-	} else {
-		set_not_availabe(info->measured_device_clock);
-		set_not_availabe(info->reported_device_clock);
-		set_not_availabe(info->desired_device_clock);
-		fseek(pFile, pos, SEEK_SET);
-	}
-
-	pos = ftell(pFile);
-	ret = fscanf(pFile, "Lane rate: %s MHz\n", (char *)&info->lane_rate);
-
-	if (ret != 1) {
-		fseek(pFile, pos, SEEK_SET);
-		ret = fscanf(pFile, "External reset is %s\n", (char *)&info->external_reset);
-		fclose(pFile);
-
 		return ret;
 	}
 
-	if (encoder == JESD204_ENCODER_8B10B) {
-		ret = fscanf(pFile, "Lane rate / 40: %s MHz\n", (char *)&info->lane_rate_div);
-		ret = fscanf(pFile, "LMFC rate: %s MHz\n", (char *)&info->lmfc_rate);
-
-		/* Only on TX */
-		pos = ftell(pFile);
-		ret = fscanf(pFile, "SYNC~: %s\n", (char *)&info->sync_state);
-
-		if (ret != 1)
-			fseek(pFile, pos, SEEK_SET);
-	} else {
-		ret = fscanf(pFile, "Lane rate / 66: %s MHz\n", (char *)&info->lane_rate_div);
-		ret = fscanf(pFile, "LEMC rate: %s MHz\n", (char *)&info->lmfc_rate);
-	}
-	ret = fscanf(pFile, "Link status: %s\n", (char *)&info->link_status);
-	ret = fscanf(pFile, "SYSREF captured: %s\n", (char *)&info->sysref_captured);
-	ret = fscanf(pFile, "SYSREF alignment error: %s\n",
-		     (char *)&info->sysref_alignment_error);
-
-	fclose(pFile);
-
-	return ret;
+	return jesd_parse_jesd204_status(buf, info);
 }
 
 /* Global IIO context for unified API */
 struct jesd_iio_context *g_jesd_iio_ctx = NULL;
 
+/* In-process backend, NULL unless e.g. the simulator is active */
+const struct jesd_attr_backend *g_jesd_attr_backend = NULL;
+
+int jesd_backend_path(const char *path)
+{
+	return g_jesd_attr_backend && path &&
+	       !strncmp(path, g_jesd_attr_backend->prefix,
+			strlen(g_jesd_attr_backend->prefix));
+}
+
 /* =================================================================== */
 /* libiio implementation - always compiled, but may be stubs */
 /* =================================================================== */
@@ -510,93 +668,22 @@ int jesd_iio_read_encoding(struct iio_device *dev)
 		return JESD204_ENCODER_64B66B;
 }
 
-static void parse_lane_info_line(const char *line, const char *key, unsigned *value)
-{
-	char *pos = strstr(line, key);
-	if (pos) {
-		sscanf(pos + strlen(key), "%u", value);
-	}
-}
-
-static void parse_lane_info_string(const char *line, const char *key, char *value, size_t len)
-{
-	char *pos = strstr(line, key);
-
-	if (pos) {
-		sscanf(pos + strlen(key), "%s\n", value);
-	}
-}
-
 int jesd_iio_read_laneinfo(struct iio_device *dev, unsigned lane,
 			   struct jesd204b_laneinfo *info)
 {
 	char attr_name[32];
-	char buf[1024];
+	char buf[JESD_ATTR_BUF_SIZE];
 	int ret;
-	int encoder;
 
 	if (!dev || !info)
 		return -EINVAL;
 
-	memset(info, 0, sizeof(*info));
-
-	encoder = jesd_iio_read_encoding(dev);
-
 	snprintf(attr_name, sizeof(attr_name), "lane%u_info", lane);
 	ret = jesd_iio_read_attr(dev, attr_name, buf, sizeof(buf));
 	if (ret < 0)
 		return ret;
 
-	/* Parse based on encoder type */
-	if (encoder == JESD204_ENCODER_8B10B) {
-		/* Parse 8b10b format */
-		parse_lane_info_line(buf, "DID:", &info->did);
-		parse_lane_info_line(buf, "BID:", &info->bid);
-		parse_lane_info_line(buf, "LID:", &info->lid);
-		parse_lane_info_line(buf, "L:", &info->l);
-		parse_lane_info_line(buf, "SCR:", &info->scr);
-		parse_lane_info_line(buf, "F:", &info->f);
-		parse_lane_info_line(buf, "K:", &info->k);
-		parse_lane_info_line(buf, "M:", &info->m);
-		parse_lane_info_line(buf, "N:", &info->n);
-		parse_lane_info_line(buf, "CS:", &info->cs);
-		parse_lane_info_line(buf, "N':", &info->nd);
-		parse_lane_info_line(buf, "S:", &info->s);
-		parse_lane_info_line(buf, "HD:", &info->hd);
-		parse_lane_info_line(buf, "FCHK:", &info->fchk);
-		parse_lane_info_line(buf, "CF:", &info->cf);
-		parse_lane_info_line(buf, "ADJCNT:", &info->adjcnt);
-		parse_lane_info_line(buf, "PHYADJ:", &info->phyadj);
-		parse_lane_info_line(buf, "ADJDIR:", &info->adjdir);
-		parse_lane_info_line(buf, "JESDV:", &info->jesdv);
-		parse_lane_info_line(buf, "SUBCLASSV:", &info->subclassv);
-		{
-			unsigned fc_tmp = 0;
-			parse_lane_info_line(buf, "FC:", &fc_tmp);
-			info->fc = fc_tmp;
-		}
-		parse_lane_info_line(buf, "Errors:", &info->lane_errors);
-		parse_lane_info_string(buf, "CGS state:", info->cgs_state, sizeof(info->cgs_state));
-		parse_lane_info_string(buf, "Initial Frame Synchronization:",
-				       info->init_frame_sync, sizeof(info->init_frame_sync));
-		parse_lane_info_string(buf, "Lane Latency:", buf, sizeof(buf));
-		sscanf(buf, "Lane Latency: %u %u", &info->lane_latency_multiframes,
-		       &info->lane_latency_octets);
-	} else {
-		/* Parse 64b66b format */
-		parse_lane_info_line(buf, "Errors:", &info->lane_errors);
-		parse_lane_info_string(buf, "State of Extended multiblock alignment:",
-				       info->ext_multiblock_align_state,
-				       sizeof(info->ext_multiblock_align_state));
-
-		char *latency_pos = strstr(buf, "Lane Latency:");
-		if (latency_pos) {
-			ret = sscanf(latency_pos, "Lane Latency: %u (min/max %u/%u",
-			       &info->lane_latency_octets, &info->lane_latency_min,
-			       &info->lane_latency_max);
-
-		}
-	}
+	jesd_parse_laneinfo(buf, info);
 
 	return 0;
 }
@@ -619,65 +706,17 @@ int jesd_iio_read_all_laneinfo(struct iio_device *dev,
 int jesd_iio_read_jesd204_status(struct iio_device *dev,
 				 struct jesd204b_jesd204_status *info)
 {
-	char buf[2048];
+	char buf[JESD_ATTR_BUF_SIZE];
 	int ret;
-	char *line, *saveptr;
 
 	if (!dev || !info)
 		return -EINVAL;
 
-	memset(info, 0, sizeof(*info));
-
 	ret = jesd_iio_read_attr(dev, "status", buf, sizeof(buf));
 	if (ret < 0)
 		return ret;
 
-	/* Parse status line by line */
-	line = strtok_r(buf, "\n", &saveptr);
-	while (line) {
-		if (strstr(line, "Link is"))
-			sscanf(line, "Link is %s", info->link_state);
-		else if (strstr(line, "Measured Link Clock:"))
-			sscanf(line, "Measured Link Clock: %s", info->measured_link_clock);
-		else if (strstr(line, "Reported Link Clock:"))
-			sscanf(line, "Reported Link Clock: %s MHz", info->reported_link_clock);
-		else if (strstr(line, "Measured Device Clock:"))
-			sscanf(line, "Measured Device Clock: %s MHz", info->measured_device_clock);
-		else if (strstr(line, "Reported Device Clock:"))
-			sscanf(line, "Reported Device Clock: %s MHz", info->reported_device_clock);
-		else if (strstr(line, "Desired Device Clock:"))
-			sscanf(line, "Desired Device Clock: %s MHz", info->desired_device_clock);
-		else if (strstr(line, "Lane rate:"))
-			sscanf(line, "Lane rate: %s MHz", info->lane_rate);
-		else if (strstr(line, "Lane rate / 40:"))
-			sscanf(line, "Lane rate / 40: %s MHz", info->lane_rate_div);
-		else if (strstr(line, "Lane rate / 66:"))
-			sscanf(line, "Lane rate / 66: %s MHz", info->lane_rate_div);
-		else if (strstr(line, "LMFC rate:"))
-			sscanf(line, "LMFC rate: %s MHz", info->lmfc_rate);
-		else if (strstr(line, "LEMC rate:"))
-			sscanf(line, "LEMC rate: %s MHz", info->lmfc_rate);
-		else if (strstr(line, "SYNC~:"))
-			sscanf(line, "SYNC~: %s", info->sync_state);
-		else if (strstr(line, "Link status:"))
-			sscanf(line, "Link status: %s", info->link_status);
-		else if (strstr(line, "SYSREF captured:"))
-			sscanf(line, "SYSREF captured: %s", info->sysref_captured);
-		else if (strstr(line, "SYSREF alignment error:"))
-			sscanf(line, "SYSREF alignment error: %s", info->sysref_alignment_error);
-		else if (strstr(line, "External reset is"))
-			sscanf(line, "External reset is %s", info->external_reset);
-
-		line = strtok_r(NULL, "\n", &saveptr);
-	}
-
-	/* Set N/A for missing device clock fields if needed */
-	if (strlen(info->measured_device_clock) == 0)
-		strcpy(info->measured_device_clock, "N/A");
-	if (strlen(info->reported_device_clock) == 0)
-		strcpy(info->reported_device_clock, "N/A");
-	if (strlen(info->desired_device_clock) == 0)
-		strcpy(info->desired_device_clock, "N/A");
+	jesd_parse_jesd204_status(buf, info);
 
 	return 0;
 }
@@ -876,6 +915,18 @@ int jesd_read_attr(const char *path_or_device, const char *attr, char *buf, size
 	char full_path[PATH_MAX];
 	FILE *fp;
 	size_t read_len;
+	int ret;
+
+	if (jesd_backend_path(path_or_device)) {
+		ret = g_jesd_attr_backend->read(path_or_device, attr, buf, len - 1);
+		if (ret < 0)
+			return ret;
+
+		buf[ret] = '\0';
+		if (ret > 0 && buf[ret - 1] == '\n')
+			buf[ret - 1] = '\0';
+		return 0;
+	}
 
 	snprintf(full_path, sizeof(full_path), "%s/%s", path_or_device, attr);
 	fp = fopen(full_path, "r");
@@ -907,6 +958,9 @@ int jesd_write_attr(const char *path_or_device, const char *attr, const char *va
 	FILE *fp;
 	int ret;
 
+	if (jesd_backend_path(path_or_device))
+		return g_jesd_attr_backend->write(path_or_device, attr, value);
+
 	snprintf(full_path, sizeof(full_path), "%s/%s", path_or_device, attr);
 	fp = fopen(full_path, "w");
 	if (!fp)
@@ -917,3 +971,366 @@ int jesd_write_attr(const char *path_or_device, const char *attr, const char *va
 
 	return ret < 0 ? ret : 0;
 }
+
+/* =================================================================== */
+/* Persistent device handles */
+/* =================================================================== */
+
+/*
+ * Everything that does not change while a link is monitored is resolved once:
+ * the libiio device or sysfs path, the encoder and the number of lanes. The
+ * sysfs status and laneN_info files stay open and are re-read from offset 0,
+ * sysfs regenerates their contents on every such read.
+ */
+struct jesd_device {
+	char path[PATH_MAX];
+	struct iio_device *dev;
+	struct jesd_device_snapshot *snap;	/* link backend */
+	int encoder;
+	unsigned num_lanes;
+	int status_fd;
+	int lane_fd[MAX_LANES];
+};
+
+/*
+ * Last snapshot of a link backend. Reading the status fetches a new one, lanes
+ * read after it come from the same snapshot, any further read of a lane
+ * fetches again.
+ */
+struct jesd_device_snapshot {
+	struct jesd204b_jesd204_status status;
+	struct jesd204b_laneinfo lane[MAX_LANES];
+	unsigned fresh;		/* lanes not read since the snapshot was taken */
+};
+
+static int jesd_device_read_link(struct jesd_device *jdev)
+{
+	int ret;
+
+	ret = g_jesd_attr_backend->read_link(jdev->path, &jdev->encoder,
+					     &jdev->snap->status, jdev->snap->lane);
+	if (ret < 0)
+		return ret;
+
+	jdev->num_lanes = ret;
+	jdev->snap->fresh = ret < MAX_LANES ? (1U << ret) - 1 : ~0U;
+
+	return 0;
+}
+
+struct jesd_device *jesd_device_open(const char *path_or_device)
+{
+	struct jesd204b_laneinfo info;
+	struct jesd_device *jdev;
+	char temp[PATH_MAX];
+	struct stat buf;
+	unsigned lane;
+	int fd;
+
+	jdev = calloc(1, sizeof(*jdev));
+	if (!jdev)
+		return NULL;
+
+	snprintf(jdev->path, sizeof(jdev->path), "%s", path_or_device);
+	jdev->status_fd = -1;
+
+	if (jesd_backend_path(path_or_device) && g_jesd_attr_backend->read_link) {
+		jdev->snap = calloc(1, sizeof(*jdev->snap));
+		if (!jdev->snap) {
+			free(jdev);
+			return NULL;
+		}
+
+		/*
+		 * A link that is not published yet, stale or failing still
+		 * opens, every status read fetches it again.
+		 */
+		jesd_device_read_link(jdev);
+
+		return jdev;
+	}
+
+	jdev->dev = get_iio_device_from_path(path_or_device);
+	if (jdev->dev) {
+		jdev->encoder = jesd_iio_read_encoding(jdev->dev);
+
+		for (lane = 0; lane < MAX_LANES; lane++)
+			if (jesd_iio_read_laneinfo(jdev->dev, lane, &info))
+				break;
+
+		jdev->num_lanes = lane;
+
+		return jdev;
+	}
+
+	/* Callers retry and report it, this may run under curses */
+	if (stat(path_or_device, &buf)) {
+		free(jdev);
+		return NULL;
+	}
+
+	jdev->encoder = read_encoding(path_or_device);
+	if (jdev->encoder < 0) {
+		free(jdev);
+		return NULL;
+	}
+
+	snprintf(temp, sizeof(temp), "%s/status", path_or_device);
+	jdev->status_fd = open(temp, O_RDONLY | O_CLOEXEC);
+
+	for (lane = 0; lane < MAX_LANES; lane++) {
+		snprintf(temp, sizeof(temp), "%s/lane%u_info", path_or_device, lane);
+		fd = open(temp, O_RDONLY | O_CLOEXEC);
+		if (fd < 0)
+			break;
+
+		jdev->lane_fd[lane] = fd;
+	}
+
+	jdev->num_lanes = lane;
+
+	return jdev;
+}
+
+void jesd_device_close(struct jesd_device *jdev)
+{
+	unsigned lane;
+
+	if (!jdev)
+		return;
+
+	if (jdev->status_fd >= 0)
+		close(jdev->status_fd);
+
+	for (lane = 0; lane < jdev->num_lanes; lane++)
+		if (!jdev->dev && !jdev->snap)
+			close(jdev->lane_fd[lane]);
+
+	free(jdev->snap);
+	free(jdev);
+}
+
+const char *jesd_device_path(const struct jesd_device *jdev)
+{
+	return jdev->path;
+}
+
+int jesd_device_encoder(const struct jesd_device *jdev)
+{
+	return jdev->encoder;
+}
+
+unsigned jesd_device_num_lanes(const struct jesd_device *jdev)
+{
+	return jdev->num_lanes;
+}
+
+/* Re-reads an open sysfs file from the start, sysfs returns it in one go */
+static int jesd_device_pread(int fd, char *buf, size_t len)
+{
+	ssize_t ret;
+
+	ret = pread(fd, buf, len - 1, 0);
+	if (ret < 0)
+		return -errno;
+
+	buf[ret] = '\0';
+
+	return 0;
+}
+
+int jesd_device_read_status(struct jesd_device *jdev,
+			    struct jesd204b_jesd204_status *info)
+{
+	char buf[JESD_ATTR_BUF_SIZE];
+	int ret;
+
+	if (jdev->dev)
+		return jesd_iio_read_jesd204_status(jdev->dev, info);
+
+	if (jdev->snap) {
+		ret = jesd_device_read_link(jdev);
+		if (ret)
+			return ret;
+
+		*info = jdev->snap->status;
+		return 0;
+	}
+
+	if (jdev->status_fd < 0)
+		return -ENOENT;
+
+	ret = jesd_device_pread(jdev->status_fd, buf, sizeof(buf));
+	if (ret)
+		return ret;
+
+	return jesd_parse_jesd204_status(buf, info);
+}
+
+int jesd_device_read_laneinfo(struct jesd_device *jdev, unsigned lane,
+			      struct jesd204b_laneinfo *info)
+{
+	char buf[JESD_ATTR_BUF_SIZE];
+	int ret;
+
+	if (lane >= jdev->num_lanes)
+		return -ENOENT;
+
+	if (jdev->dev)
+		return jesd_iio_read_laneinfo(jdev->dev, lane, info);
+
+	if (jdev->snap) {
+		if (!(jdev->snap->fresh & (1U << lane))) {
+			ret = jesd_device_read_link(jdev);
+			if (ret)
+				return ret;
+			if (lane >= jdev->num_lanes)
+				return -ENOENT;
+		}
+
+		jdev->snap->fresh &= ~(1U << lane);
+		*info = jdev->snap->lane[lane];
+		return 0;
+	}
+
+	ret = jesd_device_pread(jdev->lane_fd[lane], buf, sizeof(buf));
+	if (ret)
+		return ret;
+
+	return jesd_parse_laneinfo(buf, info);
+}
+
+/* Returns the number of lanes read, like jesd_read_all_laneinfo() */
+int jesd_device_read_all_laneinfo(struct jesd_device *jdev,
+				  struct jesd204b_laneinfo lane_info[MAX_LANES])
+{
+	unsigned lane;
+
+	for (lane = 0; lane < jdev->num_lanes; lane++)
+		if (jesd_device_read_laneinfo(jdev, lane, &lane_info[lane]) < 0)
+			break;
+
+	return lane;
+}
+
+unsigned long long jesd_time_us(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+/* Longest sleep between readiness checks */
+#define JESD_READY_MAX_US	250000ULL
+
+/*
+ * Interval until the next readiness check. Nothing is expected before 3/4 of
+ * the estimated acquisition time, after that the attribute is checked at a
+ * fraction of the estimate, backing off to JESD_READY_MAX_US once it is
+ * exceeded.
+ */
+static unsigned long long jesd_ready_delay_us(unsigned long long elapsed,
+					      unsigned long long expected,
+					      unsigned long long *step)
+{
+	unsigned long long early = expected / 4 * 3;
+
+	if (elapsed < early)
+		return MIN(early - elapsed, JESD_READY_MAX_US);
+
+	if (elapsed > expected)
+		*step = MIN(*step * 2, JESD_READY_MAX_US);
+
+	return *step;
+}
+
+static void jesd_close_fd(void *fd)
+{
+	close(*(int *)fd);
+}
+
+static int jesd_sysfs_attr_ready(int fd)
+{
+	char buf[MAX_SYSFS_STRING_SIZE];
+
+	/* Reading also re-arms sysfs_notify() for the next poll() */
+	if (lseek(fd, 0, SEEK_SET) < 0)
+		return -errno;
+
+	if (read(fd, buf, sizeof(buf)) < 0)
+		return -errno;
+
+	return 0;
+}
+
+/*
+ * Wait until reading @attr no longer fails with -EBUSY. Local sysfs attributes
+ * are poll()ed so a sysfs_notify() from the driver ends the wait immediately,
+ * libiio attributes are re-read with a backoff driven by @expected_us.
+ * Returns -ENOENT if the attribute does not exist.
+ */
+int jesd_wait_attr_ready(const char *path_or_device, const char *attr,
+			 unsigned long long expected_us,
+			 struct jesd_xfer_stats *stats)
+{
+	struct iio_device *dev = get_iio_device_from_path(path_or_device);
+	unsigned long long start = jesd_time_us(), step, delay;
+	char path[PATH_MAX];
+	struct pollfd pfd;
+	int ret;
+
+	step = MIN(MAX(expected_us / 32, 5000ULL), JESD_READY_MAX_US);
+
+	if (dev) {
+		long long val;
+
+		while ((ret = jesd_iio_device_attr_read_longlong(dev, attr, &val)) == -EBUSY) {
+			if (stats)
+				stats->polls++;
+
+			delay = jesd_ready_delay_us(jesd_time_us() - start, expected_us, &step);
+			usleep(delay);
+		}
+	} else if (jesd_backend_path(path_or_device)) {
+		char buf[MAX_SYSFS_STRING_SIZE];
+
+		while ((ret = g_jesd_attr_backend->read(path_or_device, attr, buf,
+							sizeof(buf))) == -EBUSY) {
+			if (stats)
+				stats->polls++;
+
+			delay = jesd_ready_delay_us(jesd_time_us() - start, expected_us, &step);
+			usleep(delay);
+		}
+	} else {
+		snprintf(path, sizeof(path), "%s/%s", path_or_device, attr);
+		pfd.fd = open(path, O_RDONLY | O_CLOEXEC);
+		if (pfd.fd < 0)
+			return -errno;
+
+		pfd.events = POLLPRI | POLLERR;
+
+		/* poll() is a cancellation point, scan workers may be cancelled */
+		pthread_cleanup_push(jesd_close_fd, &pfd.fd);
+
+		while ((ret = jesd_sysfs_attr_ready(pfd.fd)) == -EBUSY) {
+			if (stats)
+				stats->polls++;
+
+			delay = jesd_ready_delay_us(jesd_time_us() - start, expected_us, &step);
+			if (poll(&pfd, 1, delay / 1000) < 0 && errno != EINTR) {
+				ret = -errno;
+				break;
+			}
+		}
+
+		pthread_cleanup_pop(1);
+	}
+
+	if (stats)
+		stats->wait_us += jesd_time_us() - start;
+
+	return ret < 0 ? ret : 0;
+}
@@ -127,6 +127,9 @@ int read_all_laneinfo(const char *path,
 int read_jesd204_status(const char *basedir,
 			struct jesd204b_jesd204_status *info);
 int read_encoding(const char *basedir);
+int jesd_parse_laneinfo(const char *buf, struct jesd204b_laneinfo *info);
+int jesd_parse_jesd204_status(const char *buf,
+			      struct jesd204b_jesd204_status *info);
 
 /* libiio-based structures - always available */
 struct jesd_iio_context {
@@ -174,8 +177,61 @@ int jesd_read_attr(const char *path_or_device, const char *attr, char *buf, size
 
 struct iio_device *get_iio_device_from_path(const char *path_or_device);
 
+/*
+ * Persistent handle on a JESD204 link layer device for periodic refreshes:
+ * resolves the sysfs path or libiio device once, caches the encoder and lane
+ * count and keeps the status and laneN_info files open.
+ */
+struct jesd_device;
+
+struct jesd_device *jesd_device_open(const char *path_or_device);
+void jesd_device_close(struct jesd_device *jdev);
+const char *jesd_device_path(const struct jesd_device *jdev);
+int jesd_device_encoder(const struct jesd_device *jdev);
+unsigned jesd_device_num_lanes(const struct jesd_device *jdev);
+int jesd_device_read_status(struct jesd_device *jdev,
+			    struct jesd204b_jesd204_status *info);
+int jesd_device_read_laneinfo(struct jesd_device *jdev, unsigned lane,
+			      struct jesd204b_laneinfo *info);
+int jesd_device_read_all_laneinfo(struct jesd_device *jdev,
+				  struct jesd204b_laneinfo lane_info[MAX_LANES]);
+
+/* Time spent waiting for and transferring attribute data, in microseconds */
+struct jesd_xfer_stats {
+	unsigned long long wait_us;
+	unsigned long long xfer_us;
+	unsigned polls;
+};
+
+unsigned long long jesd_time_us(void);
+int jesd_wait_attr_ready(const char *path_or_device, const char *attr,
+			 unsigned long long expected_us,
+			 struct jesd_xfer_stats *stats);
+
+/*
+ * In-process attribute backend such as the eye scan simulator. Paths starting
+ * with @prefix go to it instead of sysfs. read() returns the number of bytes,
+ * or -EBUSY while the attribute is not ready, like the driver does.
+ * Backends serving whole link snapshots (jesd_monitord clients) implement
+ * read_link(), jesd_device handles then use it instead of status and
+ * laneN_info: it fills @status and @lane_info and returns the lane count.
+ */
+struct jesd_attr_backend {
+	const char *prefix;
+	int (*find_devices)(const char *driver, char devices[MAX_DEVICES][PATH_MAX],
+			    int start);
+	int (*read)(const char *path, const char *attr, char *buf, size_t len);
+	int (*write)(const char *path, const char *attr, const char *value);
+	int (*read_link)(const char *path, int *encoder,
+			 struct jesd204b_jesd204_status *status,
+			 struct jesd204b_laneinfo lane_info[MAX_LANES]);
+};
+
+int jesd_backend_path(const char *path);
+
 /* Global context management */
 extern struct jesd_iio_context *g_jesd_iio_ctx;
+extern const struct jesd_attr_backend *g_jesd_attr_backend;
 
 
 #endif
@@ -0,0 +1,753 @@
+/***************************************************************************//**
+*   @file   jesd_exporter.c
+*   @brief  JESD204 Link Status OpenMetrics Exporter
+*   @author Michael Hennerich (michael.hennerich@analog.com)
+********************************************************************************
+* Copyright 2026(c) Analog Devices, Inc. All rights reserved.
+*
+* An ADI specific BSD license, which can be found in the top level directory
+* of this repository (LICENSE.txt), and also on-line at:
+* https://github.com/analogdevicesinc/jesd-eye-scan-gtk/blob/main/LICENSE.txt
+*******************************************************************************/
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <ctype.h>
+#include <limits.h>
+#include <poll.h>
+#include <time.h>
+#include <signal.h>
+#include <pthread.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/signalfd.h>
+
+#include "jesd_common.h"
+#include "jesd_monitor.h"
+
+#define EXPORTER_LISTEN		"127.0.0.1:9204"
+#define EXPORTER_REFRESH_MS	1000
+#define EXPORTER_CLIENTS	32
+#define EXPORTER_TIMEOUT_US	5000000ULL	/* idle or slow client */
+#define EXPORTER_REQ_SIZE	2048
+
+#define OPENMETRICS_TYPE	"application/openmetrics-text; version=1.0.0; charset=utf-8"
+
+/*
+ * A rendered /metrics response. The refresh thread publishes a new page per
+ * refresh, clients hold a reference until their response was sent, so a scrape
+ * never waits for the hardware and never sees a half written page.
+ */
+struct metrics_page {
+	unsigned refcnt;
+	size_t len;
+	size_t size;
+	char *data;
+};
+
+struct exporter_client {
+	int fd;
+	unsigned long long deadline_us;
+	char req[EXPORTER_REQ_SIZE];
+	size_t req_len;
+	char head[256];
+	size_t head_len;
+	struct metrics_page *page;	/* body, NULL for error responses */
+	size_t off;			/* sent bytes of head and body */
+	bool head_only;
+};
+
+static char basedir[PATH_MAX];
+static char jesd_devices[MAX_DEVICES][PATH_MAX];
+static struct jesd_device *jesd_handles[MAX_DEVICES];
+static int dev_num;
+
+static pthread_mutex_t page_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t stop_cond;
+static struct metrics_page *page;
+static bool stop;
+
+static struct exporter_client clients[EXPORTER_CLIENTS];
+
+static void page_put(struct metrics_page *p)
+{
+	bool last;
+
+	if (!p)
+		return;
+
+	pthread_mutex_lock(&page_lock);
+	last = !--p->refcnt;
+	pthread_mutex_unlock(&page_lock);
+
+	if (last) {
+		free(p->data);
+		free(p);
+	}
+}
+
+static struct metrics_page *page_get(void)
+{
+	struct metrics_page *p;
+
+	pthread_mutex_lock(&page_lock);
+	p = page;
+	if (p)
+		p->refcnt++;
+	pthread_mutex_unlock(&page_lock);
+
+	return p;
+}
+
+static void page_publish(struct metrics_page *p)
+{
+	struct metrics_page *old;
+
+	pthread_mutex_lock(&page_lock);
+	old = page;
+	page = p;
+	pthread_mutex_unlock(&page_lock);
+
+	page_put(old);
+}
+
+static int __attribute__((format(printf, 2, 3)))
+page_printf(struct metrics_page *p, const char *fmt, ...)
+{
+	va_list args;
+	size_t size;
+	char *data;
+	int len;
+
+	while (true) {
+		va_start(args, fmt);
+		len = vsnprintf(p->data + p->len, p->size - p->len, fmt, args);
+		va_end(args);
+
+		if (len < 0)
+			return -EINVAL;
+		if ((size_t)len < p->size - p->len)
+			break;
+
+		size = MAX(p->size * 2, p->len + len + 1);
+		data = realloc(p->data, size);
+		if (!data)
+			return -ENOMEM;
+		p->data = data;
+		p->size = size;
+	}
+
+	p->len += len;
+
+	return 0;
+}
+
+/* Label values escape backslash, double quote and line feed */
+static const char *label_escape(const char *str, char *buf, size_t len)
+{
+	size_t i = 0;
+
+	for (; *str && i + 2 < len; str++) {
+		if (*str == '\\' || *str == '"' || *str == '\n') {
+			buf[i++] = '\\';
+			buf[i++] = *str == '\n' ? 'n' : *str;
+		} else {
+			buf[i++] = *str;
+		}
+	}
+	buf[i] = '\0';
+
+	return buf;
+}
+
+/* One read of all devices */
+struct exporter_snapshot {
+	int err[MAX_DEVICES];
+	int encoder[MAX_DEVICES];
+	unsigned lanes[MAX_DEVICES];
+	struct jesd204b_jesd204_status status[MAX_DEVICES];
+	struct jesd204b_laneinfo lane[MAX_DEVICES][MAX_LANES];
+	unsigned long long read_us;
+	unsigned long long refreshes;
+	time_t time;
+};
+
+static struct jesd_device *exporter_get_device(int idx)
+{
+	char *path;
+
+	if (jesd_handles[idx])
+		return jesd_handles[idx];
+
+	if (g_jesd_iio_ctx) {
+		jesd_handles[idx] = jesd_device_open(jesd_devices[idx]);
+	} else {
+		path = get_full_device_path(basedir, jesd_devices[idx]);
+		if (!path)
+			return NULL;
+		jesd_handles[idx] = jesd_device_open(path);
+		free(path);
+	}
+
+	return jesd_handles[idx];
+}
+
+static void exporter_read(struct exporter_snapshot *snap)
+{
+	unsigned long long start = jesd_time_us();
+	struct jesd_device *jdev;
+	int i;
+
+	for (i = 0; i < dev_num; i++) {
+		jdev = exporter_get_device(i);
+		if (!jdev) {
+			snap->err[i] = -ENODEV;
+			continue;
+		}
+
+		memset(&snap->status[i], 0, sizeof(snap->status[i]));
+		snap->err[i] = MIN(jesd_device_read_status(jdev, &snap->status[i]), 0);
+		snap->encoder[i] = jesd_device_encoder(jdev);
+		snap->lanes[i] = jesd_device_read_all_laneinfo(jdev, snap->lane[i]);
+	}
+
+	snap->read_us = jesd_time_us() - start;
+	snap->refreshes++;
+	snap->time = time(NULL);
+}
+
+/* "9830.400" MHz as Hz, false if the clock is not reported ("N/A") */
+static bool mhz_to_hz(const char *mhz, double *hz)
+{
+	char *end;
+
+	*hz = strtod(mhz, &end) * 1e6;
+
+	return end != mhz && !*end;
+}
+
+static bool lane_synced(int encoder, const struct jesd204b_laneinfo *lane)
+{
+	if (encoder == JESD204_ENCODER_64B66B)
+		return !strcmp(lane->ext_multiblock_align_state, "EMB_LOCK");
+
+	return !strcmp(lane->cgs_state, "DATA") &&
+	       !strcmp(lane->init_frame_sync, "Yes") &&
+	       !strcmp(lane->init_lane_align_seq, "Yes");
+}
+
+#define family(p, name, type, help) \
+	page_printf(p, "# TYPE " name " " type "\n# HELP " name " " help "\n")
+
+#define for_each_up_device(snap, i) \
+	for (i = 0; i < dev_num; i++) \
+		if (!(snap)->err[i])
+
+static const struct {
+	const char *name;
+	size_t offset;
+} clock_metrics[] = {
+	{ "measured_link_clock", offsetof(struct jesd204b_jesd204_status, measured_link_clock) },
+	{ "reported_link_clock", offsetof(struct jesd204b_jesd204_status, reported_link_clock) },
+	{ "measured_device_clock", offsetof(struct jesd204b_jesd204_status, measured_device_clock) },
+	{ "reported_device_clock", offsetof(struct jesd204b_jesd204_status, reported_device_clock) },
+	{ "desired_device_clock", offsetof(struct jesd204b_jesd204_status, desired_device_clock) },
+	{ "lane_rate", offsetof(struct jesd204b_jesd204_status, lane_rate) },
+	{ "lane_rate_div", offsetof(struct jesd204b_jesd204_status, lane_rate_div) },
+	{ "lmfc_rate", offsetof(struct jesd204b_jesd204_status, lmfc_rate) },
+};
+
+static int exporter_render(const struct exporter_snapshot *snap,
+			   struct metrics_page *p)
+{
+	char dev[MAX_DEVICES][PATH_MAX * 2], state[MAX_SYSFS_STRING_SIZE * 2];
+	char status[MAX_SYSFS_STRING_SIZE * 2];
+	const struct jesd204b_jesd204_status *info;
+	const struct jesd204b_laneinfo *lane;
+	unsigned l, c;
+	double hz;
+	int i;
+
+	for (i = 0; i < dev_num; i++)
+		label_escape(jesd_devices[i], dev[i], sizeof(dev[i]));
+
+	family(p, "jesd_device_up", "gauge", "Whether the link status could be read.");
+	for (i = 0; i < dev_num; i++)
+		page_printf(p, "jesd_device_up{device=\"%s\"} %d\n", dev[i], !snap->err[i]);
+
+	family(p, "jesd_link", "info", "Encoder, link state and link status.");
+	for_each_up_device(snap, i) {
+		info = &snap->status[i];
+		page_printf(p, "jesd_link_info{device=\"%s\",encoder=\"%s\",state=\"%s\",status=\"%s\"} 1\n",
+			    dev[i],
+			    snap->encoder[i] == JESD204_ENCODER_64B66B ? "64b66b" : "8b10b",
+			    label_escape(info->link_state, state, sizeof(state)),
+			    label_escape(info->link_status, status, sizeof(status)));
+	}
+
+	family(p, "jesd_link_enabled", "gauge", "Link is enabled.");
+	for_each_up_device(snap, i)
+		page_printf(p, "jesd_link_enabled{device=\"%s\"} %d\n", dev[i],
+			    !strcmp(snap->status[i].link_state, "enabled"));
+
+	family(p, "jesd_link_data", "gauge", "Link status is DATA.");
+	for_each_up_device(snap, i)
+		page_printf(p, "jesd_link_data{device=\"%s\"} %d\n", dev[i],
+			    !strcmp(snap->status[i].link_status, "DATA"));
+
+	family(p, "jesd_sysref_captured", "gauge", "SYSREF was captured.");
+	for_each_up_device(snap, i)
+		page_printf(p, "jesd_sysref_captured{device=\"%s\"} %d\n", dev[i],
+			    !strcmp(snap->status[i].sysref_captured, "Yes"));
+
+	family(p, "jesd_sysref_alignment_error", "gauge", "SYSREF alignment error.");
+	for_each_up_device(snap, i)
+		page_printf(p, "jesd_sysref_alignment_error{device=\"%s\"} %d\n", dev[i],
+			    !strcmp(snap->status[i].sysref_alignment_error, "Yes"));
+
+	/* Clocks the core does not report (device clocks of 8b10b links) are left out */
+	family(p, "jesd_clock_hertz", "gauge", "Link clocks and rates as reported in status.");
+	for (c = 0; c < ARRAY_SIZE(clock_metrics); c++)
+		for_each_up_device(snap, i)
+			if (mhz_to_hz((const char *)&snap->status[i] + clock_metrics[c].offset, &hz))
+				page_printf(p, "jesd_clock_hertz{device=\"%s\",clock=\"%s\"} %.17g\n",
+					    dev[i], clock_metrics[c].name, hz);
+
+	family(p, "jesd_lane_errors", "counter", "Lane error counter.");
+	for_each_up_device(snap, i)
+		for (l = 0; l < snap->lanes[i]; l++)
+			page_printf(p, "jesd_lane_errors_total{device=\"%s\",lane=\"%u\"} %u\n",
+				    dev[i], l, snap->lane[i][l].lane_errors);
+
+	family(p, "jesd_lane_latency_octets", "gauge", "Lane latency in octets.");
+	for_each_up_device(snap, i)
+		for (l = 0; l < snap->lanes[i]; l++) {
+			lane = &snap->lane[i][l];
+			page_printf(p, "jesd_lane_latency_octets{device=\"%s\",lane=\"%u\"} %u\n",
+				    dev[i], l, lane->k * lane->f * lane->lane_latency_multiframes +
+				    lane->lane_latency_octets);
+		}
+
+	family(p, "jesd_lane_synced", "gauge",
+	       "Lane is in DATA with frame sync and ILAS (8b10b) or in EMB_LOCK (64b66b).");
+	for_each_up_device(snap, i)
+		for (l = 0; l < snap->lanes[i]; l++)
+			page_printf(p, "jesd_lane_synced{device=\"%s\",lane=\"%u\"} %d\n",
+				    dev[i], l, lane_synced(snap->encoder[i], &snap->lane[i][l]));
+
+	family(p, "jesd_exporter_read_seconds", "gauge", "Time the last refresh took to read all devices.");
+	page_printf(p, "jesd_exporter_read_seconds %.6f\n", snap->read_us / 1e6);
+
+	family(p, "jesd_exporter_refreshes", "counter", "Refreshes since the exporter started.");
+	page_printf(p, "jesd_exporter_refreshes_total %llu\n", snap->refreshes);
+
+	family(p, "jesd_exporter_last_refresh_timestamp_seconds", "gauge",
+	       "Time of the last refresh.");
+	page_printf(p, "jesd_exporter_last_refresh_timestamp_seconds %lld\n",
+		    (long long)snap->time);
+
+	return page_printf(p, "# EOF\n");
+}
+
+/* Reads all devices every @arg ms and publishes a fresh page */
+static void *exporter_refresh(void *arg)
+{
+	unsigned refresh_ms = *(unsigned *)arg;
+	struct exporter_snapshot *snap;
+	struct metrics_page *p;
+	struct timespec ts, now;
+
+	snap = calloc(1, sizeof(*snap));
+	if (!snap)
+		return NULL;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	pthread_mutex_lock(&page_lock);
+
+	while (!stop) {
+		pthread_mutex_unlock(&page_lock);
+
+		exporter_read(snap);
+
+		p = calloc(1, sizeof(*p));
+		if (p) {
+			p->refcnt = 1;
+			if (exporter_render(snap, p)) {
+				free(p->data);
+				free(p);
+			} else {
+				page_publish(p);
+			}
+		}
+
+		/*
+		 * Fixed rate, a slow read shortens the next wait. Once a whole
+		 * interval is lost the schedule restarts from now rather than
+		 * catching up with back to back reads.
+		 */
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		if ((now.tv_sec - ts.tv_sec) * 1000000000LL + now.tv_nsec - ts.tv_nsec >=
+		    refresh_ms * 1000000LL)
+			ts = now;
+		ts.tv_sec += refresh_ms / 1000;
+		ts.tv_nsec += (refresh_ms % 1000) * 1000000L;
+		if (ts.tv_nsec >= 1000000000L) {
+			ts.tv_sec++;
+			ts.tv_nsec -= 1000000000L;
+		}
+
+		pthread_mutex_lock(&page_lock);
+		while (!stop && pthread_cond_timedwait(&stop_cond, &page_lock, &ts) != ETIMEDOUT)
+			;
+	}
+
+	pthread_mutex_unlock(&page_lock);
+	free(snap);
+
+	return NULL;
+}
+
+static int exporter_listen(const char *listen_addr)
+{
+	struct addrinfo hints = {
+		.ai_family = AF_UNSPEC,
+		.ai_socktype = SOCK_STREAM,
+		.ai_flags = AI_PASSIVE,
+	};
+	char host[256], *port;
+	struct addrinfo *res, *ai;
+	int fd = -1, one = 1, ret;
+
+	/* "PORT" listens on all addresses */
+	if (!strchr(listen_addr, ':'))
+		snprintf(host, sizeof(host), ":%s", listen_addr);
+	else
+		snprintf(host, sizeof(host), "%s", listen_addr);
+
+	port = strrchr(host, ':');
+	*port++ = '\0';
+
+	/* "[::1]:9204" */
+	if (host[0] == '[' && host[strlen(host) - 1] == ']') {
+		host[strlen(host) - 1] = '\0';
+		memmove(host, host + 1, strlen(host));
+	}
+
+	ret = getaddrinfo(host[0] ? host : NULL, port, &hints, &res);
+	if (ret) {
+		fprintf(stderr, "Invalid listen address %s: %s\n", listen_addr,
+			gai_strerror(ret));
+		return -EINVAL;
+	}
+
+	for (ai = res; ai; ai = ai->ai_next) {
+		fd = socket(ai->ai_family, ai->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC,
+			    ai->ai_protocol);
+		if (fd < 0)
+			continue;
+
+		setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+		if (!bind(fd, ai->ai_addr, ai->ai_addrlen) && !listen(fd, 16))
+			break;
+
+		close(fd);
+		fd = -1;
+	}
+
+	freeaddrinfo(res);
+
+	if (fd < 0)
+		fprintf(stderr, "Failed to listen on %s: %s\n", listen_addr, strerror(errno));
+
+	return fd;
+}
+
+static void client_close(struct exporter_client *cl)
+{
+	close(cl->fd);
+	page_put(cl->page);
+	cl->fd = -1;
+	cl->page = NULL;
+}
+
+/* Parses the request line once the header is complete, sets up the response */
+static void client_respond(struct exporter_client *cl)
+{
+	char method[8], target[128];
+	const char *status = "200 OK", *body = NULL;
+
+	if (sscanf(cl->req, "%7s %127s", method, target) != 2) {
+		status = "400 Bad Request";
+		body = "Bad request\n";
+	} else if (strcmp(method, "GET") && strcmp(method, "HEAD")) {
+		status = "405 Method Not Allowed";
+		body = "Only GET and HEAD are supported\n";
+	} else if (strcmp(target, "/metrics") && strncmp(target, "/metrics?", 9)) {
+		status = "404 Not Found";
+		body = "JESD204 link status exporter, see /metrics\n";
+	} else {
+		cl->page = page_get();
+		if (!cl->page) {
+			status = "503 Service Unavailable";
+			body = "No data yet\n";
+		}
+	}
+
+	cl->head_only = !strcmp(method, "HEAD");
+	cl->head_len = snprintf(cl->head, sizeof(cl->head),
+				"HTTP/1.1 %s\r\n"
+				"Content-Type: %s\r\n"
+				"Content-Length: %zu\r\n"
+				"Connection: close\r\n\r\n%s",
+				status, cl->page ? OPENMETRICS_TYPE : "text/plain",
+				cl->page ? cl->page->len : strlen(body),
+				body && !cl->head_only ? body : "");
+	cl->off = 0;
+}
+
+static void client_read(struct exporter_client *cl)
+{
+	ssize_t ret;
+
+	ret = recv(cl->fd, cl->req + cl->req_len, sizeof(cl->req) - 1 - cl->req_len, 0);
+	if (ret <= 0) {
+		if (!ret || (errno != EAGAIN && errno != EINTR))
+			client_close(cl);
+		return;
+	}
+
+	cl->req_len += ret;
+	cl->req[cl->req_len] = '\0';
+
+	if (strstr(cl->req, "\r\n\r\n") || strstr(cl->req, "\n\n") ||
+	    cl->req_len == sizeof(cl->req) - 1)
+		client_respond(cl);
+}
+
+static void client_write(struct exporter_client *cl)
+{
+	size_t body = cl->page && !cl->head_only ? cl->page->len : 0;
+	const char *data;
+	size_t len;
+	ssize_t ret;
+
+	if (cl->off < cl->head_len) {
+		data = cl->head + cl->off;
+		len = cl->head_len - cl->off;
+	} else {
+		data = cl->page->data + cl->off - cl->head_len;
+		len = cl->head_len + body - cl->off;
+	}
+
+	ret = send(cl->fd, data, len, MSG_NOSIGNAL);
+	if (ret < 0) {
+		if (errno != EAGAIN && errno != EINTR)
+			client_close(cl);
+		return;
+	}
+
+	cl->off += ret;
+	if (cl->off == cl->head_len + body)
+		client_close(cl);
+}
+
+static void client_accept(int lfd)
+{
+	unsigned i;
+	int fd;
+
+	while ((fd = accept4(lfd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+		for (i = 0; i < EXPORTER_CLIENTS && clients[i].fd >= 0; i++)
+			;
+
+		if (i == EXPORTER_CLIENTS) {
+			close(fd);
+			continue;
+		}
+
+		memset(&clients[i], 0, sizeof(clients[i]));
+		clients[i].fd = fd;
+		clients[i].deadline_us = jesd_time_us() + EXPORTER_TIMEOUT_US;
+	}
+}
+
+static void usage(const char *name)
+{
+	fprintf(stderr, "%s [-p PATH | -u URI] [-l [ADDR:]PORT] [-r REFRESH_MS]\n"
+		"  -p PATH   sysfs root (default /)\n"
+		"  -u URI    libiio context, or monitor:[SOCKET] for jesd_monitord\n"
+		"  -l ADDR   listen address (default %s)\n"
+		"  -r MS     hardware refresh interval (default %d)\n",
+		name, EXPORTER_LISTEN, EXPORTER_REFRESH_MS);
+}
+
+int main(int argc, char *argv[])
+{
+	struct pollfd pfd[2 + EXPORTER_CLIENTS];
+	const char *listen_addr = EXPORTER_LISTEN;
+	unsigned refresh_ms = EXPORTER_REFRESH_MS;
+	struct exporter_client *map[EXPORTER_CLIENTS];
+	struct signalfd_siginfo si;
+	pthread_condattr_t attr;
+	char *path = "", *uri = NULL;
+	unsigned i, n;
+	pthread_t thread;
+	sigset_t mask;
+	int c, lfd, sfd, ret = 1;
+
+	while ((c = getopt(argc, argv, "p:u:l:r:h")) != -1)
+		switch (c) {
+		case 'p':
+			path = optarg;
+			break;
+		case 'u':
+			uri = optarg;
+			break;
+		case 'l':
+			listen_addr = optarg;
+			break;
+		case 'r':
+			refresh_ms = strtoul(optarg, NULL, 0);
+			if (!refresh_ms) {
+				fprintf(stderr, "Refresh interval must be at least 1 ms\n");
+				return 1;
+			}
+			break;
+		default:
+			usage(argv[0]);
+			return c != 'h';
+		}
+
+	if (uri && !strncmp(uri, JESD_MONITOR_PREFIX, strlen(JESD_MONITOR_PREFIX))) {
+		if (jesd_monitor_attach(uri + strlen(JESD_MONITOR_PREFIX)))
+			return 1;
+		strcpy(basedir, JESD_MONITOR_BASEDIR);
+		dev_num = jesd_find_devices(basedir, JESD204_RX_DRIVER_NAME, "status", jesd_devices, 0);
+		dev_num = jesd_find_devices(basedir, JESD204_TX_DRIVER_NAME, "status", jesd_devices, dev_num);
+	} else if (uri) {
+		g_jesd_iio_ctx = jesd_iio_create_context(uri);
+		if (!g_jesd_iio_ctx) {
+			fprintf(stderr, "Failed to create IIO context\n");
+			return 1;
+		}
+		dev_num = jesd_iio_find_devices(g_jesd_iio_ctx, jesd_devices);
+	} else {
+		snprintf(basedir, sizeof(basedir), "%s/sys/bus/platform/drivers", path);
+		dev_num = jesd_find_devices(basedir, JESD204_RX_DRIVER_NAME, "status", jesd_devices, 0);
+		dev_num = jesd_find_devices(basedir, JESD204_TX_DRIVER_NAME, "status", jesd_devices, dev_num);
+	}
+	if (!dev_num) {
+		fprintf(stderr, "Failed to find JESD devices\n");
+		goto out_iio;
+	}
+
+	lfd = exporter_listen(listen_addr);
+	if (lfd < 0)
+		goto out_iio;
+
+	sigemptyset(&mask);
+	sigaddset(&mask, SIGINT);
+	sigaddset(&mask, SIGTERM);
+	pthread_sigmask(SIG_BLOCK, &mask, NULL);
+	sfd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+	if (sfd < 0) {
+		perror("signalfd");
+		goto out_listen;
+	}
+
+	for (i = 0; i < EXPORTER_CLIENTS; i++)
+		clients[i].fd = -1;
+
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	pthread_cond_init(&stop_cond, &attr);
+	pthread_condattr_destroy(&attr);
+
+	if (pthread_create(&thread, NULL, exporter_refresh, &refresh_ms)) {
+		fprintf(stderr, "Failed to start the refresh thread\n");
+		goto out_signal;
+	}
+
+	fprintf(stderr, "Serving %d JESD204 links on http://%s/metrics\n", dev_num,
+		listen_addr);
+
+	while (true) {
+		pfd[0] = (struct pollfd) { .fd = lfd, .events = POLLIN };
+		pfd[1] = (struct pollfd) { .fd = sfd, .events = POLLIN };
+
+		for (i = 0, n = 0; i < EXPORTER_CLIENTS; i++) {
+			if (clients[i].fd < 0)
+				continue;
+
+			/* Drop clients that never finish a request or stopped reading */
+			if (jesd_time_us() > clients[i].deadline_us) {
+				client_close(&clients[i]);
+				continue;
+			}
+
+			map[n] = &clients[i];
+			pfd[2 + n].fd = clients[i].fd;
+			pfd[2 + n].events = clients[i].head_len ? POLLOUT : POLLIN;
+			n++;
+		}
+
+		if (poll(pfd, 2 + n, 1000) < 0) {
+			if (errno == EINTR)
+				continue;
+			perror("poll");
+			break;
+		}
+
+		if (pfd[1].revents & POLLIN && read(sfd, &si, sizeof(si)) == sizeof(si)) {
+			ret = 0;
+			break;
+		}
+
+		for (i = 0; i < n; i++) {
+			if (!pfd[2 + i].revents)
+				continue;
+
+			if (map[i]->head_len)
+				client_write(map[i]);
+			else
+				client_read(map[i]);
+		}
+
+		if (pfd[0].revents & POLLIN)
+			client_accept(lfd);
+	}
+
+	pthread_mutex_lock(&page_lock);
+	stop = true;
+	pthread_cond_signal(&stop_cond);
+	pthread_mutex_unlock(&page_lock);
+	pthread_join(thread, NULL);
+
+	for (i = 0; i < EXPORTER_CLIENTS; i++)
+		if (clients[i].fd >= 0)
+			client_close(&clients[i]);
+	page_publish(NULL);
+
+out_signal:
+	close(sfd);
+out_listen:
+	close(lfd);
+out_iio:
+	for (i = 0; i < (unsigned)dev_num; i++)
+		jesd_device_close(jesd_handles[i]);
+
+	if (g_jesd_iio_ctx)
+		jesd_iio_destroy_context(g_jesd_iio_ctx);
+	jesd_monitor_detach();
+
+	return ret;
+}
@@ -0,0 +1,1571 @@
+/***************************************************************************//**
+*   @file   jesd_eye_data.c
+*   @brief  JESD204 Eye Scan Data Decoding
+*   @author Michael Hennerich (michael.hennerich@analog.com)
+********************************************************************************
+* Copyright 2026(c) Analog Devices, Inc. All rights reserved.
+*
+* An ADI specific BSD license, which can be found in the top level directory
+* of this repository (LICENSE.txt), and also on-line at:
+* https://github.com/analogdevicesinc/jesd-eye-scan-gtk/blob/main/LICENSE.txt
+*******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include <pthread.h>
+
+#if defined(__SSE2__) && !defined(JESD_NO_SIMD)
+#include <emmintrin.h>
+#define JESD_HEX_SSE2
+#elif defined(__ARM_NEON) && !defined(JESD_NO_SIMD)
+#include <arm_neon.h>
+#define JESD_HEX_NEON
+#endif
+
+/* The BER map needs a vector divide, NEON has it on AArch64 only */
+#if defined(JESD_HEX_SSE2)
+#define JESD_BER_SSE2
+#elif defined(JESD_HEX_NEON) && defined(__aarch64__)
+#define JESD_BER_NEON
+#endif
+
+#include "jesd_eye_data.h"
+
+#define HEX_BLOCK	16
+#define EYE_HASH_SIZE	256
+
+static struct {
+	pthread_mutex_t lock;
+	struct jesd_eye *hash[EYE_HASH_SIZE];
+	struct jesd_eye *head;	/* most recently used */
+	struct jesd_eye *tail;
+	size_t bytes;
+	size_t max_bytes;
+} eye_cache = {
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+	.max_bytes = JESD_EYE_CACHE_SIZE,
+};
+
+void jesd_hex_decoder_init(struct jesd_hex_decoder *dec, void *out,
+			   unsigned elem_size, unsigned cnt)
+{
+	memset(dec, 0, sizeof(*dec));
+	dec->out = out;
+	dec->elem_size = elem_size;
+	dec->cnt = cnt;
+}
+
+static inline void hex_emit(struct jesd_hex_decoder *dec)
+{
+	if (dec->elem_size == 4)
+		((uint32_t *)dec->out)[dec->idx] = (uint32_t)dec->acc;
+	else
+		((uint64_t *)dec->out)[dec->idx] = dec->acc;
+
+	dec->idx++;
+	dec->acc = 0;
+	dec->digits = 0;
+}
+
+static inline int hex_nibble(unsigned char c)
+{
+	if ((unsigned char)(c - '0') < 10)
+		return c - '0';
+
+	c |= 0x20;
+	if ((unsigned char)(c - 'a') < 6)
+		return c - 'a' + 10;
+
+	return -1;
+}
+
+static inline void hex_decode_char(struct jesd_hex_decoder *dec, unsigned char c)
+{
+	int nib = hex_nibble(c);
+
+	if (nib >= 0) {
+		dec->acc = (dec->acc << 4) | nib;
+		dec->digits++;
+	} else if ((c | 0x20) == 'x') {
+		/* "0x" prefix */
+		dec->acc = 0;
+		dec->digits = 0;
+	} else if (dec->digits) {
+		hex_emit(dec);
+	}
+}
+
+/*
+ * Classify 16 characters at once: nibble values of all hex digits go to @nib,
+ * the returned mask has a bit set for every hex digit, @xmask for every 'x'.
+ */
+#if defined(JESD_HEX_SSE2)
+static inline unsigned hex_classify(const char *p, uint8_t nib[HEX_BLOCK],
+				    unsigned *xmask)
+{
+	__m128i v = _mm_loadu_si128((const __m128i *)p);
+	__m128i lc = _mm_or_si128(v, _mm_set1_epi8(0x20));
+	__m128i dig, alp, val;
+
+	dig = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('0' - 1)),
+			    _mm_cmplt_epi8(v, _mm_set1_epi8('9' + 1)));
+	alp = _mm_and_si128(_mm_cmpgt_epi8(lc, _mm_set1_epi8('a' - 1)),
+			    _mm_cmplt_epi8(lc, _mm_set1_epi8('f' + 1)));
+	val = _mm_or_si128(_mm_and_si128(dig, _mm_sub_epi8(v, _mm_set1_epi8('0'))),
+			   _mm_and_si128(alp, _mm_sub_epi8(lc, _mm_set1_epi8('a' - 10))));
+
+	_mm_storeu_si128((__m128i *)nib, val);
+	*xmask = _mm_movemask_epi8(_mm_cmpeq_epi8(lc, _mm_set1_epi8('x')));
+
+	return _mm_movemask_epi8(_mm_or_si128(dig, alp));
+}
+#elif defined(JESD_HEX_NEON)
+static inline unsigned neon_movemask(uint8x16_t m)
+{
+	static const uint8_t bits[16] = {
+		1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128
+	};
+	uint8x16_t t = vandq_u8(m, vld1q_u8(bits));
+	uint8x8_t s = vpadd_u8(vget_low_u8(t), vget_high_u8(t));
+
+	s = vpadd_u8(s, s);
+	s = vpadd_u8(s, s);
+
+	return vget_lane_u8(s, 0) | (vget_lane_u8(s, 1) << 8);
+}
+
+static inline unsigned hex_classify(const char *p, uint8_t nib[HEX_BLOCK],
+				    unsigned *xmask)
+{
+	uint8x16_t v = vld1q_u8((const uint8_t *)p);
+	uint8x16_t lc = vorrq_u8(v, vdupq_n_u8(0x20));
+	uint8x16_t dv = vsubq_u8(v, vdupq_n_u8('0'));
+	uint8x16_t av = vsubq_u8(lc, vdupq_n_u8('a'));
+	uint8x16_t dig = vcltq_u8(dv, vdupq_n_u8(10));
+	uint8x16_t alp = vcltq_u8(av, vdupq_n_u8(6));
+
+	vst1q_u8(nib, vbslq_u8(dig, dv, vaddq_u8(av, vdupq_n_u8(10))));
+	*xmask = neon_movemask(vceqq_u8(lc, vdupq_n_u8('x')));
+
+	return neon_movemask(vorrq_u8(dig, alp));
+}
+#else
+static inline unsigned hex_classify(const char *p, uint8_t nib[HEX_BLOCK],
+				    unsigned *xmask)
+{
+	unsigned i, mask = 0;
+	int n;
+
+	*xmask = 0;
+
+	for (i = 0; i < HEX_BLOCK; i++) {
+		n = hex_nibble(p[i]);
+		nib[i] = n;
+		if (n >= 0)
+			mask |= 1U << i;
+		else if ((p[i] | 0x20) == 'x')
+			*xmask |= 1U << i;
+	}
+
+	return mask;
+}
+#endif
+
+/*
+ * Decode @len characters of @buf, returns the number of values completed.
+ * Runs of hex digits are folded into the accumulator a whole run at a time,
+ * separators (',', whitespace, NUL) end a value.
+ */
+unsigned jesd_hex_decode(struct jesd_hex_decoder *dec, const char *buf,
+			 size_t len)
+{
+	unsigned start = dec->idx;
+	uint8_t nib[HEX_BLOCK];
+	unsigned hexmask, xmask, pos, run, k;
+	size_t i = 0;
+
+	for (; i + HEX_BLOCK <= len && dec->idx < dec->cnt; i += HEX_BLOCK) {
+		hexmask = hex_classify(buf + i, nib, &xmask);
+		pos = 0;
+
+		while (pos < HEX_BLOCK && dec->idx < dec->cnt) {
+			run = __builtin_ctz(~(hexmask >> pos));
+			if (run) {
+				for (k = pos; k < pos + run; k++)
+					dec->acc = (dec->acc << 4) | nib[k];
+				dec->digits += run;
+				pos += run;
+				continue;
+			}
+
+			if (xmask & (1U << pos)) {
+				dec->acc = 0;
+				dec->digits = 0;
+			} else if (dec->digits) {
+				hex_emit(dec);
+			}
+			pos++;
+		}
+	}
+
+	for (; i < len && dec->idx < dec->cnt; i++)
+		hex_decode_char(dec, buf[i]);
+
+	return dec->idx - start;
+}
+
+/* Flush a trailing value that was not followed by a separator */
+unsigned jesd_hex_decoder_finish(struct jesd_hex_decoder *dec)
+{
+	if (dec->digits && dec->idx < dec->cnt) {
+		hex_emit(dec);
+		return 1;
+	}
+
+	return 0;
+}
+
+double calc_ber(struct jesd204b_xcvr_eyescan_info *info,
+		unsigned long long smpl, unsigned prescale)
+{
+	unsigned long long err_ut0, err_ut1, cnt_ut0, cnt_ut1;
+	double ber;
+
+	if (info->lpm) {
+		err_ut0 = smpl & 0xFFFF;
+		cnt_ut0 = (smpl >> 16) & 0xFFFF;
+
+		if ((err_ut0) == 0) {
+			ber = 1 / (double)((info->cdr_data_width << (1 + prescale)) * cnt_ut0);
+		} else {
+			ber = err_ut0 / (double)((info->cdr_data_width << (1 + prescale)) * cnt_ut0);
+		}
+
+	} else {
+		err_ut0 = smpl & 0xFFFF;
+		err_ut1 = (smpl >> 32) & 0xFFFF;
+		cnt_ut0 = (smpl >> 16) & 0xFFFF;
+		cnt_ut1 = (smpl >> 48) & 0xFFFF;
+
+		if ((err_ut0 + err_ut1) == 0)
+			ber =
+				1 / (double)((info->cdr_data_width << (1 + prescale)) *
+					     (cnt_ut0 + cnt_ut1));
+		else	/* the denominator exceeds 64 bit at high prescales */
+			ber = (err_ut0 * cnt_ut1 + err_ut1 * cnt_ut0) /
+			      (2.0 * (info->cdr_data_width << (1 + prescale)) * cnt_ut0 * cnt_ut1);
+	}
+
+	return ber;
+}
+
+/* =================================================================== */
+/* log10(BER) map */
+/* =================================================================== */
+
+/*
+ * Same as log10(calc_ber()) per sample, but with everything prescale dependent
+ * hoisted out of the loop and computed in single precision:
+ *
+ *   LPM: max(err, 1) / (K * cnt)
+ *   DFE: 1 / (K * (cnt0 + cnt1))                             no errors
+ *        (err0 * cnt1 + err1 * cnt0) / (2 * K * cnt0 * cnt1)  otherwise
+ *
+ * with K = cdr_data_width << (1 + prescale). Empty counters give +inf.
+ */
+#define LOG10_2		0.30102999566398119521f
+#define LOG10_E		0.43429448190325182765f
+#define SQRT_2		1.41421356237309504880f
+
+static inline float ber_log10_scalar(float num, float den)
+{
+	if (den == 0.0f)
+		return INFINITY;
+
+	return log10f(num / den);
+}
+
+static void log_ber_lpm_scalar(const uint32_t *smpl, unsigned cnt, float k,
+			       float *out)
+{
+	unsigned i;
+
+	for (i = 0; i < cnt; i++) {
+		uint32_t err = smpl[i] & 0xFFFF;
+
+		out[i] = ber_log10_scalar(err ? err : 1, k * (smpl[i] >> 16));
+	}
+}
+
+static void log_ber_dfe_scalar(const uint64_t *smpl, unsigned cnt, float k,
+			       float *out)
+{
+	unsigned i;
+
+	for (i = 0; i < cnt; i++) {
+		float err0 = smpl[i] & 0xFFFF;
+		float cnt0 = (smpl[i] >> 16) & 0xFFFF;
+		float err1 = (smpl[i] >> 32) & 0xFFFF;
+		float cnt1 = (smpl[i] >> 48) & 0xFFFF;
+
+		if (err0 + err1 == 0)
+			out[i] = ber_log10_scalar(1, k * (cnt0 + cnt1));
+		else
+			out[i] = ber_log10_scalar(err0 * cnt1 + err1 * cnt0,
+						  2 * k * cnt0 * cnt1);
+	}
+}
+
+#if defined(JESD_BER_SSE2)
+/*
+ * log10 of positive normal floats: x = m * 2^e with m in [sqrt(2)/2, sqrt(2)),
+ * ln(m) = 2 atanh(t), t = (m - 1) / (m + 1), |t| < 0.172, series to t^9.
+ */
+static inline __m128 log10_ps(__m128 x)
+{
+	__m128i bits = _mm_castps_si128(x);
+	__m128i e = _mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(127));
+	__m128 m = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits,
+					_mm_set1_epi32(0x007FFFFF)), _mm_set1_epi32(0x3F800000)));
+	__m128 big = _mm_cmpgt_ps(m, _mm_set1_ps(SQRT_2));
+	__m128 one = _mm_set1_ps(1.0f);
+	__m128 t, t2, p;
+
+	m = _mm_mul_ps(m, _mm_or_ps(_mm_and_ps(big, _mm_set1_ps(0.5f)),
+				    _mm_andnot_ps(big, one)));
+	e = _mm_sub_epi32(e, _mm_castps_si128(big));	/* mask is -1 */
+
+	t = _mm_div_ps(_mm_sub_ps(m, one), _mm_add_ps(m, one));
+	t2 = _mm_mul_ps(t, t);
+	p = _mm_add_ps(_mm_mul_ps(t2, _mm_set1_ps(1.0f / 9)), _mm_set1_ps(1.0f / 7));
+	p = _mm_add_ps(_mm_mul_ps(t2, p), _mm_set1_ps(1.0f / 5));
+	p = _mm_add_ps(_mm_mul_ps(t2, p), _mm_set1_ps(1.0f / 3));
+	p = _mm_add_ps(_mm_mul_ps(t2, p), one);
+	p = _mm_mul_ps(_mm_mul_ps(t, p), _mm_set1_ps(2 * LOG10_E));
+
+	return _mm_add_ps(p, _mm_mul_ps(_mm_cvtepi32_ps(e), _mm_set1_ps(LOG10_2)));
+}
+
+static inline __m128 ber_log10_ps(__m128 num, __m128 den)
+{
+	__m128 empty = _mm_cmpeq_ps(den, _mm_setzero_ps());
+	__m128 r = log10_ps(_mm_div_ps(num, den));
+
+	return _mm_or_ps(_mm_andnot_ps(empty, r),
+			 _mm_and_ps(empty, _mm_set1_ps(INFINITY)));
+}
+
+static unsigned log_ber_lpm(const uint32_t *smpl, unsigned cnt, float k,
+			    float *out)
+{
+	__m128i mask = _mm_set1_epi32(0xFFFF);
+	__m128 vk = _mm_set1_ps(k), one = _mm_set1_ps(1.0f);
+	unsigned i;
+
+	for (i = 0; i + 4 <= cnt; i += 4) {
+		__m128i v = _mm_loadu_si128((const __m128i *)(smpl + i));
+		__m128 err = _mm_cvtepi32_ps(_mm_and_si128(v, mask));
+		__m128 n = _mm_cvtepi32_ps(_mm_srli_epi32(v, 16));
+
+		_mm_storeu_ps(out + i, ber_log10_ps(_mm_max_ps(err, one),
+						    _mm_mul_ps(vk, n)));
+	}
+
+	return i;
+}
+
+static unsigned log_ber_dfe(const uint64_t *smpl, unsigned cnt, float k,
+			    float *out)
+{
+	__m128i mask = _mm_set1_epi32(0xFFFF);
+	__m128 vk = _mm_set1_ps(k), vk2 = _mm_set1_ps(2 * k);
+	__m128 one = _mm_set1_ps(1.0f), zero = _mm_setzero_ps();
+	unsigned i;
+
+	for (i = 0; i + 4 <= cnt; i += 4) {
+		__m128 a = _mm_loadu_ps((const float *)(smpl + i));
+		__m128 b = _mm_loadu_ps((const float *)(smpl + i + 2));
+		/* Deinterleave the low (ut0) and high (ut1) words */
+		__m128i lo = _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+		__m128i hi = _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+		__m128 err0 = _mm_cvtepi32_ps(_mm_and_si128(lo, mask));
+		__m128 cnt0 = _mm_cvtepi32_ps(_mm_srli_epi32(lo, 16));
+		__m128 err1 = _mm_cvtepi32_ps(_mm_and_si128(hi, mask));
+		__m128 cnt1 = _mm_cvtepi32_ps(_mm_srli_epi32(hi, 16));
+		__m128 clean = _mm_cmpeq_ps(_mm_add_ps(err0, err1), zero);
+		__m128 num, den;
+
+		num = _mm_add_ps(_mm_mul_ps(err0, cnt1), _mm_mul_ps(err1, cnt0));
+		den = _mm_mul_ps(vk2, _mm_mul_ps(cnt0, cnt1));
+		num = _mm_or_ps(_mm_and_ps(clean, one), _mm_andnot_ps(clean, num));
+		den = _mm_or_ps(_mm_and_ps(clean, _mm_mul_ps(vk, _mm_add_ps(cnt0, cnt1))),
+				_mm_andnot_ps(clean, den));
+
+		_mm_storeu_ps(out + i, ber_log10_ps(num, den));
+	}
+
+	return i;
+}
+#elif defined(JESD_BER_NEON)
+static inline float32x4_t log10_ps(float32x4_t x)
+{
+	uint32x4_t bits = vreinterpretq_u32_f32(x);
+	int32x4_t e = vsubq_s32(vreinterpretq_s32_u32(vshrq_n_u32(bits, 23)),
+				vdupq_n_s32(127));
+	float32x4_t m = vreinterpretq_f32_u32(vorrq_u32(vandq_u32(bits,
+					vdupq_n_u32(0x007FFFFF)), vdupq_n_u32(0x3F800000)));
+	uint32x4_t big = vcgtq_f32(m, vdupq_n_f32(SQRT_2));
+	float32x4_t one = vdupq_n_f32(1.0f);
+	float32x4_t t, t2, p;
+
+	m = vbslq_f32(big, vmulq_n_f32(m, 0.5f), m);
+	e = vsubq_s32(e, vreinterpretq_s32_u32(big));	/* mask is -1 */
+
+	t = vdivq_f32(vsubq_f32(m, one), vaddq_f32(m, one));
+	t2 = vmulq_f32(t, t);
+	p = vmlaq_f32(vdupq_n_f32(1.0f / 7), t2, vdupq_n_f32(1.0f / 9));
+	p = vmlaq_f32(vdupq_n_f32(1.0f / 5), t2, p);
+	p = vmlaq_f32(vdupq_n_f32(1.0f / 3), t2, p);
+	p = vmlaq_f32(one, t2, p);
+	p = vmulq_n_f32(vmulq_f32(t, p), 2 * LOG10_E);
+
+	return vmlaq_n_f32(p, vcvtq_f32_s32(e), LOG10_2);
+}
+
+static inline float32x4_t ber_log10_ps(float32x4_t num, float32x4_t den)
+{
+	uint32x4_t empty = vceqq_f32(den, vdupq_n_f32(0.0f));
+
+	return vbslq_f32(empty, vdupq_n_f32(INFINITY),
+			 log10_ps(vdivq_f32(num, den)));
+}
+
+static unsigned log_ber_lpm(const uint32_t *smpl, unsigned cnt, float k,
+			    float *out)
+{
+	uint32x4_t mask = vdupq_n_u32(0xFFFF);
+	float32x4_t one = vdupq_n_f32(1.0f);
+	unsigned i;
+
+	for (i = 0; i + 4 <= cnt; i += 4) {
+		uint32x4_t v = vld1q_u32(smpl + i);
+		float32x4_t err = vcvtq_f32_u32(vandq_u32(v, mask));
+		float32x4_t n = vcvtq_f32_u32(vshrq_n_u32(v, 16));
+
+		vst1q_f32(out + i, ber_log10_ps(vmaxq_f32(err, one),
+						vmulq_n_f32(n, k)));
+	}
+
+	return i;
+}
+
+static unsigned log_ber_dfe(const uint64_t *smpl, unsigned cnt, float k,
+			    float *out)
+{
+	uint32x4_t mask = vdupq_n_u32(0xFFFF);
+	float32x4_t one = vdupq_n_f32(1.0f);
+	unsigned i;
+
+	for (i = 0; i + 4 <= cnt; i += 4) {
+		/* val[0] low (ut0), val[1] high (ut1) words */
+		uint32x4x2_t v = vld2q_u32((const uint32_t *)(smpl + i));
+		float32x4_t err0 = vcvtq_f32_u32(vandq_u32(v.val[0], mask));
+		float32x4_t cnt0 = vcvtq_f32_u32(vshrq_n_u32(v.val[0], 16));
+		float32x4_t err1 = vcvtq_f32_u32(vandq_u32(v.val[1], mask));
+		float32x4_t cnt1 = vcvtq_f32_u32(vshrq_n_u32(v.val[1], 16));
+		uint32x4_t clean = vceqq_f32(vaddq_f32(err0, err1), vdupq_n_f32(0.0f));
+		float32x4_t num, den;
+
+		num = vmlaq_f32(vmulq_f32(err0, cnt1), err1, cnt0);
+		den = vmulq_n_f32(vmulq_f32(cnt0, cnt1), 2 * k);
+		num = vbslq_f32(clean, one, num);
+		den = vbslq_f32(clean, vmulq_n_f32(vaddq_f32(cnt0, cnt1), k), den);
+
+		vst1q_f32(out + i, ber_log10_ps(num, den));
+	}
+
+	return i;
+}
+#else
+static unsigned log_ber_lpm(const uint32_t *smpl, unsigned cnt, float k,
+			    float *out)
+{
+	return 0;
+}
+
+static unsigned log_ber_dfe(const uint64_t *smpl, unsigned cnt, float k,
+			    float *out)
+{
+	return 0;
+}
+#endif
+
+void jesd_eye_log_ber_map(const struct jesd204b_xcvr_eyescan_info *info,
+			  unsigned prescale, const void *data, unsigned cnt,
+			  float *log_ber)
+{
+	float k = (float)(info->cdr_data_width << (1 + prescale));
+	unsigned done;
+
+	if (info->lpm) {
+		done = log_ber_lpm(data, cnt, k, log_ber);
+		log_ber_lpm_scalar((const uint32_t *)data + done, cnt - done, k,
+				   log_ber + done);
+	} else {
+		done = log_ber_dfe(data, cnt, k, log_ber);
+		log_ber_dfe_scalar((const uint64_t *)data + done, cnt - done, k,
+				   log_ber + done);
+	}
+}
+
+static int eye_has_errors(const struct jesd_eye *eye, unsigned idx)
+{
+	if (eye->info.lpm)
+		return ((const uint32_t *)eye->data)[idx] & 0x0000FFFF;
+
+	return !!(((const uint64_t *)eye->data)[idx] & 0xFFFF0000FFFFULL);
+}
+
+void jesd_eye_analyse(const struct jesd_eye *eye, struct jesd_eye_opening *op)
+{
+	unsigned width = eye->info.es_hsize, height = eye->info.es_vsize;
+	unsigned x, y;
+
+	op->xmin = -1;
+	op->xmax = -1;
+	y = (height + 1) / 2;
+
+	for (x = 0; x < width; x++) {
+		if (!eye_has_errors(eye, y * width + x)) {
+			if (op->xmin == -1)
+				op->xmin = x;
+
+			op->xmax = x;
+		}
+	}
+
+	op->ymin = -1;
+	op->ymax = -1;
+	x = (width + 1) / 2;
+
+	for (y = 0; y < height; y++) {
+		if (!eye_has_errors(eye, y * width + x)) {
+			if (op->ymin == -1)
+				op->ymin = y;
+
+			op->ymax = y;
+		}
+	}
+
+	y = (height + 1) / 2;
+	x = (width + 1) / 2;
+	op->xmin -= x;
+	op->xmax -= x;
+	op->ymin -= y;
+	op->ymax -= y;
+
+	op->h_ui = (float)op->xmax / ((float)width) - (float)op->xmin / ((float)width);
+	op->v_codes = op->ymax - op->ymin;
+
+	op->open_samples = 0;
+	for (x = 0; x < eye->cnt; x++)
+		op->open_samples += !eye_has_errors(eye, x);
+}
+
+/*
+ * Feed the opening of the next deeper prescale of a lane. A deeper prescale
+ * only lowers the BER floor of samples that saw no errors yet, so without any
+ * such samples nothing can change anymore. Otherwise the lane is considered
+ * converged once the opening moved by no more than one sample on each side
+ * for JESD_EYE_STABLE_STEPS consecutive prescales.
+ */
+int jesd_eye_converged(struct jesd_eye_convergence *conv,
+		       const struct jesd_eye_opening *op)
+{
+	const struct jesd_eye_opening *last = &conv->last;
+
+	if (!op->open_samples)
+		return 1;
+
+	if (conv->valid && abs(op->xmin - last->xmin) <= 1 &&
+	    abs(op->xmax - last->xmax) <= 1 && abs(op->ymin - last->ymin) <= 1 &&
+	    abs(op->ymax - last->ymax) <= 1)
+		conv->stable++;
+	else
+		conv->stable = 0;
+
+	conv->last = *op;
+	conv->valid = 1;
+
+	return conv->stable >= JESD_EYE_STABLE_STEPS;
+}
+
+/* =================================================================== */
+/* Eye result cache */
+/* =================================================================== */
+
+static unsigned eye_hash(const char *device, unsigned lane, unsigned prescale)
+{
+	unsigned h = 2166136261U;
+
+	while (*device)
+		h = (h ^ (unsigned char)*device++) * 16777619U;
+
+	h = (h ^ lane) * 16777619U;
+	h = (h ^ prescale) * 16777619U;
+
+	return h % EYE_HASH_SIZE;
+}
+
+static size_t eye_bytes(const struct jesd_eye *eye)
+{
+	return sizeof(*eye) + eye->size +
+	       (eye->log_ber ? eye->cnt * sizeof(*eye->log_ber) : 0);
+}
+
+static void eye_free(struct jesd_eye *eye)
+{
+	free(eye->data);
+	free(eye->log_ber);
+	free(eye);
+}
+
+static void eye_lru_unlink(struct jesd_eye *eye)
+{
+	if (eye->prev)
+		eye->prev->next = eye->next;
+	else
+		eye_cache.head = eye->next;
+
+	if (eye->next)
+		eye->next->prev = eye->prev;
+	else
+		eye_cache.tail = eye->prev;
+
+	eye->prev = NULL;
+	eye->next = NULL;
+}
+
+static void eye_lru_push(struct jesd_eye *eye)
+{
+	eye->next = eye_cache.head;
+	if (eye_cache.head)
+		eye_cache.head->prev = eye;
+	eye_cache.head = eye;
+
+	if (!eye_cache.tail)
+		eye_cache.tail = eye;
+}
+
+/* Drop @eye from the cache, it is freed once the last reference is gone */
+static void eye_detach(struct jesd_eye *eye)
+{
+	struct jesd_eye **pp;
+
+	pp = &eye_cache.hash[eye_hash(eye->info.gt_interface_path, eye->lane,
+				      eye->prescale)];
+	while (*pp && *pp != eye)
+		pp = &(*pp)->hnext;
+	if (*pp)
+		*pp = eye->hnext;
+
+	eye_lru_unlink(eye);
+	eye_cache.bytes -= eye_bytes(eye);
+	eye->cached = 0;
+
+	if (!eye->refcnt)
+		eye_free(eye);
+}
+
+static void eye_evict(void)
+{
+	struct jesd_eye *eye = eye_cache.tail, *prev;
+
+	while (eye && eye_cache.bytes > eye_cache.max_bytes) {
+		prev = eye->prev;
+		if (!eye->refcnt)
+			eye_detach(eye);
+		eye = prev;
+	}
+}
+
+static struct jesd_eye *eye_lookup(const char *device, unsigned lane,
+				   unsigned prescale)
+{
+	struct jesd_eye *eye;
+
+	eye = eye_cache.hash[eye_hash(device, lane, prescale)];
+	for (; eye; eye = eye->hnext)
+		if (eye->lane == lane && eye->prescale == prescale &&
+		    !strcmp(eye->info.gt_interface_path, device))
+			return eye;
+
+	return NULL;
+}
+
+void jesd_eye_cache_set_limit(size_t max_bytes)
+{
+	pthread_mutex_lock(&eye_cache.lock);
+	eye_cache.max_bytes = max_bytes;
+	eye_evict();
+	pthread_mutex_unlock(&eye_cache.lock);
+}
+
+void jesd_eye_cache_clear(void)
+{
+	pthread_mutex_lock(&eye_cache.lock);
+	while (eye_cache.head)
+		eye_detach(eye_cache.head);
+	pthread_mutex_unlock(&eye_cache.lock);
+}
+
+/*
+ * Add the samples in @data (malloc()ed, ownership is taken over) to the cache.
+ * Returns a referenced entry, or NULL in which case @data was freed.
+ */
+struct jesd_eye *jesd_eye_cache_insert(const struct jesd204b_xcvr_eyescan_info *info,
+				       unsigned lane, unsigned prescale,
+				       void *data)
+{
+	struct jesd_eye *eye, *old;
+	unsigned h;
+
+	eye = calloc(1, sizeof(*eye));
+	if (!eye) {
+		free(data);
+		return NULL;
+	}
+
+	eye->info = *info;
+	eye->lane = lane;
+	eye->prescale = prescale;
+	eye->cnt = info->es_hsize * info->es_vsize;
+	eye->size = (size_t)eye->cnt * (info->lpm ? 4 : 8);
+	eye->data = data;
+	eye->refcnt = 1;
+	eye->cached = 1;
+
+	h = eye_hash(info->gt_interface_path, lane, prescale);
+
+	pthread_mutex_lock(&eye_cache.lock);
+
+	old = eye_lookup(info->gt_interface_path, lane, prescale);
+	if (old)
+		eye_detach(old);
+
+	eye->hnext = eye_cache.hash[h];
+	eye_cache.hash[h] = eye;
+	eye_lru_push(eye);
+	eye_cache.bytes += eye_bytes(eye);
+	eye_evict();
+
+	pthread_mutex_unlock(&eye_cache.lock);
+
+	return eye;
+}
+
+/* Returns a referenced entry, release it with jesd_eye_put() */
+struct jesd_eye *jesd_eye_cache_get(const char *device, unsigned lane,
+				    unsigned prescale)
+{
+	struct jesd_eye *eye;
+
+	pthread_mutex_lock(&eye_cache.lock);
+
+	eye = eye_lookup(device, lane, prescale);
+	if (eye) {
+		eye->refcnt++;
+		eye_lru_unlink(eye);
+		eye_lru_push(eye);
+	}
+
+	pthread_mutex_unlock(&eye_cache.lock);
+
+	return eye;
+}
+
+void jesd_eye_put(struct jesd_eye *eye)
+{
+	if (!eye)
+		return;
+
+	pthread_mutex_lock(&eye_cache.lock);
+
+	if (!--eye->refcnt) {
+		if (!eye->cached)
+			eye_free(eye);
+		else
+			eye_evict();
+	}
+
+	pthread_mutex_unlock(&eye_cache.lock);
+}
+
+/* log10(BER) of every sample, computed once per entry */
+const float *jesd_eye_log_ber(struct jesd_eye *eye)
+{
+	float *log_ber;
+
+	pthread_mutex_lock(&eye_cache.lock);
+
+	if (eye->log_ber)
+		goto out;
+
+	log_ber = malloc(eye->cnt * sizeof(*log_ber));
+	if (!log_ber)
+		goto out;
+
+	jesd_eye_log_ber_map(&eye->info, eye->prescale, eye->data, eye->cnt,
+			     log_ber);
+
+	if (eye->cached)
+		eye_cache.bytes -= eye_bytes(eye);
+	eye->log_ber = log_ber;
+	if (eye->cached)
+		eye_cache.bytes += eye_bytes(eye);
+out:
+	pthread_mutex_unlock(&eye_cache.lock);
+
+	return eye->log_ber;
+}
+
+int jesd_eye_save(const struct jesd_eye *eye, const char *file)
+{
+	FILE *pFile;
+	size_t ret;
+
+	pFile = fopen(file, "w");
+	if (pFile == NULL)
+		return -errno;
+
+	ret = fwrite(eye->data, eye->info.lpm ? 4 : 8, eye->cnt, pFile);
+	fclose(pFile);
+
+	return ret == eye->cnt ? 0 : -EIO;
+}
+
+/* Bring a persisted eye back into the cache */
+struct jesd_eye *jesd_eye_load(const struct jesd204b_xcvr_eyescan_info *info,
+			       unsigned lane, unsigned prescale,
+			       const char *file)
+{
+	unsigned cnt = info->es_hsize * info->es_vsize;
+	size_t elem_size = info->lpm ? 4 : 8, ret;
+	FILE *pFile;
+	void *data;
+
+	data = malloc(cnt * elem_size);
+	if (!data)
+		return NULL;
+
+	pFile = fopen(file, "r");
+	if (pFile == NULL) {
+		free(data);
+		return NULL;
+	}
+
+	ret = fread(data, elem_size, cnt, pFile);
+	fclose(pFile);
+
+	if (ret != cnt) {
+		free(data);
+		return NULL;
+	}
+
+	return jesd_eye_cache_insert(info, lane, prescale, data);
+}
+
+/* =================================================================== */
+/* Timing report */
+/* =================================================================== */
+
+void jesd_eye_timing_add(struct jesd_eye_timing *sum,
+			 const struct jesd_eye_timing *t)
+{
+	sum->arm_us += t->arm_us;
+	sum->queue_us += t->queue_us;
+	sum->wait_us += t->wait_us;
+	sum->xfer_us += t->xfer_us;
+	sum->decode_us += t->decode_us;
+	sum->analyse_us += t->analyse_us;
+	sum->persist_us += t->persist_us;
+	sum->eyes += t->eyes;
+}
+
+void jesd_eye_timing_print(void *err, const char *name,
+			   const struct jesd_eye_timing *t)
+{
+	print_output_sys(err, "%s: %u eyes, arm %.3f s, queue %.3f s, wait %.3f s, "
+			 "transfer %.3f s, decode %.3f s, analysis %.3f s, persist %.3f s\n",
+			 name, t->eyes, t->arm_us / 1e6, t->queue_us / 1e6,
+			 t->wait_us / 1e6, t->xfer_us / 1e6, t->decode_us / 1e6,
+			 t->analyse_us / 1e6, t->persist_us / 1e6);
+}
+
+static void timing_json(FILE *f, const struct jesd_eye_timing *t)
+{
+	fprintf(f, "\"eyes\": %u, \"arm_us\": %llu, \"queue_us\": %llu, "
+		"\"wait_us\": %llu, \"xfer_us\": %llu, \"decode_us\": %llu, "
+		"\"analyse_us\": %llu, \"persist_us\": %llu",
+		t->eyes, t->arm_us, t->queue_us, t->wait_us, t->xfer_us,
+		t->decode_us, t->analyse_us, t->persist_us);
+}
+
+/* Device names come from sysfs or libiio, quote what JSON cannot take */
+static void json_string(FILE *f, const char *str)
+{
+	fputc('"', f);
+
+	for (; *str; str++) {
+		if (*str == '"' || *str == '\\')
+			fprintf(f, "\\%c", *str);
+		else if ((unsigned char)*str < 0x20)
+			fprintf(f, "\\u%04x", *str);
+		else
+			fputc(*str, f);
+	}
+
+	fputc('"', f);
+}
+
+/* Writes the per eye phases and their totals as a JSON timing report */
+int jesd_eye_timing_save(const char *file,
+			 const struct jesd_eye_timing_entry *entries,
+			 unsigned num)
+{
+	struct jesd_eye_timing total = { 0 };
+	unsigned i;
+	FILE *f;
+	int ret;
+
+	f = fopen(file, "w");
+	if (f == NULL)
+		return -errno;
+
+	fprintf(f, "{\n  \"eyes\": [\n");
+
+	for (i = 0; i < num; i++) {
+		fprintf(f, "    { \"device\": ");
+		json_string(f, entries[i].device);
+		fprintf(f, ", \"lane\": %u, \"prescale\": %u, ",
+			entries[i].lane, entries[i].prescale);
+		timing_json(f, &entries[i].t);
+		fprintf(f, " }%s\n", i + 1 < num ? "," : "");
+		jesd_eye_timing_add(&total, &entries[i].t);
+	}
+
+	fprintf(f, "  ],\n  \"total\": { ");
+	timing_json(f, &total);
+	fprintf(f, " }\n}\n");
+
+	ret = ferror(f) ? -EIO : 0;
+	if (fclose(f) && !ret)
+		ret = -errno;
+
+	return ret;
+}
+
+/* =================================================================== */
+/* Acquisition */
+/* =================================================================== */
+
+int read_eyescan_info(const char *basedir,
+		      struct jesd204b_xcvr_eyescan_info *info)
+{
+	FILE *pFile;
+	char temp[PATH_MAX];
+	int ret;
+
+	if ((g_jesd_iio_ctx && strstr(basedir, "iio:")) || jesd_backend_path(basedir)) {
+		char buf[1024];
+		ret = jesd_read_attr(basedir, "eyescan_info", buf, sizeof(buf));
+		if (ret < 0) {
+			print_output_sys(stderr, "Failed to read eyescan_info attribute\n");
+			print_output_sys(stderr, "Select axi-adxcvr-rx device!\n");
+			return ret;
+		}
+
+		pFile = fmemopen(buf, strlen(buf), "r");
+		if (!pFile) {
+			return -errno;
+		}
+	} else {
+		snprintf(temp, sizeof(temp), "%s/eyescan_info", basedir);
+		pFile = fopen(temp, "r");
+
+		if (pFile == NULL) {
+			print_output_sys(stderr, "Failed to read JESD204 device file: %s\n",
+					 temp);
+
+			print_output_sys(stderr, "Select axi-adxcvr-rx device!\n");
+
+			return -errno;
+		}
+	}
+
+	ret = fscanf(pFile, "x%d,y%d CDRDW: %llu LPM: %d NL: %d LR: %lu\n",
+		     &info->es_hsize, &info->es_vsize, &info->cdr_data_width,
+		     &info->lpm, &info->num_lanes, &info->lane_rate);
+
+	fclose(pFile);
+
+	if (ret != 6) {
+		print_output_sys(stderr, "Failed to read full eyescan_info\n");
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+/*
+ * Expected duration of a full 2D scan: every point accumulates up to 0xFFFF
+ * times (CDR data width << (1 + prescale)) bits at the lane rate (kbps).
+ */
+static unsigned long long eye_scan_time_us(struct jesd204b_xcvr_eyescan_info *info,
+					   unsigned prescale)
+{
+	double bits = (double)(info->cdr_data_width << (1 + prescale)) * 0xFFFF;
+
+	if (!info->lane_rate)
+		return 0;
+
+	return bits * info->es_hsize * info->es_vsize * 1000.0 / info->lane_rate;
+}
+
+#define JESD_EYE_CHUNK_SIZE	4095	/* eye_data_partial, 4096 - 1 for null terminator */
+
+/* Undecoded eye data, hex text (libiio) or binary samples (sysfs) */
+struct jesd_eye_raw {
+	char *buf;
+	size_t size;
+	size_t len;
+	int hex;
+};
+
+static int eye_samples(const struct jesd204b_xcvr_eyescan_info *info,
+		       unsigned *cnt, size_t *elem_size)
+{
+	/* Check for integer overflow */
+	if (info->es_hsize > 0 && info->es_vsize > UINT_MAX / info->es_hsize)
+		return -EINVAL;
+
+	*cnt = info->es_hsize * info->es_vsize;	/* X,Y */
+	*elem_size = info->lpm ? 4 : 8;
+
+	/* Check for malloc size overflow */
+	if (*cnt > 0 && *elem_size > SIZE_MAX / *cnt)
+		return -EINVAL;
+
+	return 0;
+}
+
+static int eye_raw_reserve(struct jesd_eye_raw *raw, size_t size)
+{
+	char *buf;
+
+	if (size <= raw->size)
+		return 0;
+
+	buf = realloc(raw->buf, size);
+	if (buf == NULL)
+		return -ENOMEM;
+
+	raw->buf = buf;
+	raw->size = size;
+
+	return 0;
+}
+
+/*
+ * Start the scan of @lane at @prescale. The writes are short, a scan worker
+ * cancelled in the middle of one would leak its FILE or leave the
+ * transceiver half armed, so cancellation waits until both are done.
+ */
+static int eye_arm(struct jesd204b_xcvr_eyescan_info *info, unsigned lane,
+		   unsigned prescale)
+{
+	char temp[32];
+	int ret, state;
+
+	pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &state);
+
+	snprintf(temp, sizeof(temp), "%d", prescale);
+	ret = jesd_write_attr(info->gt_interface_path, JESD204B_PRESCALE, temp);
+	if (ret >= 0) {
+		snprintf(temp, sizeof(temp), "%d", lane);
+		ret = jesd_write_attr(info->gt_interface_path, JESD204B_LANE_ENABLE, temp);
+	}
+
+	pthread_setcancelstate(state, NULL);
+
+	return ret < 0 ? ret : 0;
+}
+
+static void eye_fclose(void *fp)
+{
+	fclose(fp);
+}
+
+/*
+ * Wait for the running scan and pull its data as is: the hex text of
+ * eye_data_partial (libiio) or the binary eye_data samples (sysfs).
+ */
+static int eye_read_raw(struct jesd204b_xcvr_eyescan_info *info, char *filename,
+			char *basedir, unsigned prescale,
+			struct jesd_xfer_stats *stats, struct jesd_eye_raw *raw)
+{
+	unsigned long long xfer_start;
+	char temp[PATH_MAX];
+	size_t elem_size;
+	FILE *sysfsfp;
+	unsigned cnt;
+	int ret;
+
+	ret = eye_samples(info, &cnt, &elem_size);
+	if (ret)
+		return ret;
+
+	raw->len = 0;
+
+	/* Try libiio first if available */
+	if (g_jesd_iio_ctx) {
+		struct iio_device *dev = get_iio_device_from_path(basedir);
+		unsigned seps = 0;
+		size_t len, i;
+
+		raw->hex = 1;
+
+		if (dev == NULL)
+			return -ENODEV;
+
+		/* Wait for data to be available */
+		ret = jesd_wait_attr_ready(basedir, "eye_data_available",
+					   eye_scan_time_us(info, prescale), stats);
+		if (ret < 0) {
+			print_output_sys(stderr, "Failed to read eye_data_available: %d\n", ret);
+			return ret;
+		}
+
+		xfer_start = jesd_time_us();
+
+		/*
+		 * The data ends with a short chunk. Counting the separators
+		 * avoids reading past the end when it is a multiple of the
+		 * chunk size.
+		 */
+		do {
+			ret = eye_raw_reserve(raw, raw->len + JESD_EYE_CHUNK_SIZE + 1);
+			if (ret)
+				return ret;
+
+			ret = jesd_iio_device_attr_read(dev, "eye_data_partial",
+							raw->buf + raw->len,
+							JESD_EYE_CHUNK_SIZE + 1);
+			if (ret < 0) {
+				print_output_sys(stderr, "%s:%d: read failed (%d)\n",
+						 __func__, __LINE__, ret);
+				return ret;
+			}
+
+			len = strnlen(raw->buf + raw->len, ret);
+			for (i = 0; i < len; i++)
+				seps += raw->buf[raw->len + i] == ',';
+			raw->len += len;
+		} while (len == JESD_EYE_CHUNK_SIZE && seps < cnt);
+
+		if (stats)
+			stats->xfer_us += jesd_time_us() - xfer_start;
+
+		if (!raw->len) {
+			print_output_sys(stderr, "%s:%d: no eye data\n", __func__, __LINE__);
+			return -EIO;
+		}
+
+		return 0;
+	}
+
+	/*
+	 * Older drivers have no eye_data_available, reading eye_data
+	 * then blocks until the scan is done.
+	 */
+	ret = jesd_wait_attr_ready(basedir, "eye_data_available",
+				   eye_scan_time_us(info, prescale), stats);
+	if (ret < 0 && ret != -ENOENT)
+		return ret;
+
+	raw->hex = 0;
+	ret = eye_raw_reserve(raw, cnt * elem_size);
+	if (ret)
+		return ret;
+
+	xfer_start = jesd_time_us();
+
+	if (jesd_backend_path(basedir)) {
+		ret = g_jesd_attr_backend->read(basedir, filename, raw->buf,
+						cnt * elem_size);
+		if (ret < 0)
+			return ret;
+
+		raw->len = ret;
+	} else {
+		/* Use sysfs method */
+		snprintf(temp, sizeof(temp), "%s/%s", basedir, filename);
+		sysfsfp = fopen(temp, "r");
+		if (sysfsfp == NULL)
+			return -errno;
+
+		/* The read blocks on older drivers, workers may be cancelled in it */
+		pthread_cleanup_push(eye_fclose, sysfsfp);
+		raw->len = fread(raw->buf, 1, cnt * elem_size, sysfsfp);
+		pthread_cleanup_pop(1);
+	}
+
+	if (stats)
+		stats->xfer_us += jesd_time_us() - xfer_start;
+
+	if (raw->len != cnt * elem_size) {
+		print_output_sys(stderr, "%s:%d: read failed %zu of %zu bytes\n",
+				 __func__, __LINE__, raw->len, cnt * elem_size);
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+/* Turn raw data into the malloc()ed u32 (LPM) or u64 (DFE) samples */
+static int eye_decode_raw(const struct jesd204b_xcvr_eyescan_info *info,
+			  const struct jesd_eye_raw *raw, void **data)
+{
+	struct jesd_hex_decoder dec;
+	size_t elem_size;
+	unsigned cnt;
+	void *buf;
+	int ret;
+
+	ret = eye_samples(info, &cnt, &elem_size);
+	if (ret)
+		return ret;
+
+	buf = malloc(cnt * elem_size);
+	if (buf == NULL)
+		return -ENOMEM;
+
+	if (raw->hex) {
+		jesd_hex_decoder_init(&dec, buf, elem_size, cnt);
+		jesd_hex_decode(&dec, raw->buf, raw->len);
+		jesd_hex_decoder_finish(&dec);
+
+		if (dec.idx != cnt) {
+			print_output_sys(stderr, "%s:%d: short read (%u of %u)\n",
+					 __func__, __LINE__, dec.idx, cnt);
+			free(buf);
+			return -EIO;
+		}
+	} else {
+		memcpy(buf, raw->buf, cnt * elem_size);
+	}
+
+	*data = buf;
+
+	return 0;
+}
+
+/* eye_read_raw() accounting both into the run totals and the eye's timing */
+static int eye_read_timed(struct jesd204b_xcvr_eyescan_info *info,
+			  unsigned prescale, struct jesd_xfer_stats *stats,
+			  struct jesd_eye_raw *raw, struct jesd_eye_timing *timing)
+{
+	struct jesd_xfer_stats es = { 0 };
+	int ret;
+
+	ret = eye_read_raw(info, JESD204B_EYE_DATA, info->gt_interface_path,
+			   prescale, &es, raw);
+
+	timing->wait_us = es.wait_us;
+	timing->xfer_us = es.xfer_us;
+
+	if (stats) {
+		stats->wait_us += es.wait_us;
+		stats->xfer_us += es.xfer_us;
+		stats->polls += es.polls;
+	}
+
+	return ret;
+}
+
+/*
+ * Acquire the samples of the running scan, on success *data holds the malloc()ed
+ * u32 (LPM) or u64 (DFE) samples.
+ */
+int get_eye_data(struct jesd204b_xcvr_eyescan_info *info, char *filename,
+		 char *basedir, unsigned prescale, struct jesd_xfer_stats *stats,
+		 void **data)
+{
+	struct jesd_eye_raw raw = { 0 };
+	int ret;
+
+	ret = eye_read_raw(info, filename, basedir, prescale, stats, &raw);
+	if (!ret)
+		ret = eye_decode_raw(info, &raw, data);
+
+	free(raw.buf);
+
+	return ret;
+}
+
+/* Run one eye scan of @lane at @prescale and add the result to the cache */
+int jesd_eye_acquire(struct jesd204b_xcvr_eyescan_info *info, unsigned lane,
+		     unsigned prescale, struct jesd_xfer_stats *stats,
+		     struct jesd_eye **eye)
+{
+	struct jesd_eye_timing timing = { .eyes = 1 };
+	struct jesd_eye_raw raw = { 0 };
+	unsigned long long start;
+	void *data;
+	int ret;
+
+	start = jesd_time_us();
+	ret = eye_arm(info, lane, prescale);
+	timing.arm_us = jesd_time_us() - start;
+	if (ret)
+		return ret;
+
+	ret = eye_read_timed(info, prescale, stats, &raw, &timing);
+	if (!ret) {
+		start = jesd_time_us();
+		ret = eye_decode_raw(info, &raw, &data);
+		timing.decode_us = jesd_time_us() - start;
+	}
+
+	free(raw.buf);
+
+	if (ret)
+		return ret;
+
+	*eye = jesd_eye_cache_insert(info, lane, prescale, data);
+	if (*eye == NULL)
+		return -ENOMEM;
+
+	(*eye)->timing = timing;
+
+	return 0;
+}
+
+/* =================================================================== */
+/* Acquisition pipeline */
+/* =================================================================== */
+
+/*
+ * The scanning thread only arms the transceiver and pulls the raw data into
+ * the next free slot of a ring, decoding, caching and the done callback run
+ * on the pipeline thread while the hardware already scans the next lane.
+ * Slot buffers are kept and reused for the lifetime of the pipeline.
+ */
+struct eye_slot {
+	struct jesd_eye_raw raw;
+	struct jesd204b_xcvr_eyescan_info *info;
+	unsigned lane;
+	unsigned prescale;
+	int err;		/* acquisition failed, nothing to decode */
+	struct jesd_eye_timing timing;
+};
+
+struct jesd_eye_pipeline {
+	pthread_t thread;
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	struct eye_slot slot[JESD_EYE_PIPELINE_DEPTH];
+	unsigned head;		/* next slot to process */
+	unsigned count;		/* filled slots, including the one in process */
+	int stop;
+	jesd_eye_done_fn done;
+	void *priv;
+};
+
+/* Scan threads may be cancelled, never while holding the lock */
+static void pipeline_lock(struct jesd_eye_pipeline *pl, int *state)
+{
+	pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, state);
+	pthread_mutex_lock(&pl->lock);
+}
+
+static void pipeline_unlock(struct jesd_eye_pipeline *pl, int state)
+{
+	pthread_mutex_unlock(&pl->lock);
+	pthread_setcancelstate(state, NULL);
+}
+
+static void *pipeline_thread(void *arg)
+{
+	struct jesd_eye_pipeline *pl = arg;
+	unsigned long long start;
+	struct jesd_eye *eye;
+	struct eye_slot *slot;
+	void *data;
+	int ret;
+
+	pthread_mutex_lock(&pl->lock);
+
+	for (;;) {
+		while (!pl->count && !pl->stop)
+			pthread_cond_wait(&pl->cond, &pl->lock);
+
+		if (!pl->count)
+			break;
+
+		slot = &pl->slot[pl->head];
+		pthread_mutex_unlock(&pl->lock);
+
+		eye = NULL;
+		ret = slot->err;
+		if (!ret) {
+			start = jesd_time_us();
+			ret = eye_decode_raw(slot->info, &slot->raw, &data);
+			slot->timing.decode_us = jesd_time_us() - start;
+		}
+		if (!ret) {
+			eye = jesd_eye_cache_insert(slot->info, slot->lane,
+						    slot->prescale, data);
+			if (eye == NULL)
+				ret = -ENOMEM;
+			else
+				eye->timing = slot->timing;
+		}
+
+		pl->done(pl->priv, slot->lane, slot->prescale, eye, ret);
+		jesd_eye_put(eye);
+
+		pthread_mutex_lock(&pl->lock);
+		pl->head = (pl->head + 1) % JESD_EYE_PIPELINE_DEPTH;
+		pl->count--;
+		pthread_cond_broadcast(&pl->cond);
+	}
+
+	pthread_mutex_unlock(&pl->lock);
+
+	return NULL;
+}
+
+struct jesd_eye_pipeline *jesd_eye_pipeline_create(jesd_eye_done_fn done,
+						   void *priv)
+{
+	struct jesd_eye_pipeline *pl;
+
+	pl = calloc(1, sizeof(*pl));
+	if (pl == NULL)
+		return NULL;
+
+	pthread_mutex_init(&pl->lock, NULL);
+	pthread_cond_init(&pl->cond, NULL);
+	pl->done = done;
+	pl->priv = priv;
+
+	if (pthread_create(&pl->thread, NULL, pipeline_thread, pl)) {
+		pthread_cond_destroy(&pl->cond);
+		pthread_mutex_destroy(&pl->lock);
+		free(pl);
+		return NULL;
+	}
+
+	return pl;
+}
+
+/*
+ * Scan @lane at @prescale and queue the data for the pipeline thread. Blocks
+ * only while all slots are still waiting to be processed. Failures are queued
+ * as well, the done callback sees every eye on the pipeline thread.
+ */
+int jesd_eye_pipeline_acquire(struct jesd_eye_pipeline *pl,
+			      struct jesd204b_xcvr_eyescan_info *info,
+			      unsigned lane, unsigned prescale,
+			      struct jesd_xfer_stats *stats)
+{
+	struct jesd_eye_timing timing = { .eyes = 1 };
+	unsigned long long start;
+	struct eye_slot *slot;
+	int ret, state;
+
+	start = jesd_time_us();
+	ret = eye_arm(info, lane, prescale);
+	timing.arm_us = jesd_time_us() - start;
+
+	start = jesd_time_us();
+	pipeline_lock(pl, &state);
+	while (pl->count == JESD_EYE_PIPELINE_DEPTH)
+		pthread_cond_wait(&pl->cond, &pl->lock);
+	/* The slot past the filled ones belongs to us until it is queued */
+	slot = &pl->slot[(pl->head + pl->count) % JESD_EYE_PIPELINE_DEPTH];
+	pipeline_unlock(pl, state);
+	timing.queue_us = jesd_time_us() - start;
+
+	if (!ret)
+		ret = eye_read_timed(info, prescale, stats, &slot->raw, &timing);
+
+	slot->err = ret;
+	slot->timing = timing;
+	slot->info = info;
+	slot->lane = lane;
+	slot->prescale = prescale;
+
+	pipeline_lock(pl, &state);
+	pl->count++;
+	pthread_cond_broadcast(&pl->cond);
+	pipeline_unlock(pl, state);
+
+	return ret;
+}
+
+/* Wait until every queued eye went through the done callback */
+void jesd_eye_pipeline_sync(struct jesd_eye_pipeline *pl)
+{
+	int state;
+
+	pipeline_lock(pl, &state);
+	while (pl->count)
+		pthread_cond_wait(&pl->cond, &pl->lock);
+	pipeline_unlock(pl, state);
+}
+
+/* Processes what is still queued, then stops the pipeline thread */
+void jesd_eye_pipeline_destroy(struct jesd_eye_pipeline *pl)
+{
+	unsigned i;
+	int state;
+
+	if (pl == NULL)
+		return;
+
+	pipeline_lock(pl, &state);
+	pl->stop = 1;
+	pthread_cond_broadcast(&pl->cond);
+	pipeline_unlock(pl, state);
+
+	pthread_join(pl->thread, NULL);
+
+	for (i = 0; i < JESD_EYE_PIPELINE_DEPTH; i++)
+		free(pl->slot[i].raw.buf);
+
+	pthread_cond_destroy(&pl->cond);
+	pthread_mutex_destroy(&pl->lock);
+	free(pl);
+}
+
+/* Transceivers offering eye scan, tries the new driver name if needed */
+int jesd_find_xcvr_devices(const char *basedir, char devices[MAX_DEVICES][PATH_MAX])
+{
+	int num;
+
+	if (g_jesd_iio_ctx)
+		return jesd_iio_find_xcvr_devices(g_jesd_iio_ctx, devices);
+
+	num = jesd_find_devices(basedir, XCVR_DRIVER_NAME, "eyescan_info", devices, 0);
+	if (num <= 0)
+		num = jesd_find_devices(basedir, XCVR_NEW_DRIVER_NAME, "eyescan_info",
+					devices, 0);
+
+	return num;
+}
@@ -0,0 +1,173 @@
+/***************************************************************************//**
+*   @file   jesd_eye_data.h
+*   @brief  JESD204 Eye Scan Data Decoding
+*   @author Michael Hennerich (michael.hennerich@analog.com)
+********************************************************************************
+* Copyright 2026(c) Analog Devices, Inc. All rights reserved.
+*
+* An ADI specific BSD license, which can be found in the top level directory
+* of this repository (LICENSE.txt), and also on-line at:
+* https://github.com/analogdevicesinc/jesd-eye-scan-gtk/blob/main/LICENSE.txt
+*******************************************************************************/
+
+#ifndef JESD_EYE_DATA_H_
+#define JESD_EYE_DATA_H_
+
+#include <stddef.h>
+#include <limits.h>
+
+#include "jesd_common.h"
+
+#define JESD_EYE_CACHE_SIZE	(256UL << 20)	/* Default memory bound */
+
+/*
+ * Time spent per phase of an eye acquisition. The library fills in the
+ * acquisition phases, analysis and persistence are up to the application.
+ */
+struct jesd_eye_timing {
+	unsigned long long arm_us;	/* prescale and lane enable writes */
+	unsigned long long queue_us;	/* waiting for a free pipeline slot */
+	unsigned long long wait_us;	/* scan running, eye_data_available */
+	unsigned long long xfer_us;	/* eye data readout */
+	unsigned long long decode_us;	/* hex or binary to samples */
+	unsigned long long analyse_us;
+	unsigned long long persist_us;	/* .eye and PNG files */
+	unsigned eyes;
+};
+
+/* One line of a timing report */
+struct jesd_eye_timing_entry {
+	const char *device;
+	unsigned lane;
+	unsigned prescale;
+	struct jesd_eye_timing t;
+};
+
+/*
+ * Decoded eye scan of one lane at one prescale. Entries live in an in-process
+ * cache keyed by (info.gt_interface_path, lane, prescale) and are reference
+ * counted, a reference stays valid after the entry was evicted.
+ */
+struct jesd_eye {
+	struct jesd204b_xcvr_eyescan_info info;
+	unsigned lane;
+	unsigned prescale;
+	unsigned cnt;		/* es_hsize * es_vsize samples */
+	size_t size;		/* bytes of data */
+	void *data;		/* u32 (LPM) or u64 (DFE) samples */
+	float *log_ber;		/* log10(BER) per sample, built on demand */
+	struct jesd_eye_timing timing;	/* zero for eyes loaded from files */
+
+	unsigned refcnt;
+	int cached;
+	struct jesd_eye *hnext;
+	struct jesd_eye *prev;
+	struct jesd_eye *next;
+};
+
+#define JESD_EYE_STABLE_STEPS	2	/* Adaptive scan: unchanged prescales to stop */
+
+/* Error free extent through the eye center, in samples relative to it */
+struct jesd_eye_opening {
+	int xmin, xmax;
+	int ymin, ymax;
+	float h_ui;
+	int v_codes;
+	unsigned open_samples;	/* error free samples in the whole grid */
+};
+
+/* Per lane state of an adaptive (progressive prescale) scan */
+struct jesd_eye_convergence {
+	struct jesd_eye_opening last;
+	unsigned stable;
+	int valid;
+};
+
+double calc_ber(struct jesd204b_xcvr_eyescan_info *info,
+		unsigned long long smpl, unsigned prescale);
+void jesd_eye_log_ber_map(const struct jesd204b_xcvr_eyescan_info *info,
+			  unsigned prescale, const void *data, unsigned cnt,
+			  float *log_ber);
+void jesd_eye_analyse(const struct jesd_eye *eye,
+		      struct jesd_eye_opening *op);
+int jesd_eye_converged(struct jesd_eye_convergence *conv,
+		       const struct jesd_eye_opening *op);
+
+void jesd_eye_cache_set_limit(size_t max_bytes);
+void jesd_eye_cache_clear(void);
+struct jesd_eye *jesd_eye_cache_insert(const struct jesd204b_xcvr_eyescan_info *info,
+				       unsigned lane, unsigned prescale,
+				       void *data);
+struct jesd_eye *jesd_eye_cache_get(const char *device, unsigned lane,
+				    unsigned prescale);
+void jesd_eye_put(struct jesd_eye *eye);
+const float *jesd_eye_log_ber(struct jesd_eye *eye);
+int jesd_eye_save(const struct jesd_eye *eye, const char *file);
+struct jesd_eye *jesd_eye_load(const struct jesd204b_xcvr_eyescan_info *info,
+			       unsigned lane, unsigned prescale,
+			       const char *file);
+
+void jesd_eye_timing_add(struct jesd_eye_timing *sum,
+			 const struct jesd_eye_timing *t);
+void jesd_eye_timing_print(void *err, const char *name,
+			   const struct jesd_eye_timing *t);
+int jesd_eye_timing_save(const char *file,
+			 const struct jesd_eye_timing_entry *entries,
+			 unsigned num);
+
+int read_eyescan_info(const char *basedir,
+		      struct jesd204b_xcvr_eyescan_info *info);
+int get_eye_data(struct jesd204b_xcvr_eyescan_info *info, char *filename,
+		 char *basedir, unsigned prescale, struct jesd_xfer_stats *stats,
+		 void **data);
+int jesd_eye_acquire(struct jesd204b_xcvr_eyescan_info *info, unsigned lane,
+		     unsigned prescale, struct jesd_xfer_stats *stats,
+		     struct jesd_eye **eye);
+/*
+ * Acquisition pipeline: jesd_eye_pipeline_acquire() returns once the raw data
+ * of a scan was read, decoding and the @done callback run on a separate thread
+ * while the next scan is in flight. The callback runs exactly once per
+ * acquisition and always on that thread, @eye is NULL when @err is set, the
+ * reference is dropped after the callback returns.
+ */
+#define JESD_EYE_PIPELINE_DEPTH	4
+
+struct jesd_eye_pipeline;
+typedef void (*jesd_eye_done_fn)(void *priv, unsigned lane, unsigned prescale,
+				 struct jesd_eye *eye, int err);
+
+struct jesd_eye_pipeline *jesd_eye_pipeline_create(jesd_eye_done_fn done,
+						   void *priv);
+int jesd_eye_pipeline_acquire(struct jesd_eye_pipeline *pl,
+			      struct jesd204b_xcvr_eyescan_info *info,
+			      unsigned lane, unsigned prescale,
+			      struct jesd_xfer_stats *stats);
+void jesd_eye_pipeline_sync(struct jesd_eye_pipeline *pl);
+void jesd_eye_pipeline_destroy(struct jesd_eye_pipeline *pl);
+
+int jesd_find_xcvr_devices(const char *basedir, char devices[MAX_DEVICES][PATH_MAX]);
+
+/* Message output, provided by each application (text view, stdout, ...) */
+int print_output_sys(void *err, const char *str, ...);
+
+/*
+ * Streaming decoder for the comma separated hex samples of eye_data_partial.
+ * Values are written straight into the eye buffer as u32 (LPM) or u64 (DFE),
+ * a token split across two chunks is carried over to the next call.
+ */
+struct jesd_hex_decoder {
+	void *out;
+	unsigned elem_size;
+	unsigned cnt;
+	unsigned idx;
+	unsigned long long acc;
+	unsigned digits;
+};
+
+void jesd_hex_decoder_init(struct jesd_hex_decoder *dec, void *out,
+			   unsigned elem_size, unsigned cnt);
+unsigned jesd_hex_decode(struct jesd_hex_decoder *dec, const char *buf,
+			 size_t len);
+unsigned jesd_hex_decoder_finish(struct jesd_hex_decoder *dec);
+
+#endif
@@ -0,0 +1,415 @@
+/***************************************************************************//**
+*   @file   jesd_eye_render.c
+*   @brief  JESD204 Eye Scan Cairo Renderer
+*   @author Michael Hennerich (michael.hennerich@analog.com)
+********************************************************************************
+* Copyright 2026(c) Analog Devices, Inc. All rights reserved.
+*
+* An ADI specific BSD license, which can be found in the top level directory
+* of this repository (LICENSE.txt), and also on-line at:
+* https://github.com/analogdevicesinc/jesd-eye-scan-gtk/blob/main/LICENSE.txt
+*******************************************************************************/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+
+#include "jesd_eye_render.h"
+
+#define MARGIN_LEFT	64
+#define MARGIN_RIGHT	88	/* color box */
+#define MARGIN_TOP	48
+#define MARGIN_BOTTOM	44
+#define CBOX_WIDTH	16
+#define PALETTE_SIZE	256
+
+/* Data to device coordinates of the plot area */
+struct eye_axes {
+	double px, py, pw, ph;
+	double x0, x1;		/* UI */
+	double y0, y1;		/* CODES */
+};
+
+static double ax_x(const struct eye_axes *ax, double x)
+{
+	return ax->px + (x - ax->x0) / (ax->x1 - ax->x0) * ax->pw;
+}
+
+static double ax_y(const struct eye_axes *ax, double y)
+{
+	return ax->py + ax->ph - (y - ax->y0) / (ax->y1 - ax->y0) * ax->ph;
+}
+
+static double clamp01(double v)
+{
+	return v < 0.0 ? 0.0 : (v > 1.0 ? 1.0 : v);
+}
+
+/* gnuplot 'set palette rgbformulae 7,5,15': sqrt(x), x^3, sin(360 x) */
+static void palette_fill(uint32_t *lut)
+{
+	unsigned i;
+
+	for (i = 0; i < PALETTE_SIZE; i++) {
+		double g = (double)i / (PALETTE_SIZE - 1);
+		unsigned r = clamp01(sqrt(g)) * 255.0 + 0.5;
+		unsigned gr = clamp01(g * g * g) * 255.0 + 0.5;
+		unsigned b = clamp01(sin(2 * M_PI * g)) * 255.0 + 0.5;
+
+		lut[i] = 0xFF000000 | (r << 16) | (gr << 8) | b;
+	}
+}
+
+static unsigned palette_index(float v, double cbmin, double cbmax)
+{
+	double g;
+
+	/* +inf (empty counters) clamps to the highest BER, NaN is drawn alike */
+	if (isnan(v))
+		return PALETTE_SIZE - 1;
+
+	g = (v - cbmin) / (cbmax - cbmin);
+
+	return clamp01(g) * (PALETTE_SIZE - 1) + 0.5;
+}
+
+/* 1, 2 or 5 times a power of ten, giving about @n intervals over @range */
+static double tick_step(double range, unsigned n)
+{
+	double raw = range / n, mag = pow(10, floor(log10(raw)));
+
+	if (raw / mag >= 5)
+		return 5 * mag;
+	if (raw / mag >= 2)
+		return 2 * mag;
+
+	return mag;
+}
+
+static void show_text(cairo_t *cr, double x, double y, double xalign,
+		      double yalign, const char *text)
+{
+	cairo_text_extents_t ext;
+
+	cairo_text_extents(cr, text, &ext);
+	cairo_move_to(cr, x - ext.x_advance * xalign - ext.x_bearing,
+		      y - ext.height * yalign - ext.y_bearing);
+	cairo_show_text(cr, text);
+}
+
+static cairo_surface_t *heatmap_create(struct jesd_eye *eye, const float *log_ber,
+				       double cbmin, double cbmax)
+{
+	unsigned w = eye->info.es_hsize, h = eye->info.es_vsize, x, y;
+	uint32_t lut[PALETTE_SIZE];
+	cairo_surface_t *img;
+	unsigned char *pix;
+	int stride;
+
+	img = cairo_image_surface_create(CAIRO_FORMAT_RGB24, w, h);
+	if (cairo_surface_status(img) != CAIRO_STATUS_SUCCESS)
+		return img;
+
+	palette_fill(lut);
+
+	cairo_surface_flush(img);
+	pix = cairo_image_surface_get_data(img);
+	stride = cairo_image_surface_get_stride(img);
+
+	/* Row 0 holds the lowest vertical offset, images grow downwards */
+	for (y = 0; y < h; y++) {
+		uint32_t *row = (uint32_t *)(pix + (h - 1 - y) * stride);
+
+		for (x = 0; x < w; x++)
+			row[x] = lut[palette_index(log_ber[y * w + x], cbmin, cbmax)];
+	}
+
+	cairo_surface_mark_dirty(img);
+
+	return img;
+}
+
+/* Decade of a sample, false for samples without a BER */
+static bool ber_decade(float v, int *decade)
+{
+	if (!isfinite(v))
+		return false;
+
+	*decade = floorf(v);
+
+	return true;
+}
+
+/*
+ * Decade contours along the sample edges where floor(log10(BER)) changes,
+ * samples without a BER get none
+ */
+static void draw_contours(cairo_t *cr, const struct eye_axes *ax,
+			  struct jesd_eye *eye, const float *log_ber)
+{
+	unsigned w = eye->info.es_hsize, h = eye->info.es_vsize, x, y;
+	double cw = ax->pw / w, ch = ax->ph / h;
+	int d, n;
+
+	for (y = 0; y < h; y++) {
+		for (x = 0; x < w; x++) {
+			double left = ax->px + x * cw;
+			double top = ax->py + (h - 1 - y) * ch;
+
+			if (!ber_decade(log_ber[y * w + x], &d))
+				continue;
+
+			if (x + 1 < w && ber_decade(log_ber[y * w + x + 1], &n) && n != d) {
+				cairo_move_to(cr, left + cw, top);
+				cairo_line_to(cr, left + cw, top + ch);
+			}
+
+			if (y + 1 < h && ber_decade(log_ber[(y + 1) * w + x], &n) && n != d) {
+				cairo_move_to(cr, left, top);
+				cairo_line_to(cr, left + cw, top);
+			}
+		}
+	}
+
+	cairo_set_source_rgba(cr, 0, 0, 0, 0.5);
+	cairo_set_line_width(cr, 1.0);
+	cairo_stroke(cr);
+}
+
+static void draw_grid(cairo_t *cr, const struct eye_axes *ax)
+{
+	double step, v;
+	char temp[32];
+
+	cairo_set_font_size(cr, 10);
+	cairo_set_line_width(cr, 1.0);
+
+	step = tick_step(ax->x1 - ax->x0, 10);
+	for (v = ceil(ax->x0 / step) * step; v <= ax->x1 + step / 1000; v += step) {
+		double x = ax_x(ax, v);
+
+		cairo_set_source_rgb(cr, 0.75, 0.75, 0.75);
+		cairo_move_to(cr, x, ax->py);
+		cairo_line_to(cr, x, ax->py + ax->ph);
+		cairo_stroke(cr);
+
+		snprintf(temp, sizeof(temp), "%.1f", fabs(v) < step / 1000 ? 0.0 : v);
+		cairo_set_source_rgb(cr, 0, 0, 0);
+		show_text(cr, x, ax->py + ax->ph + 4, 0.5, 0.0, temp);
+	}
+
+	step = tick_step(ax->y1 - ax->y0, 8);
+	for (v = ceil(ax->y0 / step) * step; v <= ax->y1; v += step) {
+		double y = ax_y(ax, v);
+
+		cairo_set_source_rgb(cr, 0.75, 0.75, 0.75);
+		cairo_move_to(cr, ax->px, y);
+		cairo_line_to(cr, ax->px + ax->pw, y);
+		cairo_stroke(cr);
+
+		snprintf(temp, sizeof(temp), "%.0f", v);
+		cairo_set_source_rgb(cr, 0, 0, 0);
+		show_text(cr, ax->px - 4, y, 1.0, 0.5, temp);
+	}
+
+	cairo_rectangle(cr, ax->px, ax->py, ax->pw, ax->ph);
+	cairo_stroke(cr);
+}
+
+static void draw_mask(cairo_t *cr, const struct eye_axes *ax)
+{
+	cairo_set_source_rgb(cr, 1, 1, 1);
+	cairo_set_line_width(cr, 1.0);
+	cairo_move_to(cr, ax_x(ax, -0.175), ax_y(ax, 0));
+	cairo_line_to(cr, ax_x(ax, 0), ax_y(ax, 22.5));
+	cairo_line_to(cr, ax_x(ax, 0.175), ax_y(ax, 0));
+	cairo_line_to(cr, ax_x(ax, 0), ax_y(ax, -22.5));
+	cairo_close_path(cr);
+	cairo_stroke(cr);
+
+	cairo_set_font_size(cr, 10);
+	show_text(cr, ax_x(ax, 0), ax_y(ax, 0), 0.5, 0.5, "MASK");
+}
+
+static void draw_opening(cairo_t *cr, const struct eye_axes *ax,
+			 struct jesd_eye *eye)
+{
+	struct jesd_eye_opening op;
+	double x = ax->px + 6, y = ax->py + ax->ph - 6;
+	char temp[64];
+
+	jesd_eye_analyse(eye, &op);
+
+	cairo_set_source_rgb(cr, 1, 1, 1);
+	cairo_set_font_size(cr, 10);
+
+	snprintf(temp, sizeof(temp), "V: %d (CODES)", op.v_codes);
+	show_text(cr, x, y, 0.0, 1.0, temp);
+	snprintf(temp, sizeof(temp), "H: %.3f (UI)", op.h_ui);
+	show_text(cr, x, y - 14, 0.0, 1.0, temp);
+	show_text(cr, x, y - 28, 0.0, 1.0, "Eye-Opening:");
+}
+
+static void draw_colorbox(cairo_t *cr, const struct eye_axes *ax,
+			  double cbmin, double cbmax)
+{
+	double bx = ax->px + ax->pw + 12, v;
+	cairo_pattern_t *grad;
+	uint32_t lut[PALETTE_SIZE];
+	char temp[32];
+	unsigned i;
+
+	palette_fill(lut);
+
+	grad = cairo_pattern_create_linear(0, ax->py + ax->ph, 0, ax->py);
+	for (i = 0; i < PALETTE_SIZE; i += 8) {
+		uint32_t c = lut[i];
+
+		cairo_pattern_add_color_stop_rgb(grad, (double)i / (PALETTE_SIZE - 1),
+						 ((c >> 16) & 0xFF) / 255.0,
+						 ((c >> 8) & 0xFF) / 255.0,
+						 (c & 0xFF) / 255.0);
+	}
+
+	cairo_rectangle(cr, bx, ax->py, CBOX_WIDTH, ax->ph);
+	cairo_set_source(cr, grad);
+	cairo_fill_preserve(cr);
+	cairo_pattern_destroy(grad);
+
+	cairo_set_source_rgb(cr, 0, 0, 0);
+	cairo_set_line_width(cr, 1.0);
+	cairo_stroke(cr);
+
+	cairo_set_font_size(cr, 10);
+	for (v = cbmin; v <= cbmax; v += 1.0) {
+		double y = ax->py + ax->ph - (v - cbmin) / (cbmax - cbmin) * ax->ph;
+
+		snprintf(temp, sizeof(temp), "%.0f", v);
+		show_text(cr, bx + CBOX_WIDTH + 4, y, 0.0, 0.5, temp);
+	}
+
+	cairo_save(cr);
+	cairo_translate(cr, bx + CBOX_WIDTH + 36, ax->py + ax->ph / 2);
+	cairo_rotate(cr, -M_PI / 2);
+	show_text(cr, 0, 0, 0.5, 0.5, "BER 10E");
+	cairo_restore(cr);
+}
+
+int jesd_eye_render(cairo_t *cr, struct jesd_eye *eye, int width, int height)
+{
+	struct jesd204b_xcvr_eyescan_info *info = &eye->info;
+	unsigned hsize = info->es_hsize, vsize = info->es_vsize, i;
+	cairo_surface_t *img;
+	struct eye_axes ax;
+	const float *log_ber;
+	double cbmin, cbmax, dx;
+	char temp[128];
+
+	if (hsize < 2 || !vsize)
+		return -EINVAL;
+
+	log_ber = jesd_eye_log_ber(eye);
+	if (log_ber == NULL)
+		return -ENOMEM;
+
+	/* Same sample placement as the former gnuplot data stream */
+	dx = 1.0 / (hsize - 1);
+	ax.x0 = (0.0 - (hsize / 2)) * dx - dx / 2;
+	ax.x1 = ((double)(hsize - 1) - (hsize / 2)) * dx + dx / 2;
+	ax.y0 = (0.0 - (vsize / 2)) - 0.5;
+	ax.y1 = ((double)(vsize - 1) - (vsize / 2)) + 0.5;
+	ax.px = MARGIN_LEFT;
+	ax.py = MARGIN_TOP;
+	ax.pw = MAX(width - MARGIN_LEFT - MARGIN_RIGHT, 1);
+	ax.ph = MAX(height - MARGIN_TOP - MARGIN_BOTTOM, 1);
+
+	/* The color range covers the samples with a BER, empty counters are +inf */
+	cbmin = INFINITY;
+	cbmax = -INFINITY;
+	for (i = 0; i < eye->cnt; i++) {
+		if (!isfinite(log_ber[i]))
+			continue;
+		cbmin = MIN(cbmin, log_ber[i]);
+		cbmax = MAX(cbmax, log_ber[i]);
+	}
+	if (cbmin > cbmax)
+		cbmin = cbmax = 0;
+	cbmin = floor(cbmin);
+	cbmax = ceil(cbmax);
+	if (cbmax <= cbmin)
+		cbmax = cbmin + 1;
+
+	cairo_save(cr);
+
+	cairo_set_source_rgb(cr, 1, 1, 1);
+	cairo_paint(cr);
+	cairo_select_font_face(cr, "Sans", CAIRO_FONT_SLANT_NORMAL,
+			       CAIRO_FONT_WEIGHT_NORMAL);
+
+	img = heatmap_create(eye, log_ber, cbmin, cbmax);
+	if (cairo_surface_status(img) == CAIRO_STATUS_SUCCESS) {
+		cairo_save(cr);
+		cairo_rectangle(cr, ax.px, ax.py, ax.pw, ax.ph);
+		cairo_clip(cr);
+		cairo_translate(cr, ax.px, ax.py);
+		cairo_scale(cr, ax.pw / hsize, ax.ph / vsize);
+		cairo_set_source_surface(cr, img, 0, 0);
+		cairo_pattern_set_filter(cairo_get_source(cr), CAIRO_FILTER_NEAREST);
+		cairo_paint(cr);
+		cairo_restore(cr);
+	}
+	cairo_surface_destroy(img);
+
+	draw_contours(cr, &ax, eye, log_ber);
+	draw_grid(cr, &ax);
+	draw_mask(cr, &ax);
+	draw_opening(cr, &ax, eye);
+	draw_colorbox(cr, &ax, cbmin, cbmax);
+
+	cairo_set_source_rgb(cr, 0, 0, 0);
+	cairo_set_font_size(cr, 12);
+	snprintf(temp, sizeof(temp),
+		 "JESD204 Lane%i @ %.2f Gbps %s (Max BER %.1e)",
+		 eye->lane, (double)info->lane_rate / 1000000, info->lpm ? "LPM" : "DFE",
+		 calc_ber(info, 0xFFFF0000FFFF0000, eye->prescale));
+	show_text(cr, ax.px + ax.pw / 2, MARGIN_TOP - 8, 0.5, 1.0, temp);
+
+	cairo_set_font_size(cr, 10);
+	show_text(cr, ax.px, 6, 0.0, 0.0, "Xilinx 2D Statistical Eye Scan");
+	show_text(cr, ax.px + ax.pw / 2, height - 4, 0.5, 1.0,
+		  "Horizontal Offset (UI)");
+
+	cairo_save(cr);
+	cairo_translate(cr, 12, ax.py + ax.ph / 2);
+	cairo_rotate(cr, -M_PI / 2);
+	show_text(cr, 0, 0, 0.5, 0.5, "Vertical Offset (CODES)");
+	cairo_restore(cr);
+
+	cairo_restore(cr);
+
+	return 0;
+}
+
+int jesd_eye_render_png(struct jesd_eye *eye, const char *file, int width,
+			int height)
+{
+	cairo_surface_t *surface;
+	cairo_t *cr;
+	int ret;
+
+	surface = cairo_image_surface_create(CAIRO_FORMAT_RGB24, width, height);
+	cr = cairo_create(surface);
+
+	ret = jesd_eye_render(cr, eye, width, height);
+	cairo_destroy(cr);
+
+	if (!ret && cairo_surface_write_to_png(surface, file) != CAIRO_STATUS_SUCCESS)
+		ret = -EIO;
+
+	cairo_surface_destroy(surface);
+
+	return ret;
+}
@@ -0,0 +1,31 @@
+/***************************************************************************//**
+*   @file   jesd_eye_render.h
+*   @brief  JESD204 Eye Scan Cairo Renderer
+*   @author Michael Hennerich (michael.hennerich@analog.com)
+********************************************************************************
+* Copyright 2026(c) Analog Devices, Inc. All rights reserved.
+*
+* An ADI specific BSD license, which can be found in the top level directory
+* of this repository (LICENSE.txt), and also on-line at:
+* https://github.com/analogdevicesinc/jesd-eye-scan-gtk/blob/main/LICENSE.txt
+*******************************************************************************/
+
+#ifndef JESD_EYE_RENDER_H_
+#define JESD_EYE_RENDER_H_
+
+#include <cairo.h>
+
+#include "jesd_eye_data.h"
+
+#define JESD_EYE_PNG_WIDTH	640
+#define JESD_EYE_PNG_HEIGHT	480
+
+/*
+ * Draws the statistical eye of @eye (BER heat map, decade contours, MASK and
+ * eye-opening labels) into a @width x @height area of @cr.
+ */
+int jesd_eye_render(cairo_t *cr, struct jesd_eye *eye, int width, int height);
+int jesd_eye_render_png(struct jesd_eye *eye, const char *file, int width,
+			int height);
+
+#endif
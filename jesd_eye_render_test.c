@@ -0,0 +1,155 @@
+/***************************************************************************//**
+*   @file   jesd_eye_render_test.c
+*   @brief  JESD204 Eye Renderer Regression Test
+*   @author Michael Hennerich (michael.hennerich@analog.com)
+********************************************************************************
+* Copyright 2026(c) Analog Devices, Inc. All rights reserved.
+*
+* An ADI specific BSD license, which can be found in the top level directory
+* of this repository (LICENSE.txt), and also on-line at:
+* https://github.com/analogdevicesinc/jesd-eye-scan-gtk/blob/main/LICENSE.txt
+*******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "jesd_common.h"
+#include "jesd_eye_data.h"
+#include "jesd_eye_render.h"
+
+/*
+ * Renders a synthetic LPM eye that contains a sample with empty counters,
+ * its log10(BER) is +inf. The simulator saturates its counters, so only a
+ * handmade eye covers it. The render must finish, keep the color range of
+ * the other samples and draw the empty sample like the highest BER.
+ */
+#define TEST_HSIZE	33
+#define TEST_VSIZE	127
+#define TEST_WIDTH	800
+#define TEST_HEIGHT	600
+#define TEST_COUNT	1000
+
+/* Plot area as laid out by jesd_eye_render() */
+#define PLOT_X		64
+#define PLOT_Y		48
+#define PLOT_W		(TEST_WIDTH - 64 - 88)
+#define PLOT_H		(TEST_HEIGHT - 48 - 44)
+
+#define PALETTE_TOP	0xFFFF00	/* rgbformulae 7,5,15 at 1.0 */
+
+int print_output_sys(void *err, const char *str, ...)
+{
+	va_list args;
+	int ret;
+
+	va_start(args, str);
+	ret = vfprintf(err, str, args);
+	va_end(args);
+
+	return ret;
+}
+
+/* Open within 0.3 UI and 50 codes of the center, closed elsewhere */
+static uint32_t *test_eye_samples(unsigned empty_col, unsigned empty_row)
+{
+	uint32_t *smpl;
+	unsigned x, y;
+
+	smpl = calloc(TEST_HSIZE * TEST_VSIZE, sizeof(*smpl));
+	if (!smpl)
+		return NULL;
+
+	for (y = 0; y < TEST_VSIZE; y++) {
+		for (x = 0; x < TEST_HSIZE; x++) {
+			int ux = (int)x - TEST_HSIZE / 2, code = (int)y - TEST_VSIZE / 2;
+			bool open = abs(ux) * 10 < (TEST_HSIZE - 1) * 3 && abs(code) < 50;
+
+			smpl[y * TEST_HSIZE + x] = (TEST_COUNT << 16) | (open ? 0 : TEST_COUNT);
+		}
+	}
+
+	smpl[empty_row * TEST_HSIZE + empty_col] = 0;
+
+	return smpl;
+}
+
+static uint32_t test_pixel(cairo_surface_t *img, unsigned col, unsigned row)
+{
+	unsigned char *pix = cairo_image_surface_get_data(img);
+	int stride = cairo_image_surface_get_stride(img);
+	unsigned px = PLOT_X + (col + 0.5) * PLOT_W / TEST_HSIZE;
+	unsigned py = PLOT_Y + (TEST_VSIZE - 1 - row + 0.5) * PLOT_H / TEST_VSIZE;
+
+	return ((uint32_t *)(pix + py * stride))[px] & 0xFFFFFF;
+}
+
+int main(void)
+{
+	struct jesd204b_xcvr_eyescan_info info = {
+		.es_hsize = TEST_HSIZE,
+		.es_vsize = TEST_VSIZE,
+		.cdr_data_width = 40,
+		.num_lanes = 1,
+		.lpm = 1,
+		.gt_interface_path = "test:eye",
+	};
+	/* Sample columns and rows clear of the grid lines, MASK and labels */
+	unsigned open_col = TEST_HSIZE / 2, closed_col = 2;
+	unsigned upper_row = TEST_VSIZE / 2 + 45, lower_row = TEST_VSIZE / 2 - 45;
+	uint32_t open, closed, empty;
+	struct jesd_eye *eye;
+	cairo_surface_t *img;
+	cairo_t *cr;
+	uint32_t *smpl;
+	int ret;
+
+	/* A hang in the draw loops fails the test instead of blocking it */
+	alarm(10);
+
+	smpl = test_eye_samples(closed_col, lower_row);
+	if (!smpl)
+		return 1;
+
+	eye = jesd_eye_cache_insert(&info, 0, 0, smpl);
+	if (!eye)
+		return 1;
+
+	img = cairo_image_surface_create(CAIRO_FORMAT_RGB24, TEST_WIDTH, TEST_HEIGHT);
+	cr = cairo_create(img);
+	ret = jesd_eye_render(cr, eye, TEST_WIDTH, TEST_HEIGHT);
+	cairo_destroy(cr);
+	cairo_surface_flush(img);
+
+	if (ret) {
+		fprintf(stderr, "jesd_eye_render() failed (%d)\n", ret);
+		return 1;
+	}
+
+	open = test_pixel(img, open_col, upper_row);
+	closed = test_pixel(img, closed_col, upper_row);
+	empty = test_pixel(img, closed_col, lower_row);
+
+	cairo_surface_destroy(img);
+	jesd_eye_put(eye);
+
+	if (open == closed) {
+		fprintf(stderr, "open and closed samples share color %06x\n", open);
+		return 1;
+	}
+
+	if (empty != PALETTE_TOP) {
+		fprintf(stderr, "empty sample drawn as %06x, expected %06x\n",
+			empty, PALETTE_TOP);
+		return 1;
+	}
+
+	printf("eye render: open %06x, closed %06x, empty %06x\n", open, closed, empty);
+
+	return 0;
+}
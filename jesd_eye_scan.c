@@ -37,9 +37,12 @@
 #include <stddef.h>
 
 #include <gtk/gtk.h>
-#include <gtk/gtkx.h>
 
 #include "jesd_common.h"
+#include "jesd_eye_data.h"
+#include "jesd_eye_sim.h"
+#include "jesd_monitor.h"
+#include "jesd_eye_render.h"
 
 /* Wrapper to suppress deprecation warnings for color setting */
 #pragma GCC diagnostic push
@@ -56,10 +59,11 @@ guint timer;
 
 GtkBuilder *builder;
 GtkWidget *main_window;
-GtkWidget *sock;
+GtkWidget *eye_area;
 GtkWidget *finished_eyes;
 GtkWidget *min_ber;
 GtkWidget *max_ber;
+GtkWidget *adaptive;
 GtkWidget *device_select;
 GtkWidget *jesd_core_selection;
 GtkWidget *xcvr_core_selection;
@@ -95,7 +99,6 @@ GdkRGBA color_red;
 GdkRGBA color_green;
 GdkRGBA color_orange;
 
-pthread_t work;
 GMutex *mutex;
 unsigned work_run = 1;
 unsigned is_first = 0;
@@ -106,9 +109,82 @@ enum {
 	NUM_COLS
 };
 
+#define SCAN_ALL_XCVR	"All transceivers"
+
+/*
+ * Workers never touch GTK, they post events the main loop drains in one idle
+ * callback per batch. Each transceiver has its own single producer ring: the
+ * pipeline thread while it runs, the worker once it has been joined.
+ */
+#define SCAN_EVENTS	256	/* power of two */
+
+enum scan_event_type {
+	SCAN_EVENT_EYE,		/* an acquisition finished, err set on failure */
+	SCAN_EVENT_DONE,	/* the worker is about to exit */
+};
+
+struct scan_event {
+	enum scan_event_type type;
+	unsigned run;
+	unsigned lane;
+	unsigned prescale;
+	int err;
+	int converged;
+	struct jesd_eye_timing timing;
+};
+
+struct scan_event_queue {
+	struct scan_event ev[SCAN_EVENTS];
+	unsigned head;		/* written by the main loop */
+	unsigned tail;		/* written by the producer */
+};
+
+/* One acquisition thread per transceiver taking part in a run */
+struct xcvr_scan {
+	struct jesd204b_xcvr_eyescan_info info;
+	pthread_t thread;
+	unsigned xcvr;
+	unsigned lane_en;
+	unsigned pmin;
+	unsigned pmax;
+	unsigned adaptive;
+	struct jesd_xfer_stats stats;
+	struct jesd_eye_timing timing;
+	struct jesd_eye_pipeline *pl;
+	/* Adaptive mode, updated by the acquisition pipeline */
+	struct jesd_eye_convergence conv[MAX_LANES];
+	unsigned lane_active;
+	unsigned run;
+	struct scan_event_queue events;
+};
+
+/* Maps the entries of finished_eyes back to the acquisition */
+struct eye_result {
+	unsigned scan;
+	unsigned lane;
+	unsigned prescale;
+	struct jesd_eye_timing timing;
+};
+
 struct jesd204b_laneinfo lane_info[MAX_LANES];
 struct jesd204b_xcvr_eyescan_info eyescan_info;
 char jesd_devices[MAX_DEVICES][PATH_MAX];
+char xcvr_devices[MAX_DEVICES][PATH_MAX];
+unsigned num_xcvr_devices;
+unsigned scan_all;
+
+struct xcvr_scan xcvr_scans[MAX_DEVICES];
+unsigned num_xcvr_scans;
+struct eye_result eye_results[MAX_DEVICES * MAX_LANES * (MAX_PRESCALE + 1)];
+unsigned num_eye_results;
+unsigned scan_steps_done, scan_steps_total;
+unsigned persist_eyes = 1;
+unsigned scans_active;
+unsigned scan_run;
+unsigned scan_events_pending;
+char *timing_report;
+pthread_t main_thread;
+struct jesd_eye *shown_eye;
 
 unsigned long long get_lane_rate(unsigned lane)
 {
@@ -281,17 +357,47 @@ int get_devices(const char *path, const char *driver, const char *file,  GtkWidg
 	return dev_num;
 }
 
+/* Messages of the scan threads, shown from the main loop */
+struct thread_msg {
+	void *err;
+	char buf[250];
+};
+
+static gboolean thread_msg_cb(gpointer data)
+{
+	struct thread_msg *msg = data;
+
+	print_output_sys(msg->err, "%s", msg->buf);
+	g_free(msg);
+
+	return G_SOURCE_REMOVE;
+}
+
 int print_output_sys(void *err, const char *str, ...)
 {
+	struct thread_msg *msg;
 	va_list args;
 	char buf[250];
-	int len;
+	int len, state;
 
 	memset(buf, 0, 250);
 	va_start(args, str);
 	len = vsnprintf(buf, sizeof(buf), str, args);
 	va_end(args);
 
+	if (!pthread_equal(pthread_self(), main_thread)) {
+		msg = g_new(struct thread_msg, 1);
+		msg->err = err;
+		memcpy(msg->buf, buf, sizeof(buf));
+
+		/* g_idle_add() wakes the main loop, don't get cancelled in there */
+		pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &state);
+		g_idle_add(thread_msg_cb, msg);
+		pthread_setcancelstate(state, NULL);
+
+		return len;
+	}
+
 	if (err == stderr) {
 		fprintf(stderr, buf, NULL);
 		gtk_text_buffer_insert_with_tags_by_name(buffer, &iter,
@@ -308,540 +414,365 @@ int print_output_sys(void *err, const char *str, ...)
 	return len;
 }
 
-static void analyse(struct jesd204b_xcvr_eyescan_info *info,
-		    unsigned long long *data, unsigned int width,
-		    unsigned int height, FILE *gp)
+/* Replaces the eye shown in eye_area, takes over the reference of @eye */
+static void show_eye(struct jesd_eye *eye)
 {
-	unsigned *data_u32 = (unsigned *)data;
-	unsigned int x, y;
-	int xmin, xmax;
-	int ymin, ymax;
-
-	xmin = -1;
-	xmax = -1;
-	y = (height + 1) / 2;
-
-	for (x = 0; x < width; x++) {
-		if (!(info->lpm ? data_u32[y * width + x] & 0x0000FFFF :
-		      data[y * width + x] & 0xFFFF0000FFFF)) {
-			if (xmin == -1) {
-				xmin = x;
-			}
-
-			xmax = x;
-		}
-	}
-
-	ymin = -1;
-	ymax = -1;
-	x = (width + 1) / 2;
-
-	for (y = 0; y < height; y++) {
-		if (!(info->lpm ? data_u32[y * width + x] & 0x0000FFFF :
-		      data[y * width + x] & 0xFFFF0000FFFF)) {
-			if (ymin == -1) {
-				ymin = y;
-			}
-
-			ymax = y;
-		}
-	}
-
-	y = (height + 1) / 2;
-	x = (width + 1) / 2;
-	xmin -= x;
-	xmax -= x;
-	ymin -= y;
-	ymax -= y;
-
-	fprintf(gp, "set label 'Eye-Opening:' at -0.48,-90 front\n");
-	fprintf(gp, "set label 'H: %.3f (UI)' at -0.48,-105 front\n",
-		(float)xmax / ((float)info->es_hsize) - (float)xmin / ((float)info->es_hsize));
-	fprintf(gp, "set label 'V: %d (CODES)' at -0.48,-120 front\n",
-		ymax - ymin);
-
-	print_output_sys(stdout, "   H: %.3f (UI)\n",
-			 (float)xmax / ((float)info->es_hsize)  - (float)xmin / ((float)info->es_hsize));
-	print_output_sys(stdout, "   V: %d (CODES)\n", ymax - ymin);
+	jesd_eye_put(shown_eye);
+	shown_eye = eye;
+	gtk_widget_queue_draw(eye_area);
 }
 
-double calc_ber(struct jesd204b_xcvr_eyescan_info *info,
-		unsigned long long smpl, unsigned prescale)
+static gboolean eye_area_draw_cb(GtkWidget *widget, cairo_t *cr, gpointer data)
 {
-	unsigned long long err_ut0, err_ut1, cnt_ut0, cnt_ut1;
-	double ber;
-
-	if (info->lpm) {
-		err_ut0 = smpl & 0xFFFF;
-		cnt_ut0 = (smpl >> 16) & 0xFFFF;
+	int width = gtk_widget_get_allocated_width(widget);
+	int height = gtk_widget_get_allocated_height(widget);
 
-		if ((err_ut0) == 0) {
-			ber = 1 / (double)((info->cdr_data_width << (1 + prescale)) * cnt_ut0);
-		} else {
-			ber = err_ut0 / (double)((info->cdr_data_width << (1 + prescale)) * cnt_ut0);
-		}
-
-	} else {
-		err_ut0 = smpl & 0xFFFF;
-		err_ut1 = (smpl >> 32) & 0xFFFF;
-		cnt_ut0 = (smpl >> 16) & 0xFFFF;
-		cnt_ut1 = (smpl >> 48) & 0xFFFF;
-
-		if ((err_ut0 + err_ut1) == 0)
-			ber =
-				1 / (double)((info->cdr_data_width << (1 + prescale)) *
-					     (cnt_ut0 + cnt_ut1));
-		else
-			ber = (err_ut0 * cnt_ut1 + err_ut1 * cnt_ut0) /
-			      (double)(2 * (info->cdr_data_width << (1 + prescale)) * cnt_ut0 * cnt_ut1);
+	if (shown_eye == NULL || jesd_eye_render(cr, shown_eye, width, height)) {
+		cairo_set_source_rgb(cr, 1, 1, 1);
+		cairo_paint(cr);
 	}
 
-	return ber;
+	return FALSE;
 }
 
-int plot(struct jesd204b_xcvr_eyescan_info *info, char *file, unsigned lane,
-	 unsigned p, char *file_png)
+static const char *xcvr_short_name(unsigned xcvr)
 {
-	static FILE *gp = NULL;
-	int ret, i, cnt;
-	unsigned long long *buf;
-	unsigned *buf_lpm;
+	const char *name = strrchr(xcvr_devices[xcvr], '/');
 
-	FILE *pFile;
-
-	if (gp == NULL) {
-		gp = popen("gnuplot", "w");
-	}
-
-	if (gp == NULL) {
-		print_output_sys(stderr, "No Gnuplot found - Please install gnuplot-x11 !\n");
-		return -1;
-	}
-
-	/* Check for integer overflow */
-	if (info->es_hsize > 0 && info->es_vsize > UINT_MAX / info->es_hsize) {
-		print_output_sys(stderr, "Error: eye scan dimensions too large\n");
-		return -1;
-	}
+	return name ? name + 1 : xcvr_devices[xcvr];
+}
 
-	cnt = info->es_hsize * info->es_vsize;	/* X,Y */
+static void eye_filename(char *buf, size_t len, unsigned xcvr, unsigned lane,
+			 unsigned prescale)
+{
+	/* Keep the historic names when only one transceiver is scanned */
+	if (num_xcvr_scans > 1)
+		snprintf(buf, len, "xcvr%u_lane%u_p%u.eye", xcvr, lane, prescale);
+	else
+		snprintf(buf, len, "lane%u_p%u.eye", lane, prescale);
+}
 
-	/* Check for malloc size overflow */
-	size_t elem_size = info->lpm ? 4 : 8;
-	if (cnt > 0 && elem_size > SIZE_MAX / cnt) {
-		print_output_sys(stderr, "Error: allocation size too large\n");
-		return -1;
-	}
+static gboolean scan_events_cb(gpointer data);
 
-	buf = malloc(cnt * elem_size);
-	buf_lpm = (unsigned *) buf;
+/* Producer side, the main loop is woken once per batch */
+static void scan_event_post(struct xcvr_scan *scan, struct scan_event *ev)
+{
+	struct scan_event_queue *q = &scan->events;
+	unsigned tail = q->tail;
+	int state;
 
-	if (buf == NULL) {
-		print_output_sys(stderr, "Error: Failed to allocate memory\n");
-		return -ENOMEM;
-	}
+	ev->run = scan->run;
 
-	if (file_png == NULL) {
-		/* This doesn't work for all versions of GTK/Gnuplot:
-		 * https://stackoverflow.com/questions/41209199/cannot-embed-gnuplot-x11-window-into-gtk3-socket
-		 */
-		fprintf(gp, "set term x11 window \"%x\"\n",
-			(unsigned int)gtk_socket_get_id(GTK_SOCKET(sock)));
-		fprintf(gp, "set mouse nozoomcoordinates\n");
-		fprintf(gp, "set autoscale\n");
-	} else {
-		fprintf(gp, "set term png\n");
-		fprintf(gp, "set output '%s'\n", file_png);
-	}
+	/* Full, the main loop is busy drawing */
+	while (tail - __atomic_load_n(&q->head, __ATOMIC_ACQUIRE) == SCAN_EVENTS)
+		g_usleep(1000);
 
+	q->ev[tail % SCAN_EVENTS] = *ev;
+	__atomic_store_n(&q->tail, tail + 1, __ATOMIC_RELEASE);
 
-	fprintf(gp, "set decimalsign locale\n");
-	fprintf(gp, "set view map\n");
-	fprintf(gp, "unset label\n");
-	fprintf(gp, "set contour base\n");
-	fprintf(gp, "set ylabel 'Vertical Offset (CODES)'\n");
-	fprintf(gp, "set xlabel 'Horizontal Offset (UI)'\n");
-	fprintf(gp, "set palette rgbformulae 7,5,15\n");
-	fprintf(gp, "set title '"
-		"JESD204 Lane%i @ %.2f Gbps %s (Max BER %.1e)'\n",
-		lane, (double)info->lane_rate / 1000000, info->lpm ? "LPM" : "DFE",
-		calc_ber(info, 0xFFFF0000FFFF0000, p));
-
-	fprintf(gp,
-		"set label 'Xilinx 2D Statistical Eye Scan' at graph 0.0,1.2 left front\n");
-
-	fprintf(gp, "set grid xtics ytics front lc rgb 'grey'\n");
-	fprintf(gp, "set cblabel 'BER 10E'\n");
-	fprintf(gp, "set cntrparam levels incremental -1,-1,%i\n",
-		(int)log10(calc_ber(info, 0xFFFF0000FFFF0000, p)));
-	fprintf(gp,
-		"set arrow from -0.175,0 to 0,22.5 nohead front lw 1 lc rgb \'white\'\n");
-	fprintf(gp,
-		"set arrow from 0,22.5 to 0.175,0 nohead front lw 1 lc rgb \'white\'\n");
-	fprintf(gp,
-		"set arrow from 0.175,0 to 0,-22.5 nohead front lw 1 lc rgb \'white\'\n");
-	fprintf(gp,
-		"set arrow from 0,-22.5 to -0.175,0 nohead front lw 1 lc rgb \'white\'\n");
-	fprintf(gp, "set label 'MASK' at 0,0 center front tc rgb 'white'\n");
-
-	pFile = fopen(file, "r");
-	ret = fread(buf, info->lpm ? 4 : 8, cnt, pFile);
-	fclose(pFile);
-
-	if (ret != cnt) {
-		print_output_sys(stderr, "%s:%d: read failed\n", __func__, __LINE__);
-		return -EINVAL;
+	if (!__atomic_exchange_n(&scan_events_pending, 1, __ATOMIC_ACQ_REL)) {
+		pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &state);
+		g_idle_add(scan_events_cb, NULL);
+		pthread_setcancelstate(state, NULL);
 	}
+}
 
-	analyse(info, buf, info->es_hsize, info->es_vsize, gp);
-
-	fprintf(gp, "splot '-' using 2:1:(log10($3)) with pm3d title ' '\n");
+/* Acquisition pipeline callback, runs for every eye of @priv's scan */
+static void eye_done(void *priv, unsigned lane, unsigned prescale,
+		     struct jesd_eye *eye, int err)
+{
+	struct xcvr_scan *scan = priv;
+	struct scan_event ev = {
+		.type = SCAN_EVENT_EYE,
+		.lane = lane,
+		.prescale = prescale,
+		.err = err,
+	};
+	struct jesd_eye_opening op;
+	unsigned long long start;
+	char temp[PATH_MAX];
+	int ret;
 
-	fflush(gp);
+	if (!err) {
+		ev.timing = eye->timing;
 
-	for (i = 0; i < cnt; i++) {
-		if (i % info->es_hsize == 0) {
-			fprintf(gp, "\n");
+		start = jesd_time_us();
+		if (persist_eyes) {
+			eye_filename(temp, sizeof(temp), scan->xcvr, lane, prescale);
+			ret = jesd_eye_save(eye, temp);
+			if (ret)
+				print_output_sys(stderr, "%s: write failed (%d)\n", temp, ret);
 		}
+		ev.timing.persist_us = jesd_time_us() - start;
 
-		fprintf(gp, "%f %f %e\n",
-			((float)(i / info->es_hsize) - (info->es_vsize / 2)),
-			((float)(i % info->es_hsize) - (info->es_hsize / 2)) / (info->es_hsize - 1),
-			calc_ber(info, info->lpm ? buf_lpm[i] : buf[i], p));
-
-	}
+		start = jesd_time_us();
+		jesd_eye_analyse(eye, &op);
+		ev.timing.analyse_us = jesd_time_us() - start;
 
-	fprintf(gp, "e\n");
-	fflush(gp);
+		jesd_eye_timing_add(&scan->timing, &ev.timing);
 
-	if (buf) {
-		free(buf);
+		ev.converged = scan->adaptive &&
+			       jesd_eye_converged(&scan->conv[lane], &op);
+		if (ev.converged)
+			scan->lane_active &= ~(1 << lane);
 	}
 
-	return 0;
-}
-
-int write_sysfs(char *filename, char *basedir, char *val)
-{
-	return jesd_write_attr(basedir, filename, val);
+	scan_event_post(scan, &ev);
 }
 
-int get_eye_data(struct jesd204b_xcvr_eyescan_info *info, char *filename,
-		 char *basedir, char *filename_out)
+static void save_timing_report(void)
 {
-	FILE *sysfsfp = NULL, *pFile;
-	char temp[PATH_MAX];
-	unsigned long long *buf;
-	char *hex_buf = NULL;
-	char *hex_buf2 = NULL;
-	int ret = 0;
-	/* Check for integer overflow */
-	if (info->es_hsize > 0 && info->es_vsize > UINT_MAX / info->es_hsize) {
-		return -EINVAL;
-	}
-
-	unsigned cnt = info->es_hsize * info->es_vsize;	/* X,Y */
-
-	/* Check for malloc size overflow */
-	size_t elem_size = info->lpm ? 4 : 8;
-	if (cnt > 0 && elem_size > SIZE_MAX / cnt) {
-		return -EINVAL;
-	}
+	struct jesd_eye_timing_entry *entries;
+	unsigned i;
+	int ret;
 
-	size_t total_size = cnt * elem_size;
-	buf = malloc(total_size);
+	entries = calloc(num_eye_results, sizeof(*entries));
+	if (entries == NULL)
+		return;
 
-	if (buf == NULL) {
-		return -ENOMEM;
+	for (i = 0; i < num_eye_results; i++) {
+		entries[i].device = xcvr_short_name(xcvr_scans[eye_results[i].scan].xcvr);
+		entries[i].lane = eye_results[i].lane;
+		entries[i].prescale = eye_results[i].prescale;
+		entries[i].t = eye_results[i].timing;
 	}
 
-	/* Try libiio first if available */
-	if (g_jesd_iio_ctx) {
-		size_t chunk_size = 4095; /* 4096 - 1 for null terminator */
-		unsigned idx = 0;
-
-		/* For libiio, construct the full filename path for reading */
-		struct iio_device *dev = get_iio_device_from_path(basedir);
+	ret = jesd_eye_timing_save(timing_report, entries, num_eye_results);
+	if (ret)
+		print_output_sys(stderr, "%s: write failed (%d)\n", timing_report, ret);
+	else
+		print_output_sys(stdout, "Timing report written to %s\n", timing_report);
 
-		/* Allocate buffer for hex string reads */
-		hex_buf2 = malloc(chunk_size + 1);
-		if (hex_buf2 == NULL) {
-			free(buf);
-			return -ENOMEM;
-		}
+	free(entries);
+}
 
-		if (dev) {
-			long long int  eye_data_available;
+static void scan_event_eye(struct xcvr_scan *scan, struct scan_event *ev)
+{
+	struct jesd204b_xcvr_eyescan_info *info = &scan->info;
+	char temp[PATH_MAX];
 
-			/* Wait for data to be available */
-			do {
-				sleep(1);
-				ret = jesd_iio_device_attr_read_longlong(dev, "eye_data_available", &eye_data_available);
-				if (ret < 0 && ret != -EBUSY) {
-					fprintf(stderr, "Failed to read eye_data_available: %d\n", ret);
-					goto error_cleanup;
-				}
-			} while (ret == -EBUSY);
-
-			/* Read data in chunks until we have all bytes */
-			while (idx < cnt) {
-				hex_buf = hex_buf2;
-				ret = jesd_iio_device_attr_read(dev, "eye_data_partial", hex_buf, chunk_size + 1);
-				if (ret < 0) {
-					print_output_sys(stderr, "%s:%d: read failed (%d)\n",
-							 __func__, __LINE__, ret);
-					goto error_cleanup;
-				}
+	scan_steps_done++;
 
+	if (ev->err)
+		return;
 
-				// Parse the comma-separated hex string
-				char *saveptr = NULL;
-				char *token = strtok_r(hex_buf, ",", &saveptr);
+	if (ev->converged) {
+		scan_steps_total -= scan->pmax - ev->prescale;
 
-				while (token && idx < cnt) {
-					if (info->lpm) {
-						((unsigned *)buf)[idx] = (unsigned)strtoul(token, NULL, 16);
-					} else {
-						((unsigned long long *)buf)[idx] = strtoull(token, NULL, 16);
-					}
-					token = strtok_r(NULL, ",", &saveptr);
-					idx++;
-				}
-			}
-			ret = idx;
-		}
-	} else {
-		/* Use sysfs method */
-		snprintf(temp, sizeof(temp), "%s/%s", basedir, filename);
-		sysfsfp = fopen(temp, "r");
+		if (ev->prescale < scan->pmax)
+			print_output_sys(stdout, "%s%sLane %d converged at %.2e\n",
+					 num_xcvr_scans > 1 ? xcvr_short_name(scan->xcvr) : "",
+					 num_xcvr_scans > 1 ? " " : "",
+					 ev->lane, calc_ber(info, 0xFFFF0000FFFF0000, ev->prescale));
+	}
 
-		if (sysfsfp == NULL) {
-			free(buf);
-			return -errno;
-		}
+	if (num_eye_results >= ARRAY_SIZE(eye_results))
+		return;
 
-		ret = fread(buf, info->lpm ? 4 : 8, cnt, sysfsfp);
-		fclose(sysfsfp);
-	}
+	eye_results[num_eye_results].scan = scan - xcvr_scans;
+	eye_results[num_eye_results].lane = ev->lane;
+	eye_results[num_eye_results].prescale = ev->prescale;
+	eye_results[num_eye_results].timing = ev->timing;
+	num_eye_results++;
 
-	if (ret != cnt) {
-		print_output_sys(stderr, "%s:%d: read failed ret %d cnt %d\n", __func__, __LINE__, ret, cnt);
-		return -EINVAL;
-	}
+	if (num_xcvr_scans > 1)
+		snprintf(temp, sizeof(temp), "%s Lane %d : %.2e", xcvr_short_name(scan->xcvr),
+			 ev->lane, calc_ber(info, 0xFFFF0000FFFF0000, ev->prescale));
+	else
+		snprintf(temp, sizeof(temp), "Lane %d : %.2e",
+			 ev->lane, calc_ber(info, 0xFFFF0000FFFF0000, ev->prescale));
 
-	pFile = fopen(filename_out, "w");
+	gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(finished_eyes),
+				       (const gchar *)temp);
 
-	if (pFile == NULL) {
-		print_output_sys(stderr, "%s:%d: open failed\n", __func__, __LINE__);
-		free(buf);
-		return -errno;
+	if (!is_first) {
+		gtk_combo_box_set_active(GTK_COMBO_BOX(finished_eyes), 0);
+		is_first++;
 	}
+}
 
-	ret = fwrite(buf, info->lpm ? 4 : 8, cnt, pFile);
-	fclose(pFile);
-	free(buf);
+static void scan_event_done(struct xcvr_scan *scan)
+{
+	struct jesd_eye_timing total = { 0 };
+	unsigned i;
 
-	if (ret != cnt) {
-		print_output_sys(stderr, "%s:%d: write failed\n", __func__, __LINE__);
-		return -EINVAL;
-	}
+	jesd_eye_timing_print(stdout, xcvr_short_name(scan->xcvr), &scan->timing);
 
+	if (--scans_active)
+		return;
 
-	return 0;
-error_cleanup:
-	if (sysfsfp)
-		fclose(sysfsfp);
-	if (hex_buf)
-		free(hex_buf);
-	if (buf)
-		free(buf);
-	return ret;
+	for (i = 0; i < num_xcvr_scans; i++)
+		jesd_eye_timing_add(&total, &xcvr_scans[i].timing);
 
+	if (num_xcvr_scans > 1)
+		jesd_eye_timing_print(stdout, "Total", &total);
 
+	if (timing_report)
+		save_timing_report();
 }
 
-int get_eye(struct jesd204b_xcvr_eyescan_info *info, unsigned lane,
-	    unsigned prescale)
+/* Consumer side, applies everything queued since the last call */
+static gboolean scan_events_cb(gpointer data)
 {
-	char temp[64];
-	int ret;
+	struct scan_event_queue *q;
+	struct scan_event *ev;
+	unsigned i, head, tail, steps = scan_steps_done;
 
-	if (!work_run) {
-		return 0;
-	}
+	__atomic_store_n(&scan_events_pending, 0, __ATOMIC_RELEASE);
 
-	snprintf(temp, sizeof(temp), "%d", prescale);
+	for (i = 0; i < num_xcvr_scans; i++) {
+		q = &xcvr_scans[i].events;
+		tail = __atomic_load_n(&q->tail, __ATOMIC_ACQUIRE);
 
-	write_sysfs(JESD204B_PRESCALE, info->gt_interface_path, temp);
+		for (head = q->head; head != tail; head++) {
+			ev = &q->ev[head % SCAN_EVENTS];
 
-	snprintf(temp, sizeof(temp), "%d", lane);
-	write_sysfs(JESD204B_LANE_ENABLE, info->gt_interface_path, temp);
+			/* Results of a run that was cleared in the meantime */
+			if (ev->run != scan_run)
+				continue;
 
-	snprintf(temp, sizeof(temp), "lane%d_p%d.eye", lane, prescale);
-	ret = get_eye_data(info, JESD204B_EYE_DATA, info->gt_interface_path, temp);
-	if (ret) {
-		return ret;
+			if (ev->type == SCAN_EVENT_EYE)
+				scan_event_eye(&xcvr_scans[i], ev);
+			else
+				scan_event_done(&xcvr_scans[i]);
+		}
+
+		__atomic_store_n(&q->head, head, __ATOMIC_RELEASE);
 	}
 
-	snprintf(temp, sizeof(temp), "Lane %d : %.2e",
-		 lane, calc_ber(info, 0xFFFF0000FFFF0000, prescale));
+	if (steps != scan_steps_done)
+		gtk_progress_bar_set_fraction(GTK_PROGRESS_BAR(progressbar1),
+					      (float)scan_steps_done /
+					      (scan_steps_total ? scan_steps_total : 1));
 
-	/* gdk_threads_enter() is deprecated */
-	gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(finished_eyes),
-				       (const gchar *)temp);
+	return G_SOURCE_REMOVE;
+}
 
-	if (!is_first) {
-		gtk_combo_box_set_active(GTK_COMBO_BOX(finished_eyes), 0);
-		is_first++;
-	}
+/* Also runs when Terminate cancelled the worker */
+static void worker_cleanup(void *arg)
+{
+	struct xcvr_scan *scan = arg;
+	struct scan_event ev = { .type = SCAN_EVENT_DONE };
 
-	/* gdk_threads_leave() is deprecated */
+	/* Eyes still queued are processed first, this thread posts from now on */
+	jesd_eye_pipeline_destroy(scan->pl);
+	scan->pl = NULL;
 
-	return 0;
+	scan_event_post(scan, &ev);
 }
 
-int read_eyescan_info(const char *basedir,
-		      struct jesd204b_xcvr_eyescan_info *info)
+/*
+ * Prescales are scanned from low to high. While the next lane scans, the
+ * previous one is decoded and analysed by the acquisition pipeline. In
+ * adaptive mode a lane is dropped as soon as its eye opening stopped
+ * changing, deeper prescales then only cost time, so every prescale waits
+ * for the pipeline to catch up.
+ */
+void *worker(void *args)
 {
-	FILE *pFile;
-	char temp[PATH_MAX];
-	int ret;
+	struct xcvr_scan *scan = args;
+	unsigned lane_en = scan->lane_en, p, l;
 
-	if (g_jesd_iio_ctx && strstr(basedir, "iio:")) {
-		char buf[1024];
-		ret = jesd_read_attr(basedir, "eyescan_info", buf, sizeof(buf));
-		if (ret < 0) {
-			print_output_sys(stderr, "Failed to read eyescan_info attribute\n");
-			print_output_sys(stderr, "Select axi-adxcvr-rx device!\n");
-			return ret;
-		}
+	pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, NULL);
 
-		pFile = fmemopen(buf, strlen(buf), "r");
-		if (!pFile) {
-			return -errno;
-		}
-	} else {
-		snprintf(temp, sizeof(temp), "%s/eyescan_info", basedir);
-		pFile = fopen(temp, "r");
+	memset(scan->conv, 0, sizeof(scan->conv));
+	memset(&scan->timing, 0, sizeof(scan->timing));
+	scan->lane_active = lane_en;
 
-		if (pFile == NULL) {
-			print_output_sys(stderr, "Failed to read JESD204 device file: %s\n",
-					 temp);
+	scan->pl = jesd_eye_pipeline_create(eye_done, scan);
+	if (scan->pl == NULL)
+		print_output_sys(stderr, "%s: failed to start acquisition\n",
+				 xcvr_short_name(scan->xcvr));
 
-			print_output_sys(stderr, "Select axi-adxcvr-rx device!\n");
+	pthread_cleanup_push(worker_cleanup, scan);
 
-			return -errno;
+	for (p = scan->pmin; scan->pl && p <= scan->pmax && lane_en && work_run; p++) {
+		for (l = 0; l < MAX_LANES && work_run; l++)
+			if (lane_en & (1 << l))
+				/* Failures are reported through eye_done() */
+				jesd_eye_pipeline_acquire(scan->pl, &scan->info, l, p,
+							  &scan->stats);
+
+		/* The pipeline owns lane_active until it caught up */
+		if (scan->adaptive) {
+			jesd_eye_pipeline_sync(scan->pl);
+			lane_en = scan->lane_active;
 		}
 	}
 
-	ret = fscanf(pFile, "x%d,y%d CDRDW: %llu LPM: %d NL: %d LR: %lu\n",
-		     &info->es_hsize, &info->es_vsize, &info->cdr_data_width,
-		     &info->lpm, &info->num_lanes, &info->lane_rate);
-
-	fclose(pFile);
-
-	if (ret != 6) {
-		print_output_sys(stderr, "Failed to read full eyescan_info\n");
-		return -EINVAL;
-	}
+	pthread_cleanup_pop(1);
 
 	return 0;
 }
 
-void *worker(void *args)
+static struct eye_result *get_selected_eye(void)
 {
-	struct jesd204b_xcvr_eyescan_info *info = args;
-	unsigned lane_en = 0, p = 0, pmin, pmax, l, i = 0;
-
-	/* GTK3 no longer requires explicit thread locking */
-	/* gdk_threads_enter() is deprecated */
+	struct eye_result *res = NULL;
+	gint idx;
 
-	for (l = 0; l < MAX_LANES; l++) {
-		lane_en |= gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(lane[l])) << l;
-	}
+	idx = gtk_combo_box_get_active(GTK_COMBO_BOX(finished_eyes));
 
-	pmin = gtk_combo_box_get_active(GTK_COMBO_BOX(min_ber));
-	pmax = gtk_combo_box_get_active(GTK_COMBO_BOX(max_ber));
-
-	/* gdk_threads_leave() is deprecated */
+	if (idx >= 0 && (unsigned)idx < num_eye_results)
+		res = &eye_results[idx];
 
-	if (pmin > pmax) {
-		p = pmin;
-		pmin = pmax;
-		pmax = p;
-	}
+	return res;
+}
 
-	pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, NULL);
+/*
+ * Samples of a finished eye come from the cache, evicted entries are reloaded
+ * from their .eye file when those are kept.
+ */
+static struct jesd_eye *get_result_eye(struct eye_result *res)
+{
+	struct jesd204b_xcvr_eyescan_info *info = &xcvr_scans[res->scan].info;
+	char eye_file[PATH_MAX];
+	struct jesd_eye *eye;
 
-	for (p = pmin; p <= pmax; p++) {
-		gtk_progress_bar_set_fraction(GTK_PROGRESS_BAR(progressbar1),
-					      (float)(i++) / ((pmax - pmin) ? (pmax - pmin) : 1));
+	eye = jesd_eye_cache_get(info->gt_interface_path, res->lane, res->prescale);
+	if (eye)
+		return eye;
 
-		for (l = 0; l < MAX_LANES; l++)
-			if (lane_en & (1 << l)) {
-				get_eye(info, l, p);
-			}
+	if (persist_eyes) {
+		eye_filename(eye_file, sizeof(eye_file), xcvr_scans[res->scan].xcvr,
+			     res->lane, res->prescale);
+		eye = jesd_eye_load(info, res->lane, res->prescale, eye_file);
 	}
 
-	gtk_progress_bar_set_fraction(GTK_PROGRESS_BAR(progressbar1), 1.0);
+	if (eye == NULL)
+		print_output_sys(stderr, "Eye data of Lane %d no longer available, rescan\n",
+				 res->lane);
 
-	return 0;
+	return eye;
 }
 
 void save_plot_pressed_cb(GtkButton *button, gpointer user_data)
 {
+	struct jesd204b_xcvr_eyescan_info *info;
+	struct eye_result *res;
+	struct jesd_eye *eye;
 	GtkWidget *dialog;
 	char temp[PATH_MAX];
-	unsigned lane, prescale = 0;  /* Initialize to avoid undefined behavior */
-	gchar *item;
-	double tmp, tmp2, places;
-	unsigned int i;
-	int found = 0;
-
-	struct jesd204b_xcvr_eyescan_info *info = &eyescan_info;
-
-	item = gtk_combo_box_text_get_active_text(GTK_COMBO_BOX_TEXT(finished_eyes));
-
-	if (item == NULL) {
-		return;
-	}
-
-	if (sscanf(item, "Lane %d : %lf", &lane, &tmp) != 2) {
-		print_output_sys(stderr, "Error: Invalid item format\n");
-		g_free(item);
-		return;
-	}
+	double ber;
+	int ret;
 
-	if (lane >= MAX_LANES) {
-		print_output_sys(stderr, "Error: lane %u exceeds MAX_LANES (%d)\n", lane, MAX_LANES);
-		g_free(item);
+	res = get_selected_eye();
+	if (res == NULL) {
 		return;
 	}
 
-	for (i = 0; i <= MAX_PRESCALE; i++) {
-		tmp2 = calc_ber(info, 0xFFFF0000FFFF0000, i);
-		places = pow(10.0, round(abs(log10(tmp2))));
-		tmp2 = (round(tmp2 * places * 1000.0)) / (places * 1000.0);
-
-		if (tmp2 == tmp) {
-			prescale = i;
-			found = 1;
-			break;
-		}
-	}
-
-	if (!found) {
-		print_output_sys(stderr, "Error: Could not find matching prescale value\n");
-		g_free(item);
+	eye = get_result_eye(res);
+	if (eye == NULL) {
 		return;
 	}
 
-	/* Create a new buffer for the file name since we can't modify 'item' */
-	char eye_filename[PATH_MAX];
-	snprintf(eye_filename, sizeof(eye_filename), "lane%d_p%d.eye", lane, prescale);
-	snprintf(temp, sizeof(temp), "lane%d_%.2eBERT.png", lane, tmp);
+	info = &eye->info;
+	ber = calc_ber(info, 0xFFFF0000FFFF0000, res->prescale);
 
-	g_free(item);  /* Free the GTK allocated string */
+	if (num_xcvr_scans > 1)
+		snprintf(temp, sizeof(temp), "xcvr%u_lane%d_%.2eBERT.png",
+			 xcvr_scans[res->scan].xcvr, res->lane, ber);
+	else
+		snprintf(temp, sizeof(temp), "lane%d_%.2eBERT.png", res->lane, ber);
 
 	dialog = gtk_file_chooser_dialog_new("Save File",
 					     NULL,
@@ -861,84 +792,149 @@ void save_plot_pressed_cb(GtkButton *button, gpointer user_data)
 
 		filename =
 			gtk_file_chooser_get_filename(GTK_FILE_CHOOSER(dialog));
-		plot(info, eye_filename, lane, prescale, filename);
+		ret = jesd_eye_render_png(eye, filename, JESD_EYE_PNG_WIDTH,
+					  JESD_EYE_PNG_HEIGHT);
+		if (ret)
+			print_output_sys(stderr, "%s: save failed (%d)\n", filename, ret);
 		g_free(filename);
 
 	}
 
 	gtk_widget_destroy(dialog);
+	jesd_eye_put(eye);
 }
 
 void show_pressed_cb(GtkButton *button, gpointer user_data)
 {
-	unsigned lane, prescale = 0;
-	double tmp, tmp2, places;
-	unsigned int i;
-
-	gchar *item =
-		gtk_combo_box_text_get_active_text(GTK_COMBO_BOX_TEXT
-						   (finished_eyes));
+	struct jesd204b_xcvr_eyescan_info *info;
+	struct jesd_eye_opening op;
+	struct eye_result *res;
+	struct jesd_eye *eye;
 
-	if (item == NULL) {
+	res = get_selected_eye();
+	if (res == NULL) {
 		return;
 	}
 
-	struct jesd204b_xcvr_eyescan_info *info = &eyescan_info;
-
 	text_view_delete();
 
-	if (sscanf(item, "Lane %d : %lf", &lane, &tmp) != 2) {
-		print_output_sys(stderr, "Error: Invalid item format\n");
-		g_free(item);
+	eye = get_result_eye(res);
+	if (eye == NULL) {
 		return;
 	}
 
-	if (lane >= MAX_LANES) {
-		print_output_sys(stderr, "Error: lane %u exceeds MAX_LANES (%d)\n", lane, MAX_LANES);
-		g_free(item);
-		return;
+	info = &eye->info;
+
+	if (num_xcvr_scans > 1)
+		print_output_sys(stdout, "%s\n", xcvr_short_name(xcvr_scans[res->scan].xcvr));
+	print_output_sys(stdout, "LANE%d P(%d) @ %.2f Gbps\n", res->lane, res->prescale,
+			 (double)info->lane_rate / 1000000);
+	print_output_sys(stdout, "Eye Center:\n  ERR: 0 BER: %.3e\n",
+			 calc_ber(info, 0xFFFF0000FFFF0000, res->prescale));
+
+	jesd_eye_analyse(eye, &op);
+	print_output_sys(stdout, "   H: %.3f (UI)\n", op.h_ui);
+	print_output_sys(stdout, "   V: %d (CODES)\n", op.v_codes);
+
+	show_eye(eye);
+}
+
+static int scan_running(void)
+{
+	unsigned i;
+
+	for (i = 0; i < num_xcvr_scans; i++) {
+		if (!xcvr_scans[i].thread)
+			continue;
+
+		if (pthread_tryjoin_np(xcvr_scans[i].thread, NULL))
+			return 1;
+
+		xcvr_scans[i].thread = 0;
 	}
 
-	for (i = 0; i <= MAX_PRESCALE; i++) {
-		tmp2 = calc_ber(info, 0xFFFF0000FFFF0000, i);
-		places = pow(10.0, round(abs(log10(tmp2))));
-		tmp2 = (round(tmp2 * places * 1000.0)) / (places * 1000.0);
+	return 0;
+}
 
-		if (tmp2 == tmp) {
-			prescale = i;
-			break;
-		}
+static int add_xcvr_scan(unsigned xcvr, unsigned lane_en, unsigned pmin,
+			 unsigned pmax, unsigned adapt)
+{
+	struct xcvr_scan *scan = &xcvr_scans[num_xcvr_scans];
+	int ret;
+
+	memset(scan, 0, sizeof(*scan));
+
+	ret = snprintf(scan->info.gt_interface_path, sizeof(scan->info.gt_interface_path),
+		       "%s/%s", basedir, xcvr_devices[xcvr]);
+	if (ret < 0) {
+		return ret;
 	}
 
-	/* Create a new buffer for the file name since we can't modify 'item' */
-	char eye_filename[PATH_MAX];
-	snprintf(eye_filename, sizeof(eye_filename), "lane%d_p%d.eye", lane, prescale);
+	ret = read_eyescan_info(scan->info.gt_interface_path, &scan->info);
+	if (ret) {
+		return ret;
+	}
 
-	print_output_sys(stdout, "LANE%d P(%d) @ %.2f Gbps\n", lane, prescale,
-			 (double)info->lane_rate / 1000000);
-	print_output_sys(stdout, "Eye Center:\n  ERR: 0 BER: %.3e\n",
-			 calc_ber(info, 0xFFFF0000FFFF0000, prescale));
+	scan->xcvr = xcvr;
+	scan->lane_en = lane_en;
+	if (scan->info.num_lanes < MAX_LANES)
+		scan->lane_en &= (1U << scan->info.num_lanes) - 1;
+	scan->pmin = pmin;
+	scan->pmax = pmax;
+	scan->adaptive = adapt;
+	scan->run = scan_run;
+
+	scan_steps_total += __builtin_popcount(scan->lane_en) * (pmax - pmin + 1);
+	num_xcvr_scans++;
 
-	plot(info, eye_filename, lane, prescale, NULL);
-	g_free(item);  /* Use g_free for GTK allocated memory */
+	return 0;
 }
 
 void start_pressed_cb(GtkButton *button, gpointer user_data)
 {
-	struct jesd204b_xcvr_eyescan_info *info = &eyescan_info;
-	int ret;
+	unsigned lane_en = 0, pmin, pmax, adapt, p, l, i;
 
-	if (work) {
-		ret = pthread_tryjoin_np(work, NULL);
-		if (ret) {
-			print_output_sys(stderr, "Wait until previous run terminates\n");
-			return;
-		}
+	if (scan_running()) {
+		print_output_sys(stderr, "Wait until previous run terminates\n");
+		return;
 	}
 
-	ret = read_eyescan_info(info->gt_interface_path, info);
+	/* Apply what the previous run still has queued before reusing its state */
+	scan_events_cb(NULL);
+	scan_run++;
 
-	if (ret) {
+	/* Snapshot the settings, the workers must not touch the widgets */
+	for (l = 0; l < MAX_LANES; l++) {
+		lane_en |= gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(lane[l])) << l;
+	}
+
+	pmin = gtk_combo_box_get_active(GTK_COMBO_BOX(min_ber));
+	pmax = gtk_combo_box_get_active(GTK_COMBO_BOX(max_ber));
+	adapt = gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(adaptive));
+
+	if (pmin > pmax) {
+		p = pmin;
+		pmin = pmax;
+		pmax = p;
+	}
+
+	num_xcvr_scans = 0;
+	num_eye_results = 0;
+	jesd_eye_cache_clear();
+	scan_steps_done = 0;
+	scan_steps_total = 0;
+
+	if (scan_all) {
+		for (i = 0; i < num_xcvr_devices; i++)
+			if (add_xcvr_scan(i, lane_en, pmin, pmax, adapt))
+				print_output_sys(stderr, "Skipping %s\n", xcvr_devices[i]);
+	} else {
+		i = gtk_combo_box_get_active(GTK_COMBO_BOX(device_select));
+		if (i < num_xcvr_devices)
+			add_xcvr_scan(i, lane_en, pmin, pmax, adapt);
+	}
+
+	if (!num_xcvr_scans) {
 		return;
 	}
 
@@ -947,14 +943,23 @@ void start_pressed_cb(GtkButton *button, gpointer user_data)
 			     (gtk_combo_box_get_model
 			      (GTK_COMBO_BOX(finished_eyes))));
 	is_first = 0;
-	pthread_create(&work, NULL, worker, info);
+	gtk_progress_bar_set_fraction(GTK_PROGRESS_BAR(progressbar1), 0.0);
+
+	/* Independent transceivers are scanned concurrently */
+	scans_active = num_xcvr_scans;
+	for (i = 0; i < num_xcvr_scans; i++)
+		pthread_create(&xcvr_scans[i].thread, NULL, worker, &xcvr_scans[i]);
 }
 
 void terminate_pressed_cb(GtkButton *button, gpointer user_data)
 {
+	unsigned i;
+
 	work_run = 0;
-	if (work) {
-		pthread_cancel(work);
+	for (i = 0; i < num_xcvr_scans; i++) {
+		if (xcvr_scans[i].thread) {
+			pthread_cancel(xcvr_scans[i].thread);
+		}
 	}
 }
 
@@ -972,13 +977,20 @@ void device_select_pressed_cb(GtkComboBoxText *combo_box, gpointer user_data)
 		return;
 	}
 
+	scan_all = !strcmp(item, SCAN_ALL_XCVR);
+
 	ret = snprintf(info->gt_interface_path, sizeof(info->gt_interface_path),
-		       "%s/%s", basedir, item);
+		       "%s/%s", basedir, scan_all ? xcvr_devices[0] : item);
+	g_free(item);
 
 	if (ret < 0) {
 		return;
 	}
 
+	/* Eyes of a scan still running are dropped as well */
+	scan_run++;
+	num_eye_results = 0;
+	jesd_eye_cache_clear();
 	gtk_list_store_clear(GTK_LIST_STORE(gtk_combo_box_get_model(GTK_COMBO_BOX(
 									    finished_eyes))));
 	text_view_delete();
@@ -989,6 +1001,18 @@ void device_select_pressed_cb(GtkComboBoxText *combo_box, gpointer user_data)
 		return;
 	}
 
+	/* Offer enough lanes for the widest transceiver */
+	if (scan_all) {
+		struct jesd204b_xcvr_eyescan_info tmp;
+
+		for (i = 1; i < num_xcvr_devices; i++) {
+			snprintf(tmp.gt_interface_path, sizeof(tmp.gt_interface_path),
+				 "%s/%s", basedir, xcvr_devices[i]);
+			if (!read_eyescan_info(tmp.gt_interface_path, &tmp))
+				info->num_lanes = MAX(info->num_lanes, tmp.num_lanes);
+		}
+	}
+
 	gtk_combo_box_text_remove_all(GTK_COMBO_BOX_TEXT(min_ber));
 	gtk_combo_box_text_remove_all(GTK_COMBO_BOX_TEXT(max_ber));
 
@@ -1202,15 +1226,15 @@ GtkWidget *set_per_lane_status(struct jesd204b_laneinfo *info, unsigned lanes, i
 	return grid;
 }
 
-int jesd_update_status(const char *path)
+int jesd_update_status(struct jesd_device *jdev)
 {
 	struct jesd204b_jesd204_status info;
 	float measured, reported, div40;
 	GdkRGBA color;
 	int encoder;
 
-	jesd_read_jesd204_status(path, &info);
-	encoder = jesd_read_encoding(path);
+	jesd_device_read_status(jdev, &info);
+	encoder = jesd_device_encoder(jdev);
 
 	set_lable_text(link_state, (char *) &info.link_state, "enabled", 0);
 	set_lable_text(link_status, (char *)&info.link_status, "DATA", 0);
@@ -1290,10 +1314,37 @@ int jesd_update_status(const char *path)
 	return encoder;
 }
 
+/* Handle of the selected JESD204 core, reopened when the selection changes */
+static struct jesd_device *get_status_device(const char *item)
+{
+	static struct jesd_device *jdev;
+	char *path;
+
+	if (g_jesd_iio_ctx)
+		path = strdup(item);
+	else
+		path = get_full_device_path(basedir, item);
+
+	if (!path)
+		return NULL;
+
+	if (jdev && strcmp(jesd_device_path(jdev), path)) {
+		jesd_device_close(jdev);
+		jdev = NULL;
+	}
+
+	if (!jdev)
+		jdev = jesd_device_open(path);
+
+	free(path);
+
+	return jdev;
+}
+
 static int update_status(GtkComboBoxText *combo_box, int *encoder)
 {
+	struct jesd_device *jdev;
 	int cnt = 0;
-	char *path;
 
 	gchar *item = gtk_combo_box_text_get_active_text(GTK_COMBO_BOX_TEXT(combo_box));
 
@@ -1302,25 +1353,15 @@ static int update_status(GtkComboBoxText *combo_box, int *encoder)
 	}
 
 	g_mutex_lock(mutex);
-	if (g_jesd_iio_ctx) {
-		path = strdup(item);
-		*encoder = jesd_update_status(path);
-		cnt = jesd_read_all_laneinfo(path, lane_info);
-		grid = set_per_lane_status(lane_info, cnt, *encoder, path);
-		free(path);
-	} else {
-		path = get_full_device_path(basedir, item);
-		if (!path) {
-			g_free(item);
-			g_mutex_unlock(mutex);
-			return 0;
-		}
-		*encoder = jesd_update_status(path);
-		cnt = jesd_read_all_laneinfo(path, lane_info);
-		grid = set_per_lane_status(lane_info, cnt, *encoder, path);
-		free(path);
+	jdev = get_status_device(item);
+	if (jdev) {
+		*encoder = jesd_update_status(jdev);
+		cnt = jesd_device_read_all_laneinfo(jdev, lane_info);
+		grid = set_per_lane_status(lane_info, cnt, *encoder,
+					   jesd_device_path(jdev));
 	}
 	g_mutex_unlock(mutex);
+	g_free(item);
 
 	return cnt;
 }
@@ -1357,8 +1398,20 @@ int main(int argc, char *argv[])
 	char *uri = NULL;
 	opterr = 0;
 
-	while ((c = getopt(argc, argv, "p:u:")) != -1)
+	/* Only this thread may touch GTK, see print_output_sys() */
+	main_thread = pthread_self();
+
+	while ((c = getopt(argc, argv, "p:u:c:nt:")) != -1)
 		switch (c) {
+		case 'c':
+			jesd_eye_cache_set_limit(strtoul(optarg, NULL, 0) << 20);
+			break;
+		case 'n':
+			persist_eyes = 0;
+			break;
+		case 't':
+			timing_report = optarg;
+			break;
 		case 'p':
 			path = optarg;
 			remote = 1;
@@ -1368,10 +1421,11 @@ int main(int argc, char *argv[])
 			remote = 1;
 			break;
 		case '?':
-			if (optopt == 'd' || optopt == 'p') {
+			if (optopt == 'd' || optopt == 'p' || optopt == 'u' || optopt == 'c' ||
+			    optopt == 't') {
 				fprintf(stderr, "Option -%c requires an argument.\n", optopt);
 			} else if (isprint(optopt))
-				fprintf(stderr, "Unknown option `-%c'.\n%s [-p PATH] [-d DEVICEINDEX]\n",
+				fprintf(stderr, "Unknown option `-%c'.\n%s [-p PATH] [-u URI] [-c CACHE_MB] [-n] [-t TIMING_JSON]\n",
 					optopt, argv[0]);
 			else
 				fprintf(stderr,
@@ -1388,7 +1442,15 @@ int main(int argc, char *argv[])
 		path = "";
 	}
 
-	if (uri) {
+	if (uri && !strncmp(uri, JESD_EYE_SIM_PREFIX, strlen(JESD_EYE_SIM_PREFIX))) {
+		if (jesd_eye_sim_create(uri + strlen(JESD_EYE_SIM_PREFIX)))
+			return EXIT_FAILURE;
+		strcpy(basedir, JESD_EYE_SIM_BASEDIR);
+	} else if (uri && !strncmp(uri, JESD_MONITOR_PREFIX, strlen(JESD_MONITOR_PREFIX))) {
+		if (jesd_monitor_attach(uri + strlen(JESD_MONITOR_PREFIX)))
+			return EXIT_FAILURE;
+		strcpy(basedir, JESD_MONITOR_BASEDIR);
+	} else if (uri) {
 		/* Use libiio */
 		g_jesd_iio_ctx = jesd_iio_create_context(uri);
 		if (!g_jesd_iio_ctx) {
@@ -1478,14 +1540,15 @@ int main(int argc, char *argv[])
 		GTK_WIDGET(gtk_builder_get_object(builder, "progressbar1"));
 
 	box2 = GTK_WIDGET(gtk_builder_get_object(builder, "box2"));
-	sock = gtk_socket_new();
-	gtk_widget_set_hexpand(sock, TRUE);
-	gtk_widget_set_halign(sock, GTK_ALIGN_FILL);
-	gtk_widget_set_vexpand(sock, TRUE);
-	gtk_widget_set_valign(sock, GTK_ALIGN_FILL);
-	gtk_widget_show(sock);
-	gtk_container_add(GTK_CONTAINER(box2), sock);
-	gtk_widget_set_size_request(GTK_WIDGET(sock), 480, 360);
+	eye_area = gtk_drawing_area_new();
+	gtk_widget_set_hexpand(eye_area, TRUE);
+	gtk_widget_set_halign(eye_area, GTK_ALIGN_FILL);
+	gtk_widget_set_vexpand(eye_area, TRUE);
+	gtk_widget_set_valign(eye_area, GTK_ALIGN_FILL);
+	g_signal_connect(G_OBJECT(eye_area), "draw", G_CALLBACK(eye_area_draw_cb), NULL);
+	gtk_widget_show(eye_area);
+	gtk_container_add(GTK_CONTAINER(box2), eye_area);
+	gtk_widget_set_size_request(GTK_WIDGET(eye_area), 480, 360);
 
 	box3 = GTK_WIDGET(gtk_builder_get_object(builder, "jesd_info"));
 	view = create_view_and_model(cnt);
@@ -1501,6 +1564,8 @@ int main(int argc, char *argv[])
 	max_ber = GTK_WIDGET(gtk_builder_get_object(builder, "comboboxtext3"));
 	gtk_combo_box_text_remove(GTK_COMBO_BOX_TEXT(max_ber), 0);
 
+	adaptive = GTK_WIDGET(gtk_builder_get_object(builder, "adaptive"));
+
 	device_select = GTK_WIDGET(gtk_builder_get_object(builder,
 							  "comboboxtext_device_select"));
 	gtk_combo_box_text_remove(GTK_COMBO_BOX_TEXT(device_select), 0);
@@ -1516,9 +1581,15 @@ int main(int argc, char *argv[])
 	g_signal_connect(G_OBJECT(main_window), "destroy",
 			 G_CALLBACK(gtk_main_quit), NULL);
 
-	if (!get_devices(basedir, XCVR_DRIVER_NAME, "eyescan_info", device_select)) {
-		get_devices(basedir, XCVR_NEW_DRIVER_NAME, "eyescan_info", device_select);
+	num_xcvr_devices = get_devices(basedir, XCVR_DRIVER_NAME, "eyescan_info", device_select);
+	if (!num_xcvr_devices) {
+		num_xcvr_devices = get_devices(basedir, XCVR_NEW_DRIVER_NAME, "eyescan_info",
+					       device_select);
 	}
+	memcpy(xcvr_devices, jesd_devices, sizeof(xcvr_devices));
+
+	if (num_xcvr_devices > 1)
+		gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(device_select), SCAN_ALL_XCVR);
 	get_devices(basedir, JESD204_RX_DRIVER_NAME, "status", jesd_core_selection);
 	if (!g_jesd_iio_ctx) {
 		get_devices(basedir, JESD204_TX_DRIVER_NAME, "status", jesd_core_selection);
@@ -1544,6 +1615,7 @@ int main(int argc, char *argv[])
 
 	if (g_jesd_iio_ctx)
 		jesd_iio_destroy_context(g_jesd_iio_ctx);
+	jesd_monitor_detach();
 
 	return 0;
 }
@@ -0,0 +1,497 @@
+/***************************************************************************//**
+ *   @file   jesd_eye_scan_cli.c
+ *   @brief  JESD204 Headless Eye Scan Utility
+ *   @author Michael Hennerich (michael.hennerich@analog.com)
+********************************************************************************
+* Copyright 2026(c) Analog Devices, Inc. All rights reserved.
+*
+* An ADI specific BSD license, which can be found in the top level directory
+* of this repository (LICENSE.txt), and also on-line at:
+* https://github.com/analogdevicesinc/jesd-eye-scan-gtk/blob/main/LICENSE.txt
+*******************************************************************************/
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <unistd.h>
+#include <string.h>
+#include <ctype.h>
+#include <limits.h>
+#include <pthread.h>
+
+#include "jesd_common.h"
+#include "jesd_eye_data.h"
+#include "jesd_eye_sim.h"
+#include "jesd_monitor.h"
+#ifdef HAVE_CAIRO
+#include "jesd_eye_render.h"
+#endif
+
+/* One acquisition thread per transceiver, as in jesd_eye_scan */
+struct xcvr_scan {
+	struct jesd204b_xcvr_eyescan_info info;
+	pthread_t thread;
+	unsigned xcvr;
+	unsigned lane_en;
+	struct jesd_xfer_stats stats;
+	struct jesd_eye_timing timing;
+	int ret;
+	/* Adaptive mode, updated by the acquisition pipeline */
+	struct jesd_eye_convergence conv[MAX_LANES];
+	unsigned lane_active;
+};
+
+char basedir[PATH_MAX];
+char xcvr_devices[MAX_DEVICES][PATH_MAX];
+unsigned num_xcvr_devices;
+
+struct xcvr_scan xcvr_scans[MAX_DEVICES];
+unsigned num_xcvr_scans;
+
+unsigned pmin, pmax;
+unsigned adaptive;
+unsigned write_png;
+char *outdir;
+FILE *metrics;
+char *timing_report;
+struct jesd_eye_timing_entry *timings;
+unsigned num_timings;
+pthread_mutex_t output_lock = PTHREAD_MUTEX_INITIALIZER;
+
+int print_output_sys(void *err, const char *str, ...)
+{
+	va_list args;
+	int ret;
+
+	va_start(args, str);
+	pthread_mutex_lock(&output_lock);
+	ret = vfprintf(err, str, args);
+	pthread_mutex_unlock(&output_lock);
+	va_end(args);
+
+	return ret;
+}
+
+static const char *xcvr_short_name(unsigned xcvr)
+{
+	const char *name = strrchr(xcvr_devices[xcvr], '/');
+
+	return name ? name + 1 : xcvr_devices[xcvr];
+}
+
+/* Same names as jesd_eye_scan uses */
+static void eye_filename(char *buf, size_t len, unsigned xcvr, unsigned lane,
+			 unsigned prescale, const char *ext)
+{
+	if (num_xcvr_scans > 1)
+		snprintf(buf, len, "%s/xcvr%u_lane%u_p%u.%s", outdir, xcvr, lane,
+			 prescale, ext);
+	else
+		snprintf(buf, len, "%s/lane%u_p%u.%s", outdir, lane, prescale, ext);
+}
+
+static void report_eye(struct xcvr_scan *scan, struct jesd_eye *eye,
+		       struct jesd_eye_opening *op)
+{
+	double ber = calc_ber(&scan->info, 0xFFFF0000FFFF0000, eye->prescale);
+
+	pthread_mutex_lock(&output_lock);
+
+	printf("%s,%u,%u,%.3e,%.3f,%d\n", xcvr_short_name(scan->xcvr), eye->lane,
+	       eye->prescale, ber, op->h_ui, op->v_codes);
+	fflush(stdout);
+
+	if (metrics) {
+		fprintf(metrics, "%s,%u,%u,%.3e,%.3f,%d\n", xcvr_short_name(scan->xcvr),
+			eye->lane, eye->prescale, ber, op->h_ui, op->v_codes);
+		fflush(metrics);
+	}
+
+	pthread_mutex_unlock(&output_lock);
+}
+
+static int save_eye(struct xcvr_scan *scan, struct jesd_eye *eye)
+{
+	char file[PATH_MAX];
+	int ret;
+
+	eye_filename(file, sizeof(file), scan->xcvr, eye->lane, eye->prescale, "eye");
+	ret = jesd_eye_save(eye, file);
+	if (ret) {
+		print_output_sys(stderr, "%s: write failed (%d)\n", file, ret);
+		return ret;
+	}
+
+#ifdef HAVE_CAIRO
+	if (write_png) {
+		eye_filename(file, sizeof(file), scan->xcvr, eye->lane, eye->prescale,
+			     "png");
+		ret = jesd_eye_render_png(eye, file, JESD_EYE_PNG_WIDTH,
+					  JESD_EYE_PNG_HEIGHT);
+		if (ret)
+			print_output_sys(stderr, "%s: write failed (%d)\n", file, ret);
+	}
+#endif
+
+	return ret;
+}
+
+/* Keeps the phases of every eye for the -t report */
+static void record_timing(struct xcvr_scan *scan, struct jesd_eye *eye,
+			  const struct jesd_eye_timing *t)
+{
+	struct jesd_eye_timing_entry *e;
+
+	jesd_eye_timing_add(&scan->timing, t);
+
+	if (!timing_report)
+		return;
+
+	pthread_mutex_lock(&output_lock);
+
+	e = realloc(timings, (num_timings + 1) * sizeof(*timings));
+	if (e) {
+		timings = e;
+		e += num_timings++;
+		e->device = xcvr_short_name(scan->xcvr);
+		e->lane = eye->lane;
+		e->prescale = eye->prescale;
+		e->t = *t;
+	}
+
+	pthread_mutex_unlock(&output_lock);
+}
+
+/* Acquisition pipeline callback, runs for every eye of @priv's scan */
+static void eye_done(void *priv, unsigned lane, unsigned prescale,
+		     struct jesd_eye *eye, int err)
+{
+	struct xcvr_scan *scan = priv;
+	struct jesd_eye_timing timing;
+	struct jesd_eye_opening op;
+	unsigned long long start;
+
+	if (err) {
+		print_output_sys(stderr, "%s: Lane %u prescale %u failed (%d)\n",
+				 xcvr_short_name(scan->xcvr), lane, prescale, err);
+		scan->ret = err;
+		return;
+	}
+
+	timing = eye->timing;
+
+	start = jesd_time_us();
+	jesd_eye_analyse(eye, &op);
+	timing.analyse_us = jesd_time_us() - start;
+
+	report_eye(scan, eye, &op);
+
+	start = jesd_time_us();
+	if (outdir && save_eye(scan, eye))
+		scan->ret = -EIO;
+	timing.persist_us = jesd_time_us() - start;
+
+	record_timing(scan, eye, &timing);
+
+	if (adaptive && jesd_eye_converged(&scan->conv[lane], &op))
+		scan->lane_active &= ~(1 << lane);
+}
+
+/*
+ * The pipeline decodes, reports and saves an eye while the next lane scans,
+ * adaptive runs wait for it after every prescale to drop converged lanes.
+ */
+static void *worker(void *args)
+{
+	struct xcvr_scan *scan = args;
+	struct jesd_eye_pipeline *pl;
+	unsigned lane_en = scan->lane_en, p, l;
+
+	scan->lane_active = lane_en;
+
+	pl = jesd_eye_pipeline_create(eye_done, scan);
+	if (pl == NULL) {
+		scan->ret = -ENOMEM;
+		return NULL;
+	}
+
+	for (p = pmin; p <= pmax && lane_en; p++) {
+		for (l = 0; l < MAX_LANES; l++) {
+			if (!(lane_en & (1 << l)))
+				continue;
+
+			/* Failures are reported through eye_done() */
+			jesd_eye_pipeline_acquire(pl, &scan->info, l, p, &scan->stats);
+		}
+
+		/* The pipeline owns lane_active until it caught up */
+		if (adaptive) {
+			jesd_eye_pipeline_sync(pl);
+			lane_en = scan->lane_active;
+		}
+	}
+
+	jesd_eye_pipeline_destroy(pl);
+
+	jesd_eye_timing_print(stderr, xcvr_short_name(scan->xcvr), &scan->timing);
+
+	return NULL;
+}
+
+static int add_xcvr_scan(unsigned xcvr, unsigned lane_en)
+{
+	struct xcvr_scan *scan = &xcvr_scans[num_xcvr_scans];
+	int ret;
+
+	memset(scan, 0, sizeof(*scan));
+
+	ret = snprintf(scan->info.gt_interface_path, sizeof(scan->info.gt_interface_path),
+		       "%s/%s", basedir, xcvr_devices[xcvr]);
+	if (ret < 0)
+		return ret;
+
+	ret = read_eyescan_info(scan->info.gt_interface_path, &scan->info);
+	if (ret)
+		return ret;
+
+	scan->xcvr = xcvr;
+	scan->lane_en = lane_en;
+	if (scan->info.num_lanes < MAX_LANES)
+		scan->lane_en &= (1U << scan->info.num_lanes) - 1;
+
+	num_xcvr_scans++;
+
+	return 0;
+}
+
+/* DEVICE is an index into the -L list, a unique part of a name, or "all" */
+static int select_xcvr(const char *device)
+{
+	char *end;
+	unsigned i;
+	int match = -1;
+
+	i = strtoul(device, &end, 0);
+	if (*device && !*end)
+		return i < num_xcvr_devices ? (int)i : -ENODEV;
+
+	for (i = 0; i < num_xcvr_devices; i++) {
+		if (!strstr(xcvr_devices[i], device))
+			continue;
+
+		if (match >= 0) {
+			fprintf(stderr, "Device '%s' is ambiguous\n", device);
+			return -EINVAL;
+		}
+
+		match = i;
+	}
+
+	return match >= 0 ? match : -ENODEV;
+}
+
+static void usage(const char *name)
+{
+	fprintf(stderr,
+		"%s [-p PATH | -u URI] [-L] [-d DEVICE|all] [-l LANEMASK]\n"
+		"\t[-m MIN_PRESCALE] [-M MAX_PRESCALE] [-a] [-o DIR] [-g] [-t FILE]\n"
+		"  -u\tlibiio URI, sim:[OPTIONS] for simulated transceivers or\n"
+		"\tmonitor:[SOCKET] for jesd_monitord\n"
+		"  -L\tlist transceivers and exit\n"
+		"  -d\ttransceiver index, name or 'all' (default 0)\n"
+		"  -l\tlanes to scan (default all)\n"
+		"  -m, -M\tprescale range (default 0)\n"
+		"  -a\tadaptive, stop a lane once its eye opening converged\n"
+		"  -o\twrite .eye files and metrics.csv to DIR\n"
+		"  -g\talso write a PNG plot per eye (requires -o)\n"
+		"  -t\twrite a JSON report of the time spent per phase and eye\n", name);
+}
+
+int main(int argc, char *argv[])
+{
+	unsigned lane_en = ~0U, i, list = 0;
+	char *path = NULL, *uri = NULL, *device = "0";
+	struct jesd_eye_timing total = { 0 };
+	char temp[PATH_MAX];
+	int c, ret = 0;
+
+	opterr = 0;
+
+	while ((c = getopt(argc, argv, "p:u:d:l:m:M:o:t:agLh")) != -1)
+		switch (c) {
+		case 'p':
+			path = optarg;
+			break;
+		case 'u':
+			uri = optarg;
+			break;
+		case 'd':
+			device = optarg;
+			break;
+		case 'l':
+			lane_en = strtoul(optarg, NULL, 0);
+			break;
+		case 'm':
+			pmin = strtoul(optarg, NULL, 0);
+			break;
+		case 'M':
+			pmax = strtoul(optarg, NULL, 0);
+			break;
+		case 'o':
+			outdir = optarg;
+			break;
+		case 't':
+			timing_report = optarg;
+			break;
+		case 'a':
+			adaptive = 1;
+			break;
+		case 'g':
+			write_png = 1;
+			break;
+		case 'L':
+			list = 1;
+			break;
+		case 'h':
+			usage(argv[0]);
+			return 0;
+		case '?':
+			if (strchr("pudlmMot", optopt))
+				fprintf(stderr, "Option -%c requires an argument.\n", optopt);
+			else if (isprint(optopt))
+				fprintf(stderr, "Unknown option `-%c'.\n", optopt);
+			else
+				fprintf(stderr, "Unknown option character `\\x%x'.\n", optopt);
+
+			usage(argv[0]);
+			return 1;
+
+		default:
+			abort();
+		}
+
+	if (pmin > pmax)
+		pmax = pmin;
+
+	if (pmax > MAX_PRESCALE) {
+		fprintf(stderr, "Prescale must not exceed %d\n", MAX_PRESCALE);
+		return EXIT_FAILURE;
+	}
+
+	if (write_png && !outdir) {
+		fprintf(stderr, "PNG output (-g) requires an output directory (-o)\n");
+		return EXIT_FAILURE;
+	}
+
+#ifndef HAVE_CAIRO
+	if (write_png) {
+		fprintf(stderr, "PNG output not available, built without cairo\n");
+		return EXIT_FAILURE;
+	}
+#endif
+
+	if (uri && !strncmp(uri, JESD_EYE_SIM_PREFIX, strlen(JESD_EYE_SIM_PREFIX))) {
+		if (jesd_eye_sim_create(uri + strlen(JESD_EYE_SIM_PREFIX)))
+			return EXIT_FAILURE;
+		strcpy(basedir, JESD_EYE_SIM_BASEDIR);
+	} else if (uri && !strncmp(uri, JESD_MONITOR_PREFIX, strlen(JESD_MONITOR_PREFIX))) {
+		if (jesd_monitor_attach(uri + strlen(JESD_MONITOR_PREFIX)))
+			return EXIT_FAILURE;
+		strcpy(basedir, JESD_MONITOR_BASEDIR);
+	} else if (uri) {
+		g_jesd_iio_ctx = jesd_iio_create_context(uri);
+		if (!g_jesd_iio_ctx) {
+			fprintf(stderr, "Failed to create IIO context\n");
+			return EXIT_FAILURE;
+		}
+		strcpy(basedir, "iio:context");
+	} else {
+		ret = snprintf(basedir, sizeof(basedir), "%s/sys/bus/platform/drivers",
+			       path ? path : "");
+		if (ret < 0)
+			return EXIT_FAILURE;
+	}
+
+	ret = jesd_find_xcvr_devices(basedir, xcvr_devices);
+	if (ret <= 0) {
+		fprintf(stderr, "No transceivers with eye scan support found\n");
+		ret = EXIT_FAILURE;
+		goto out;
+	}
+	num_xcvr_devices = ret;
+
+	if (list) {
+		for (i = 0; i < num_xcvr_devices; i++)
+			printf("%u: %s\n", i, xcvr_devices[i]);
+		ret = 0;
+		goto out;
+	}
+
+	if (!strcmp(device, "all")) {
+		for (i = 0; i < num_xcvr_devices; i++)
+			if (add_xcvr_scan(i, lane_en))
+				fprintf(stderr, "Skipping %s\n", xcvr_devices[i]);
+	} else {
+		ret = select_xcvr(device);
+		if (ret < 0) {
+			fprintf(stderr, "Device '%s' not found, see -L\n", device);
+			ret = EXIT_FAILURE;
+			goto out;
+		}
+
+		add_xcvr_scan(ret, lane_en);
+	}
+
+	if (!num_xcvr_scans) {
+		ret = EXIT_FAILURE;
+		goto out;
+	}
+
+	if (outdir) {
+		snprintf(temp, sizeof(temp), "%s/metrics.csv", outdir);
+		metrics = fopen(temp, "w");
+		if (metrics == NULL) {
+			fprintf(stderr, "%s: %s\n", temp, strerror(errno));
+			ret = EXIT_FAILURE;
+			goto out;
+		}
+		fprintf(metrics, "device,lane,prescale,ber,h_ui,v_codes\n");
+	}
+
+	/* Nothing is shown later, free each eye once it has been reported */
+	jesd_eye_cache_set_limit(0);
+
+	printf("device,lane,prescale,ber,h_ui,v_codes\n");
+
+	for (i = 0; i < num_xcvr_scans; i++)
+		pthread_create(&xcvr_scans[i].thread, NULL, worker, &xcvr_scans[i]);
+
+	ret = 0;
+	for (i = 0; i < num_xcvr_scans; i++) {
+		pthread_join(xcvr_scans[i].thread, NULL);
+		if (xcvr_scans[i].ret)
+			ret = EXIT_FAILURE;
+		jesd_eye_timing_add(&total, &xcvr_scans[i].timing);
+	}
+
+	if (num_xcvr_scans > 1)
+		jesd_eye_timing_print(stderr, "Total", &total);
+
+	if (timing_report && jesd_eye_timing_save(timing_report, timings, num_timings)) {
+		fprintf(stderr, "%s: write failed\n", timing_report);
+		ret = EXIT_FAILURE;
+	}
+	free(timings);
+
+	if (metrics)
+		fclose(metrics);
+out:
+	if (g_jesd_iio_ctx)
+		jesd_iio_destroy_context(g_jesd_iio_ctx);
+	jesd_eye_sim_destroy();
+	jesd_monitor_detach();
+
+	return ret;
+}
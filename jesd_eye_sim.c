@@ -0,0 +1,342 @@
+/***************************************************************************//**
+*   @file   jesd_eye_sim.c
+*   @brief  JESD204 Eye Scan Transceiver Simulator
+*   @author Michael Hennerich (michael.hennerich@analog.com)
+********************************************************************************
+* Copyright 2026(c) Analog Devices, Inc. All rights reserved.
+*
+* An ADI specific BSD license, which can be found in the top level directory
+* of this repository (LICENSE.txt), and also on-line at:
+* https://github.com/analogdevicesinc/jesd-eye-scan-gtk/blob/main/LICENSE.txt
+*******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include <pthread.h>
+
+#include "jesd_eye_sim.h"
+
+#define SIM_EYE_AMPLITUDE	0.75	/* eye half height at its center, of full scale */
+#define SIM_SAMPLE_COUNT	0xFFFFULL	/* saturated sample counter */
+
+struct sim_config {
+	unsigned xcvrs;
+	unsigned lanes;
+	unsigned hsize;
+	unsigned vsize;
+	int lpm;
+	unsigned long lane_rate;	/* kbps */
+	double rj;
+	double dj;
+	double noise;
+	double speed;
+};
+
+/* One transceiver, attributes are accessed by its scan thread */
+struct sim_xcvr {
+	pthread_mutex_t lock;
+	unsigned prescale;
+	unsigned lane;
+	unsigned scans;
+	int armed;
+	unsigned long long end_us;	/* scan done */
+};
+
+static struct sim_config cfg;
+static struct sim_xcvr *xcvrs;
+
+/* Lane rate in eyescan_info, a faster scan looks like a faster lane */
+static unsigned long long sim_lane_rate(void)
+{
+	return cfg.lane_rate * cfg.speed;
+}
+
+/* Same estimate jesd_eye_data uses, hardware is a few percent slower */
+static unsigned long long sim_scan_time_us(unsigned prescale, unsigned seed)
+{
+	double bits = (double)(40ULL << (1 + prescale)) * SIM_SAMPLE_COUNT;
+	double us = bits * cfg.hsize * cfg.vsize * 1000.0 / sim_lane_rate();
+
+	return us * (1.02 + (seed % 8) / 100.0);
+}
+
+/*
+ * Dual-Dirac jitter model horizontally, Gaussian noise on an eye that closes
+ * towards the crossings vertically. @ui is the sampling phase (-0.5 .. 0.5),
+ * @v the offset relative to full scale (-1 .. 1).
+ */
+static double sim_ber(double ui, double v, double rj)
+{
+	double margin_h = 0.5 - cfg.dj / 2 - fabs(ui);
+	double margin_v = SIM_EYE_AMPLITUDE * cos(M_PI * ui) - fabs(v);
+	double ber;
+
+	ber = 0.5 * erfc(margin_h / (rj * M_SQRT2)) +
+	      0.5 * erfc(margin_v / (cfg.noise * M_SQRT2));
+
+	return MIN(ber, 0.5);
+}
+
+/* Error count of one unit interval target with counting noise */
+static unsigned long long sim_errors(double ber, double bits, unsigned *seed)
+{
+	double err = ber * bits + (double)rand_r(seed) / RAND_MAX;
+
+	return MIN((unsigned long long)err, SIM_SAMPLE_COUNT);
+}
+
+static void sim_eye_data(struct sim_xcvr *x, void *data)
+{
+	double bits = (double)(40ULL << (1 + x->prescale)) * SIM_SAMPLE_COUNT;
+	unsigned idx = x - xcvrs;
+	/* Lanes and transceivers differ a bit, repeated scans only by counting noise */
+	double rj = cfg.rj * (1 + 0.15 * (x->lane % 4) + 0.05 * (idx % 3));
+	unsigned seed = (x->scans * MAX_DEVICES + idx) * 7919 + x->lane;
+	unsigned long long ut0, ut1;
+	unsigned h, v, i = 0;
+	double ber;
+
+	for (v = 0; v < cfg.vsize; v++)
+		for (h = 0; h < cfg.hsize; h++) {
+			ber = sim_ber((double)h / (cfg.hsize - 1) - 0.5,
+				      2.0 * v / (cfg.vsize - 1) - 1, rj);
+
+			/* u16 errors, u16 samples per UT */
+			ut0 = SIM_SAMPLE_COUNT << 16 | sim_errors(ber, bits, &seed);
+			if (cfg.lpm) {
+				((uint32_t *)data)[i++] = ut0;
+			} else {
+				ut1 = SIM_SAMPLE_COUNT << 16 | sim_errors(ber, bits, &seed);
+				((uint64_t *)data)[i++] = ut1 << 32 | ut0;
+			}
+		}
+}
+
+/* "sim:context/axi_adxcvr/sim1.axi-adxcvr-rx" */
+static struct sim_xcvr *sim_find(const char *path)
+{
+	const char *name = strrchr(path, '/');
+	unsigned idx;
+
+	if (!xcvrs || !name || sscanf(name, "/sim%u.", &idx) != 1 ||
+	    idx >= cfg.xcvrs)
+		return NULL;
+
+	return &xcvrs[idx];
+}
+
+static int sim_find_devices(const char *driver, char devices[MAX_DEVICES][PATH_MAX],
+			    int start)
+{
+	unsigned i;
+	int num = start;
+
+	if (strcmp(driver, XCVR_DRIVER_NAME))
+		return start;
+
+	for (i = 0; i < cfg.xcvrs && num < MAX_DEVICES; i++)
+		snprintf(devices[num++], PATH_MAX, "%s/sim%u.axi-adxcvr-rx",
+			 XCVR_DRIVER_NAME, i);
+
+	return num;
+}
+
+static int sim_read_locked(struct sim_xcvr *x, const char *attr, char *buf,
+			   size_t len)
+{
+	size_t size = (size_t)cfg.hsize * cfg.vsize * (cfg.lpm ? 4 : 8);
+	int ret;
+
+	if (!strcmp(attr, "eyescan_info"))
+		ret = snprintf(buf, len, "x%u,y%u CDRDW: 40 LPM: %d NL: %u LR: %llu\n",
+			       cfg.hsize, cfg.vsize, cfg.lpm, cfg.lanes,
+			       sim_lane_rate());
+	else if (!strcmp(attr, JESD204B_PRESCALE))
+		ret = snprintf(buf, len, "%u\n", x->prescale);
+	else if (!strcmp(attr, JESD204B_LANE_ENABLE))
+		ret = snprintf(buf, len, "%u\n", x->lane);
+	else if (strcmp(attr, "eye_data_available") && strcmp(attr, JESD204B_EYE_DATA))
+		return -ENOENT;
+	else if (!x->armed)
+		return -ENODATA;
+	else if (jesd_time_us() < x->end_us)
+		return -EBUSY;
+	else if (!strcmp(attr, "eye_data_available"))
+		ret = snprintf(buf, len, "1\n");
+	else if (len < size)
+		return -EINVAL;
+	else {
+		sim_eye_data(x, buf);
+		return size;
+	}
+
+	return MIN((size_t)ret, len);
+}
+
+static int sim_read(const char *path, const char *attr, char *buf, size_t len)
+{
+	struct sim_xcvr *x = sim_find(path);
+	int ret;
+
+	if (!x)
+		return -ENODEV;
+
+	pthread_mutex_lock(&x->lock);
+	ret = sim_read_locked(x, attr, buf, len);
+	pthread_mutex_unlock(&x->lock);
+
+	return ret;
+}
+
+/* Writing the lane to enable starts a scan, as with the driver */
+static int sim_write(const char *path, const char *attr, const char *value)
+{
+	struct sim_xcvr *x = sim_find(path);
+	unsigned long val;
+	char *end;
+	int ret = 0;
+
+	if (!x)
+		return -ENODEV;
+
+	val = strtoul(value, &end, 0);
+	if (end == value)
+		return -EINVAL;
+
+	pthread_mutex_lock(&x->lock);
+
+	if (!strcmp(attr, JESD204B_PRESCALE) && val <= MAX_PRESCALE) {
+		x->prescale = val;
+	} else if (!strcmp(attr, JESD204B_LANE_ENABLE) && val < cfg.lanes) {
+		x->lane = val;
+		x->armed = 1;
+		x->end_us = jesd_time_us() + sim_scan_time_us(x->prescale, ++x->scans);
+	} else {
+		ret = -EINVAL;
+	}
+
+	pthread_mutex_unlock(&x->lock);
+
+	return ret;
+}
+
+static const struct jesd_attr_backend sim_backend = {
+	.prefix = JESD_EYE_SIM_PREFIX,
+	.find_devices = sim_find_devices,
+	.read = sim_read,
+	.write = sim_write,
+};
+
+static int sim_parse(const char *options)
+{
+	char *opts, *tok, *saveptr = NULL, *val;
+	int ret = 0;
+
+	opts = strdup(options);
+	if (!opts)
+		return -ENOMEM;
+
+	tok = strtok_r(opts, ",", &saveptr);
+	while (tok) {
+		val = strchr(tok, '=');
+		if (!val) {
+			ret = -EINVAL;
+			break;
+		}
+		*val++ = '\0';
+
+		if (!strcmp(tok, "xcvrs"))
+			cfg.xcvrs = strtoul(val, NULL, 0);
+		else if (!strcmp(tok, "lanes"))
+			cfg.lanes = strtoul(val, NULL, 0);
+		else if (!strcmp(tok, "grid"))
+			ret = sscanf(val, "%ux%u", &cfg.hsize, &cfg.vsize) == 2 ? 0 : -EINVAL;
+		else if (!strcmp(tok, "lpm"))
+			cfg.lpm = !!strtoul(val, NULL, 0);
+		else if (!strcmp(tok, "rate"))
+			cfg.lane_rate = strtoul(val, NULL, 0);
+		else if (!strcmp(tok, "rj"))
+			cfg.rj = strtod(val, NULL);
+		else if (!strcmp(tok, "dj"))
+			cfg.dj = strtod(val, NULL);
+		else if (!strcmp(tok, "noise"))
+			cfg.noise = strtod(val, NULL);
+		else if (!strcmp(tok, "speed"))
+			cfg.speed = strtod(val, NULL);
+		else
+			ret = -EINVAL;
+
+		if (ret)
+			break;
+
+		tok = strtok_r(NULL, ",", &saveptr);
+	}
+
+	if (ret)
+		fprintf(stderr, "Invalid simulator option '%s'\n", tok);
+
+	free(opts);
+
+	return ret;
+}
+
+int jesd_eye_sim_create(const char *options)
+{
+	unsigned i;
+	int ret;
+
+	cfg = (struct sim_config) {
+		.xcvrs = 1,
+		.lanes = 4,
+		.hsize = 65,
+		.vsize = 255,
+		.lpm = 1,
+		.lane_rate = 10000000,
+		.rj = 0.02,
+		.dj = 0.15,
+		.noise = 0.08,
+		.speed = 1,
+	};
+
+	ret = sim_parse(options);
+	if (ret)
+		return ret;
+
+	if (!cfg.xcvrs || cfg.xcvrs > MAX_DEVICES || !cfg.lanes ||
+	    cfg.lanes > MAX_LANES || cfg.hsize < 2 || cfg.vsize < 2 ||
+	    !cfg.lane_rate || cfg.rj <= 0 || cfg.noise <= 0 || cfg.speed <= 0) {
+		fprintf(stderr, "Simulator options out of range\n");
+		return -EINVAL;
+	}
+
+	xcvrs = calloc(cfg.xcvrs, sizeof(*xcvrs));
+	if (!xcvrs)
+		return -ENOMEM;
+
+	for (i = 0; i < cfg.xcvrs; i++)
+		pthread_mutex_init(&xcvrs[i].lock, NULL);
+
+	g_jesd_attr_backend = &sim_backend;
+
+	return 0;
+}
+
+void jesd_eye_sim_destroy(void)
+{
+	unsigned i;
+
+	if (!xcvrs)
+		return;
+
+	g_jesd_attr_backend = NULL;
+
+	for (i = 0; i < cfg.xcvrs; i++)
+		pthread_mutex_destroy(&xcvrs[i].lock);
+
+	free(xcvrs);
+	xcvrs = NULL;
+}
@@ -0,0 +1,42 @@
+/***************************************************************************//**
+*   @file   jesd_eye_sim.h
+*   @brief  JESD204 Eye Scan Transceiver Simulator
+*   @author Michael Hennerich (michael.hennerich@analog.com)
+********************************************************************************
+* Copyright 2026(c) Analog Devices, Inc. All rights reserved.
+*
+* An ADI specific BSD license, which can be found in the top level directory
+* of this repository (LICENSE.txt), and also on-line at:
+* https://github.com/analogdevicesinc/jesd-eye-scan-gtk/blob/main/LICENSE.txt
+*******************************************************************************/
+
+#ifndef JESD_EYE_SIM_H_
+#define JESD_EYE_SIM_H_
+
+#include <stddef.h>
+#include <limits.h>
+
+#include "jesd_common.h"
+
+/*
+ * Simulated axi_adxcvr transceivers behind the path based API: select with
+ * -u sim:[OPTIONS] and use JESD_EYE_SIM_BASEDIR as the driver directory.
+ * OPTIONS is a comma separated list of
+ *   xcvrs=N       transceivers (1)
+ *   lanes=N       lanes per transceiver (4)
+ *   grid=HxV      es_hsize x es_vsize (65x255)
+ *   lpm=0|1       LPM (u32) or DFE (u64) samples (1)
+ *   rate=KBPS     lane rate (10000000)
+ *   rj=UI         random jitter, rms (0.02)
+ *   dj=UI         deterministic jitter, peak to peak (0.15)
+ *   noise=X       vertical noise rms, relative to the eye amplitude (0.08)
+ *   speed=X       scans run X times faster than on hardware, reported as an
+ *                 X times higher lane rate so acquisition estimates match (1)
+ */
+#define JESD_EYE_SIM_PREFIX	"sim:"
+#define JESD_EYE_SIM_BASEDIR	"sim:context"
+
+int jesd_eye_sim_create(const char *options);
+void jesd_eye_sim_destroy(void);
+
+#endif
@@ -0,0 +1,566 @@
+/***************************************************************************//**
+*   @file   jesd_monitor.c
+*   @brief  JESD204 Monitor Daemon Client
+*   @author Michael Hennerich (michael.hennerich@analog.com)
+********************************************************************************
+* Copyright 2026(c) Analog Devices, Inc. All rights reserved.
+*
+* An ADI specific BSD license, which can be found in the top level directory
+* of this repository (LICENSE.txt), and also on-line at:
+* https://github.com/analogdevicesinc/jesd-eye-scan-gtk/blob/main/LICENSE.txt
+*******************************************************************************/
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sched.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "jesd_monitor.h"
+
+/*
+ * Eye scan state of one transceiver. The prescale is only sent along with the
+ * lane, so a scan request is a single message the daemon can serialize.
+ */
+struct monitor_xcvr {
+	pthread_mutex_t lock;
+	int fd;			/* connection, opened on the first request */
+	unsigned prescale;
+	int pending;		/* SCAN sent, response not received */
+	int armed;
+	int err;
+	void *data;
+	size_t len;
+};
+
+static char monitor_socket[sizeof(((struct sockaddr_un *)0)->sun_path)];
+static struct monitor_xcvr monitor_xcvrs[MAX_DEVICES];
+static size_t monitor_size;
+
+const struct jesd_monitor_region *g_jesd_monitor;
+
+int jesd_monitor_recv_line(int fd, char *buf, size_t len)
+{
+	size_t i = 0;
+	ssize_t ret;
+
+	while (i < len - 1) {
+		ret = recv(fd, buf + i, 1, 0);
+		if (ret < 0 && errno == EINTR)
+			continue;
+		if (ret <= 0)
+			return ret ? -errno : -ECONNRESET;
+
+		if (buf[i] == '\n') {
+			buf[i] = '\0';
+			return i;
+		}
+		i++;
+	}
+
+	return -EMSGSIZE;
+}
+
+int jesd_monitor_recv_all(int fd, void *buf, size_t len)
+{
+	size_t off = 0;
+	ssize_t ret;
+
+	while (off < len) {
+		ret = recv(fd, (char *)buf + off, len - off, MSG_WAITALL);
+		if (ret < 0 && errno == EINTR)
+			continue;
+		if (ret <= 0)
+			return ret ? -errno : -ECONNRESET;
+
+		off += ret;
+	}
+
+	return 0;
+}
+
+int jesd_monitor_send_all(int fd, const void *buf, size_t len)
+{
+	size_t off = 0;
+	ssize_t ret;
+
+	while (off < len) {
+		ret = send(fd, (const char *)buf + off, len - off, MSG_NOSIGNAL);
+		if (ret < 0 && errno == EINTR)
+			continue;
+		if (ret < 0)
+			return -errno;
+
+		off += ret;
+	}
+
+	return 0;
+}
+
+static int monitor_connect(void)
+{
+	struct sockaddr_un addr = { .sun_family = AF_UNIX };
+	int fd;
+
+	memcpy(addr.sun_path, monitor_socket, sizeof(addr.sun_path));
+
+	fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (fd < 0)
+		return -errno;
+
+	if (connect(fd, (struct sockaddr *)&addr, sizeof(addr))) {
+		close(fd);
+		return -errno;
+	}
+
+	return fd;
+}
+
+/*
+ * "OK <len>" or "ERR <errno>", the latter sets @err. Returns an error only if
+ * the connection can not be used any longer.
+ */
+static int monitor_response(int fd, size_t *len, int *err)
+{
+	char line[64];
+	unsigned long long val;
+	int ret;
+
+	ret = jesd_monitor_recv_line(fd, line, sizeof(line));
+	if (ret < 0)
+		return ret;
+
+	*len = 0;
+	*err = 0;
+
+	if (sscanf(line, "OK %llu", &val) == 1)
+		*len = val;
+	else if (sscanf(line, "ERR %d", &ret) == 1 && ret > 0)
+		*err = -ret;
+	else
+		return -EPROTO;
+
+	return 0;
+}
+
+static void monitor_disconnect(struct monitor_xcvr *x)
+{
+	close(x->fd);
+	x->fd = -1;
+}
+
+/* Sends @fmt on the transceiver's connection, reconnecting once if it broke */
+static int __attribute__((format(printf, 2, 3)))
+monitor_request(struct monitor_xcvr *x, const char *fmt, ...)
+{
+	char line[JESD_MONITOR_LINE];
+	va_list args;
+	int len, ret, retry;
+
+	va_start(args, fmt);
+	len = vsnprintf(line, sizeof(line), fmt, args);
+	va_end(args);
+
+	if (len < 0 || (size_t)len >= sizeof(line))
+		return -EINVAL;
+
+	for (retry = 0; retry < 2; retry++) {
+		if (x->fd < 0) {
+			x->fd = monitor_connect();
+			if (x->fd < 0)
+				return x->fd;
+		}
+
+		ret = jesd_monitor_send_all(x->fd, line, len);
+		if (!ret)
+			return 0;
+
+		monitor_disconnect(x);
+	}
+
+	return ret;
+}
+
+/* Receives the response to the outstanding SCAN */
+static void monitor_scan_done(struct monitor_xcvr *x)
+{
+	size_t len;
+	void *data;
+	int ret;
+
+	x->pending = 0;
+
+	ret = monitor_response(x->fd, &len, &x->err);
+	if (ret) {
+		x->err = ret;
+		monitor_disconnect(x);
+		return;
+	}
+
+	if (x->err)
+		return;
+
+	data = realloc(x->data, len);
+	if (!data && len) {
+		x->err = -ENOMEM;
+		monitor_disconnect(x);
+		return;
+	}
+
+	x->data = data;
+	x->len = len;
+
+	x->err = jesd_monitor_recv_all(x->fd, x->data, len);
+	if (x->err)
+		monitor_disconnect(x);
+}
+
+/* "monitor:context/axi_adxcvr/84a60000.axi-adxcvr-rx" */
+static const char *monitor_name(const char *path)
+{
+	size_t len = strlen(JESD_MONITOR_BASEDIR);
+
+	if (strncmp(path, JESD_MONITOR_BASEDIR, len) || path[len] != '/')
+		return NULL;
+
+	return path + len + 1;
+}
+
+static int monitor_find(const char *path, const char names[MAX_DEVICES][PATH_MAX],
+			unsigned num)
+{
+	const char *name = monitor_name(path);
+	unsigned i;
+
+	if (!name || !g_jesd_monitor)
+		return -ENODEV;
+
+	for (i = 0; i < num; i++)
+		if (!strcmp(names[i], name))
+			return i;
+
+	return -ENODEV;
+}
+
+static int monitor_find_devices(const char *driver, char devices[MAX_DEVICES][PATH_MAX],
+				int start)
+{
+	const struct jesd_monitor_region *r = g_jesd_monitor;
+	int num = start;
+	unsigned i;
+
+	for (i = 0; i < r->num_links && num < MAX_DEVICES; i++)
+		if (!strcmp(r->link_driver[i], driver))
+			snprintf(devices[num++], PATH_MAX, "%s", r->link_name[i]);
+
+	for (i = 0; i < r->num_xcvrs && num < MAX_DEVICES; i++)
+		if (!strcmp(r->xcvr_driver[i], driver))
+			snprintf(devices[num++], PATH_MAX, "%s", r->xcvr_name[i]);
+
+	return num;
+}
+
+static int monitor_read_locked(struct monitor_xcvr *x, const char *name,
+			       const char *attr, char *buf, size_t len)
+{
+	struct pollfd pfd;
+	size_t size;
+	int ret, err;
+
+	if (!strcmp(attr, "eyescan_info")) {
+		if (x->pending)
+			monitor_scan_done(x);
+
+		ret = monitor_request(x, "INFO %s\n", name);
+		if (ret)
+			return ret;
+
+		ret = monitor_response(x->fd, &size, &err);
+		if (!ret && !err && size <= len)
+			ret = jesd_monitor_recv_all(x->fd, buf, size);
+		else if (!ret && !err)
+			ret = -EINVAL;
+
+		if (ret)
+			monitor_disconnect(x);
+
+		return ret ? ret : err ? err : (int)size;
+	}
+
+	if (strcmp(attr, "eye_data_available") && strcmp(attr, JESD204B_EYE_DATA))
+		return -ENOENT;
+
+	if (!x->armed)
+		return -ENODATA;
+
+	if (x->pending) {
+		pfd.fd = x->fd;
+		pfd.events = POLLIN;
+
+		/* eye_data blocks until the scan is done, as with older drivers */
+		if (!strcmp(attr, "eye_data_available") && poll(&pfd, 1, 0) == 0)
+			return -EBUSY;
+
+		monitor_scan_done(x);
+	}
+
+	if (x->err)
+		return x->err;
+
+	if (!strcmp(attr, "eye_data_available"))
+		return snprintf(buf, len, "1\n");
+
+	if (len < x->len)
+		return -EINVAL;
+
+	memcpy(buf, x->data, x->len);
+
+	return x->len;
+}
+
+static int monitor_read(const char *path, const char *attr, char *buf, size_t len)
+{
+	int idx = monitor_find(path, g_jesd_monitor->xcvr_name, g_jesd_monitor->num_xcvrs);
+	struct monitor_xcvr *x;
+	int ret;
+
+	if (idx < 0)
+		return idx;
+
+	x = &monitor_xcvrs[idx];
+
+	pthread_mutex_lock(&x->lock);
+	ret = monitor_read_locked(x, g_jesd_monitor->xcvr_name[idx], attr, buf, len);
+	pthread_mutex_unlock(&x->lock);
+
+	return ret;
+}
+
+/* Writing the lane to enable sends the scan request, as the driver starts it */
+static int monitor_write(const char *path, const char *attr, const char *value)
+{
+	int idx = monitor_find(path, g_jesd_monitor->xcvr_name, g_jesd_monitor->num_xcvrs);
+	struct monitor_xcvr *x;
+	unsigned long val;
+	char *end;
+	int ret = 0;
+
+	if (idx < 0)
+		return idx;
+
+	val = strtoul(value, &end, 0);
+	if (end == value)
+		return -EINVAL;
+
+	x = &monitor_xcvrs[idx];
+
+	pthread_mutex_lock(&x->lock);
+
+	if (!strcmp(attr, JESD204B_PRESCALE)) {
+		x->prescale = val;
+	} else if (!strcmp(attr, JESD204B_LANE_ENABLE)) {
+		/* A scan nobody read is dropped */
+		if (x->pending)
+			monitor_scan_done(x);
+
+		ret = monitor_request(x, "SCAN %s %lu %u\n", g_jesd_monitor->xcvr_name[idx],
+				      val, x->prescale);
+		x->pending = !ret;
+		x->armed = !ret;
+		x->err = 0;
+	} else {
+		ret = -EINVAL;
+	}
+
+	pthread_mutex_unlock(&x->lock);
+
+	return ret;
+}
+
+/* Seqlock read of one link, retried while the daemon is updating it */
+int jesd_monitor_read_link(unsigned idx, struct jesd_monitor_link *link)
+{
+	const struct jesd_monitor_slot *slot;
+	unsigned seq;
+
+	if (!g_jesd_monitor || idx >= g_jesd_monitor->num_links)
+		return -ENODEV;
+
+	slot = &g_jesd_monitor->slot[idx];
+
+	while (true) {
+		seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+		if (seq & 1) {
+			sched_yield();
+			continue;
+		}
+
+		memcpy(link, &slot->link, sizeof(*link));
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+		if (__atomic_load_n(&slot->seq, __ATOMIC_RELAXED) == seq)
+			break;
+	}
+
+	/* Nothing published yet, or the daemon stopped refreshing */
+	if (!link->generation ||
+	    jesd_time_us() - link->time_us >
+	    JESD_MONITOR_STALE * g_jesd_monitor->refresh_ms * 1000ULL)
+		return -ESTALE;
+
+	return link->err;
+}
+
+static int monitor_read_link(const char *path, int *encoder,
+			     struct jesd204b_jesd204_status *status,
+			     struct jesd204b_laneinfo lane_info[MAX_LANES])
+{
+	int idx = monitor_find(path, g_jesd_monitor->link_name, g_jesd_monitor->num_links);
+	struct jesd_monitor_link *link;
+	int ret;
+
+	if (idx < 0)
+		return idx;
+
+	link = malloc(sizeof(*link));
+	if (!link)
+		return -ENOMEM;
+
+	ret = jesd_monitor_read_link(idx, link);
+	if (!ret) {
+		*encoder = link->encoder;
+		*status = link->status;
+		memcpy(lane_info, link->lane, link->lanes * sizeof(*lane_info));
+		ret = link->lanes;
+	}
+
+	free(link);
+
+	return ret;
+}
+
+static const struct jesd_attr_backend monitor_backend = {
+	.prefix = JESD_MONITOR_PREFIX,
+	.find_devices = monitor_find_devices,
+	.read = monitor_read,
+	.write = monitor_write,
+	.read_link = monitor_read_link,
+};
+
+/* Maps the daemon's region, an empty @socket selects JESD_MONITOR_SOCKET */
+int jesd_monitor_attach(const char *socket)
+{
+	char cbuf[CMSG_SPACE(sizeof(int))], line[64];
+	const struct jesd_monitor_region *r;
+	struct iovec iov = { .iov_base = line, .iov_len = sizeof(line) - 1 };
+	struct msghdr msg = {
+		.msg_iov = &iov,
+		.msg_iovlen = 1,
+		.msg_control = cbuf,
+		.msg_controllen = sizeof(cbuf),
+	};
+	unsigned long long size;
+	struct cmsghdr *cmsg;
+	int fd, mfd = -1, ret;
+	ssize_t len;
+	unsigned i;
+
+	if (!socket || !*socket)
+		socket = JESD_MONITOR_SOCKET;
+
+	if (strlen(socket) >= sizeof(monitor_socket)) {
+		fprintf(stderr, "Socket path too long: %s\n", socket);
+		return -ENAMETOOLONG;
+	}
+	strcpy(monitor_socket, socket);
+
+	fd = monitor_connect();
+	if (fd < 0) {
+		fprintf(stderr, "Failed to connect to %s: %s\n", socket, strerror(-fd));
+		return fd;
+	}
+
+	ret = jesd_monitor_send_all(fd, "ATTACH\n", 7);
+	if (ret)
+		goto out;
+
+	/* The response is short and sent with the fd in one message */
+	len = recvmsg(fd, &msg, MSG_CMSG_CLOEXEC);
+	if (len <= 0) {
+		ret = len ? -errno : -ECONNRESET;
+		goto out;
+	}
+	line[len] = '\0';
+
+	for (cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg))
+		if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS)
+			memcpy(&mfd, CMSG_DATA(cmsg), sizeof(mfd));
+
+	if (mfd < 0 || sscanf(line, "OK %llu", &size) != 1 ||
+	    size < sizeof(struct jesd_monitor_region)) {
+		ret = -EPROTO;
+		goto out;
+	}
+
+	r = mmap(NULL, size, PROT_READ, MAP_SHARED, mfd, 0);
+	if (r == MAP_FAILED) {
+		ret = -errno;
+		goto out;
+	}
+
+	if (r->magic != JESD_MONITOR_MAGIC || r->version != JESD_MONITOR_VERSION ||
+	    r->size != sizeof(*r)) {
+		fprintf(stderr, "%s: incompatible jesd_monitord\n", socket);
+		munmap((void *)r, size);
+		ret = -EPROTO;
+		goto out;
+	}
+
+	for (i = 0; i < MAX_DEVICES; i++) {
+		pthread_mutex_init(&monitor_xcvrs[i].lock, NULL);
+		monitor_xcvrs[i].fd = -1;
+	}
+
+	g_jesd_monitor = r;
+	monitor_size = size;
+	g_jesd_attr_backend = &monitor_backend;
+out:
+	if (ret && ret != -EPROTO)
+		fprintf(stderr, "%s: %s\n", socket, strerror(-ret));
+	if (mfd >= 0)
+		close(mfd);
+	close(fd);
+
+	return ret;
+}
+
+void jesd_monitor_detach(void)
+{
+	unsigned i;
+
+	if (!g_jesd_monitor)
+		return;
+
+	g_jesd_attr_backend = NULL;
+
+	for (i = 0; i < MAX_DEVICES; i++) {
+		if (monitor_xcvrs[i].fd >= 0)
+			close(monitor_xcvrs[i].fd);
+		free(monitor_xcvrs[i].data);
+		pthread_mutex_destroy(&monitor_xcvrs[i].lock);
+	}
+
+	memset(monitor_xcvrs, 0, sizeof(monitor_xcvrs));
+	munmap((void *)g_jesd_monitor, monitor_size);
+	g_jesd_monitor = NULL;
+}
@@ -0,0 +1,95 @@
+/***************************************************************************//**
+*   @file   jesd_monitor.h
+*   @brief  JESD204 Monitor Daemon Shared Memory Layout and Client
+*   @author Michael Hennerich (michael.hennerich@analog.com)
+********************************************************************************
+* Copyright 2026(c) Analog Devices, Inc. All rights reserved.
+*
+* An ADI specific BSD license, which can be found in the top level directory
+* of this repository (LICENSE.txt), and also on-line at:
+* https://github.com/analogdevicesinc/jesd-eye-scan-gtk/blob/main/LICENSE.txt
+*******************************************************************************/
+
+#ifndef JESD_MONITOR_H_
+#define JESD_MONITOR_H_
+
+#include <stddef.h>
+#include <limits.h>
+
+#include "jesd_common.h"
+
+/*
+ * jesd_monitord owns the hardware and polls every link once per refresh. The
+ * snapshots live in a shared memory region, each link in a seqlock protected
+ * slot, clients map it read-only and never touch the hardware themselves.
+ * Eye scans are requested over the daemon's Unix socket, it runs them one at
+ * a time per transceiver.
+ *
+ * Tools select the daemon with -u monitor:[SOCKET] and use
+ * JESD_MONITOR_BASEDIR as the driver directory, link and transceiver paths
+ * then go through the attribute backend like the simulator's do.
+ */
+#define JESD_MONITOR_PREFIX	"monitor:"
+#define JESD_MONITOR_BASEDIR	"monitor:context"
+#define JESD_MONITOR_SOCKET	"/run/jesd_monitord.sock"
+
+#define JESD_MONITOR_MAGIC	0x4d445345	/* "ESDM" */
+#define JESD_MONITOR_VERSION	1
+
+/* Clients report links as stale once the daemon missed this many refreshes */
+#define JESD_MONITOR_STALE	8
+
+struct jesd_monitor_link {
+	int err;			/* read of this refresh failed */
+	int encoder;
+	unsigned lanes;
+	unsigned long long generation;	/* refresh that produced it */
+	unsigned long long time_us;	/* CLOCK_MONOTONIC at the read */
+	unsigned long long read_us;	/* hardware read time */
+	struct jesd204b_jesd204_status status;
+	struct jesd204b_laneinfo lane[MAX_LANES];
+};
+
+/* @seq is odd while the daemon updates @link */
+struct jesd_monitor_slot {
+	unsigned seq;
+	struct jesd_monitor_link link;
+};
+
+/* Names and drivers are set before the region is handed out */
+struct jesd_monitor_region {
+	unsigned magic;
+	unsigned version;
+	unsigned size;			/* sizeof(struct jesd_monitor_region) */
+	unsigned refresh_ms;
+	unsigned num_links;
+	unsigned num_xcvrs;
+	unsigned long long generation;	/* completed refreshes */
+	char link_driver[MAX_DEVICES][MAX_SYSFS_STRING_SIZE];
+	char link_name[MAX_DEVICES][PATH_MAX];
+	char xcvr_driver[MAX_DEVICES][MAX_SYSFS_STRING_SIZE];
+	char xcvr_name[MAX_DEVICES][PATH_MAX];
+	struct jesd_monitor_slot slot[MAX_DEVICES];
+};
+
+/*
+ * Socket protocol, one line per request, one response per request:
+ *   ATTACH                      OK <size>, the region's fd in SCM_RIGHTS
+ *   INFO <xcvr>                 OK <len>, then eyescan_info
+ *   SCAN <xcvr> <lane> <prescale>
+ *                               OK <len>, then the binary eye_data samples
+ * Failures respond with ERR <errno>.
+ */
+#define JESD_MONITOR_LINE	(PATH_MAX + 64)
+
+int jesd_monitor_recv_line(int fd, char *buf, size_t len);
+int jesd_monitor_recv_all(int fd, void *buf, size_t len);
+int jesd_monitor_send_all(int fd, const void *buf, size_t len);
+
+int jesd_monitor_attach(const char *socket);
+void jesd_monitor_detach(void);
+int jesd_monitor_read_link(unsigned idx, struct jesd_monitor_link *link);
+
+extern const struct jesd_monitor_region *g_jesd_monitor;
+
+#endif
@@ -0,0 +1,661 @@
+/***************************************************************************//**
+*   @file   jesd_monitord.c
+*   @brief  JESD204 Monitor Daemon, shared hardware access for all tools
+*   @author Michael Hennerich (michael.hennerich@analog.com)
+********************************************************************************
+* Copyright 2026(c) Analog Devices, Inc. All rights reserved.
+*
+* An ADI specific BSD license, which can be found in the top level directory
+* of this repository (LICENSE.txt), and also on-line at:
+* https://github.com/analogdevicesinc/jesd-eye-scan-gtk/blob/main/LICENSE.txt
+*******************************************************************************/
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <poll.h>
+#include <time.h>
+#include <signal.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/signalfd.h>
+#include <sys/un.h>
+
+#include "jesd_common.h"
+#include "jesd_eye_data.h"
+#include "jesd_eye_sim.h"
+#include "jesd_monitor.h"
+
+#define MONITORD_REFRESH_MS	250	/* as jesd_status */
+#define MONITORD_CLIENTS	32	/* connections served at once */
+
+/*
+ * Last scan of a transceiver. Scans run one at a time, a request for the same
+ * lane and prescale that arrives while one is running gets its result.
+ */
+struct monitord_xcvr {
+	pthread_mutex_t lock;
+	char path[PATH_MAX];
+	unsigned lane;
+	unsigned prescale;
+	unsigned long long end_us;	/* 0: no result */
+	void *data;
+	size_t len;
+};
+
+/* A connection and the thread serving it, joined once it is done */
+struct monitord_conn {
+	pthread_t thread;
+	bool active;		/* thread not joined yet */
+	bool done;		/* thread finished, @fd closed */
+	int fd;
+};
+
+static char basedir[PATH_MAX];
+static struct jesd_device *links[MAX_DEVICES];
+static struct monitord_xcvr xcvrs[MAX_DEVICES];
+
+static struct jesd_monitor_region *region;
+static int region_fd = -1;
+
+static struct monitord_conn conns[MONITORD_CLIENTS];
+static pthread_mutex_t conns_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static pthread_mutex_t stop_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t stop_cond;
+static bool stop;
+
+int print_output_sys(void *err, const char *str, ...)
+{
+	va_list args;
+	int ret;
+
+	va_start(args, str);
+	ret = vfprintf(err, str, args);
+	va_end(args);
+
+	return ret;
+}
+
+static char *monitord_path(const char *device)
+{
+	if (g_jesd_iio_ctx)
+		return strdup(device);
+
+	return get_full_device_path(basedir, device);
+}
+
+/* Shared memory the clients map read-only, sized and sealed once */
+static int monitord_region_create(void)
+{
+	region_fd = memfd_create("jesd_monitor", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+	if (region_fd < 0)
+		return -errno;
+
+	if (ftruncate(region_fd, sizeof(*region)))
+		return -errno;
+
+	region = mmap(NULL, sizeof(*region), PROT_READ | PROT_WRITE, MAP_SHARED,
+		      region_fd, 0);
+	if (region == MAP_FAILED) {
+		region = NULL;
+		return -errno;
+	}
+
+#ifdef F_SEAL_FUTURE_WRITE
+	fcntl(region_fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_FUTURE_WRITE |
+	      F_SEAL_SEAL);
+#else
+	fcntl(region_fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL);
+#endif
+
+	region->magic = JESD_MONITOR_MAGIC;
+	region->version = JESD_MONITOR_VERSION;
+	region->size = sizeof(*region);
+
+	return 0;
+}
+
+static int monitord_find_devices(void)
+{
+	char devices[MAX_DEVICES][PATH_MAX];
+	int num, rx, i;
+
+	if (g_jesd_iio_ctx) {
+		/* libiio does not tell the cores apart, all are listed as RX */
+		num = rx = jesd_iio_find_devices(g_jesd_iio_ctx, devices);
+	} else {
+		num = rx = jesd_find_devices(basedir, JESD204_RX_DRIVER_NAME, "status",
+					     devices, 0);
+		num = jesd_find_devices(basedir, JESD204_TX_DRIVER_NAME, "status",
+					devices, num);
+	}
+
+	for (i = 0; i < num; i++) {
+		snprintf(region->link_driver[i], MAX_SYSFS_STRING_SIZE, "%s",
+			 i < rx ? JESD204_RX_DRIVER_NAME : JESD204_TX_DRIVER_NAME);
+		memcpy(region->link_name[i], devices[i], PATH_MAX);
+	}
+	region->num_links = num;
+
+	num = jesd_find_xcvr_devices(basedir, devices);
+	for (i = 0; i < num; i++) {
+		/* "axi_adxcvr/84a60000.axi-adxcvr-rx", the new driver name keeps its prefix */
+		snprintf(region->xcvr_driver[i], MAX_SYSFS_STRING_SIZE, "%s",
+			 strncmp(devices[i], XCVR_NEW_DRIVER_NAME "/",
+				 strlen(XCVR_NEW_DRIVER_NAME "/")) ?
+			 XCVR_DRIVER_NAME : XCVR_NEW_DRIVER_NAME);
+		memcpy(region->xcvr_name[i], devices[i], PATH_MAX);
+
+		if (g_jesd_iio_ctx)
+			memcpy(xcvrs[i].path, devices[i], PATH_MAX);
+		else if (snprintf(xcvrs[i].path, PATH_MAX, "%s/%s", basedir,
+				  devices[i]) >= PATH_MAX)
+			return -ENAMETOOLONG;
+
+		pthread_mutex_init(&xcvrs[i].lock, NULL);
+	}
+	region->num_xcvrs = MAX(num, 0);
+
+	return region->num_links + region->num_xcvrs;
+}
+
+static void monitord_read_link(unsigned idx, struct jesd_monitor_link *link)
+{
+	unsigned long long start = jesd_time_us();
+	char *path;
+
+	if (!links[idx]) {
+		path = monitord_path(region->link_name[idx]);
+		if (path)
+			links[idx] = jesd_device_open(path);
+		free(path);
+	}
+
+	memset(link, 0, sizeof(*link));
+
+	if (links[idx]) {
+		link->encoder = jesd_device_encoder(links[idx]);
+		link->err = MIN(jesd_device_read_status(links[idx], &link->status), 0);
+		link->lanes = jesd_device_read_all_laneinfo(links[idx], link->lane);
+	} else {
+		link->err = -ENODEV;
+	}
+
+	link->time_us = jesd_time_us();
+	link->read_us = link->time_us - start;
+}
+
+/* Only the copy is inside the seqlock, not the hardware read */
+static void monitord_publish(struct jesd_monitor_slot *slot,
+			     const struct jesd_monitor_link *link)
+{
+	unsigned seq = slot->seq;
+
+	__atomic_store_n(&slot->seq, seq + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+
+	memcpy(&slot->link, link, sizeof(*link));
+
+	__atomic_store_n(&slot->seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+/* The single poller of all links */
+static void *monitord_poll(void *arg)
+{
+	unsigned refresh_ms = region->refresh_ms, i;
+	struct jesd_monitor_link *link;
+	unsigned long long generation = 0;
+	struct timespec ts, now;
+
+	link = malloc(sizeof(*link));
+	if (!link)
+		return NULL;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	pthread_mutex_lock(&stop_lock);
+
+	while (!stop) {
+		pthread_mutex_unlock(&stop_lock);
+
+		generation++;
+		for (i = 0; i < region->num_links; i++) {
+			monitord_read_link(i, link);
+			link->generation = generation;
+			monitord_publish(&region->slot[i], link);
+		}
+		__atomic_store_n(&region->generation, generation, __ATOMIC_RELEASE);
+
+		/* Next poll one interval on, or from now if a whole one was missed */
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		if ((now.tv_sec - ts.tv_sec) * 1000000000LL + now.tv_nsec - ts.tv_nsec >=
+		    refresh_ms * 1000000LL)
+			ts = now;
+		ts.tv_sec += refresh_ms / 1000;
+		ts.tv_nsec += (refresh_ms % 1000) * 1000000L;
+		if (ts.tv_nsec >= 1000000000L) {
+			ts.tv_sec++;
+			ts.tv_nsec -= 1000000000L;
+		}
+
+		pthread_mutex_lock(&stop_lock);
+		while (!stop && pthread_cond_timedwait(&stop_cond, &stop_lock, &ts) != ETIMEDOUT)
+			;
+	}
+
+	pthread_mutex_unlock(&stop_lock);
+	free(link);
+
+	return NULL;
+}
+
+static int monitord_find_xcvr(const char *name)
+{
+	unsigned i;
+
+	for (i = 0; i < region->num_xcvrs; i++)
+		if (!strcmp(region->xcvr_name[i], name))
+			return i;
+
+	return -ENODEV;
+}
+
+static int monitord_respond(int fd, int err, const void *data, size_t len)
+{
+	char line[64];
+	int ret;
+
+	if (err)
+		snprintf(line, sizeof(line), "ERR %d\n", -err);
+	else
+		snprintf(line, sizeof(line), "OK %zu\n", len);
+
+	ret = jesd_monitor_send_all(fd, line, strlen(line));
+	if (!ret && !err)
+		ret = jesd_monitor_send_all(fd, data, len);
+
+	return ret;
+}
+
+static int monitord_attach(int fd)
+{
+	char cbuf[CMSG_SPACE(sizeof(int))] = { 0 }, line[64];
+	struct iovec iov = { .iov_base = line };
+	struct msghdr msg = {
+		.msg_iov = &iov,
+		.msg_iovlen = 1,
+		.msg_control = cbuf,
+		.msg_controllen = sizeof(cbuf),
+	};
+	struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+
+	iov.iov_len = snprintf(line, sizeof(line), "OK %zu\n", sizeof(*region));
+
+	cmsg->cmsg_level = SOL_SOCKET;
+	cmsg->cmsg_type = SCM_RIGHTS;
+	cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+	memcpy(CMSG_DATA(cmsg), &region_fd, sizeof(int));
+
+	return sendmsg(fd, &msg, MSG_NOSIGNAL) < 0 ? -errno : 0;
+}
+
+static int monitord_info(int fd, const char *name)
+{
+	char buf[1024];
+	int idx, ret;
+
+	idx = monitord_find_xcvr(name);
+	if (idx < 0)
+		return monitord_respond(fd, idx, NULL, 0);
+
+	/* Read only, does not wait for a running scan */
+	ret = jesd_read_attr(xcvrs[idx].path, "eyescan_info", buf, sizeof(buf));
+
+	return monitord_respond(fd, ret, buf, strlen(buf));
+}
+
+static int monitord_scan_locked(struct monitord_xcvr *x, unsigned lane,
+				unsigned prescale)
+{
+	struct jesd204b_xcvr_eyescan_info info = { 0 };
+	char temp[32];
+	void *data;
+	int ret;
+
+	snprintf(info.gt_interface_path, sizeof(info.gt_interface_path), "%s", x->path);
+	ret = read_eyescan_info(x->path, &info);
+	if (ret)
+		return ret;
+
+	if (lane >= info.num_lanes || prescale > MAX_PRESCALE)
+		return -EINVAL;
+
+	snprintf(temp, sizeof(temp), "%u", prescale);
+	ret = jesd_write_attr(x->path, JESD204B_PRESCALE, temp);
+	if (ret < 0)
+		return ret;
+
+	snprintf(temp, sizeof(temp), "%u", lane);
+	ret = jesd_write_attr(x->path, JESD204B_LANE_ENABLE, temp);
+	if (ret < 0)
+		return ret;
+
+	ret = get_eye_data(&info, JESD204B_EYE_DATA, x->path, prescale, NULL, &data);
+	if (ret)
+		return ret;
+
+	free(x->data);
+	x->data = data;
+	x->len = (size_t)info.es_hsize * info.es_vsize * (info.lpm ? 4 : 8);
+	x->lane = lane;
+	x->prescale = prescale;
+	x->end_us = jesd_time_us();
+
+	return 0;
+}
+
+static int monitord_scan(int fd, const char *name, unsigned lane, unsigned prescale)
+{
+	unsigned long long request_us = jesd_time_us();
+	struct monitord_xcvr *x;
+	int idx, ret = 0;
+
+	idx = monitord_find_xcvr(name);
+	if (idx < 0)
+		return monitord_respond(fd, idx, NULL, 0);
+
+	x = &xcvrs[idx];
+
+	pthread_mutex_lock(&x->lock);
+
+	if (!x->end_us || x->end_us < request_us || x->lane != lane ||
+	    x->prescale != prescale)
+		ret = monitord_scan_locked(x, lane, prescale);
+
+	ret = monitord_respond(fd, ret, x->data, x->len);
+
+	pthread_mutex_unlock(&x->lock);
+
+	return ret;
+}
+
+/* One thread per connection, requests are answered in order */
+static void *monitord_client(void *arg)
+{
+	char line[JESD_MONITOR_LINE], name[PATH_MAX];
+	struct monitord_conn *conn = arg;
+	unsigned lane, prescale;
+	int fd = conn->fd, ret = 0;
+
+	while (!ret && jesd_monitor_recv_line(fd, line, sizeof(line)) >= 0) {
+		if (!strcmp(line, "ATTACH"))
+			ret = monitord_attach(fd);
+		else if (sscanf(line, "INFO %4095s", name) == 1)
+			ret = monitord_info(fd, name);
+		else if (sscanf(line, "SCAN %4095s %u %u", name, &lane, &prescale) == 3)
+			ret = monitord_scan(fd, name, lane, prescale);
+		else
+			ret = monitord_respond(fd, -EINVAL, NULL, 0);
+	}
+
+	pthread_mutex_lock(&conns_lock);
+	close(fd);
+	conn->fd = -1;
+	conn->done = true;
+	pthread_mutex_unlock(&conns_lock);
+
+	return NULL;
+}
+
+/*
+ * Joins the client threads that finished. With @all, the others are woken by
+ * shutting down their sockets and joined too, a running scan is completed.
+ */
+static void monitord_reap(bool all)
+{
+	struct monitord_conn *conn;
+	bool done;
+	unsigned i;
+
+	for (i = 0; i < MONITORD_CLIENTS; i++) {
+		conn = &conns[i];
+		if (!conn->active)
+			continue;
+
+		pthread_mutex_lock(&conns_lock);
+		done = conn->done;
+		if (all && conn->fd >= 0)
+			shutdown(conn->fd, SHUT_RDWR);
+		pthread_mutex_unlock(&conns_lock);
+
+		if (done || all) {
+			pthread_join(conn->thread, NULL);
+			conn->active = false;
+		}
+	}
+}
+
+static void monitord_accept(int fd)
+{
+	struct monitord_conn *conn = NULL;
+	unsigned i;
+
+	monitord_reap(false);
+
+	for (i = 0; i < MONITORD_CLIENTS && !conn; i++)
+		if (!conns[i].active)
+			conn = &conns[i];
+
+	if (!conn) {
+		monitord_respond(fd, -EBUSY, NULL, 0);
+		close(fd);
+		return;
+	}
+
+	conn->fd = fd;
+	conn->done = false;
+	if (pthread_create(&conn->thread, NULL, monitord_client, conn)) {
+		close(fd);
+		return;
+	}
+	conn->active = true;
+}
+
+static int monitord_listen(const char *path)
+{
+	struct sockaddr_un addr = { .sun_family = AF_UNIX };
+	int fd, ret;
+
+	if (strlen(path) >= sizeof(addr.sun_path)) {
+		fprintf(stderr, "Socket path too long: %s\n", path);
+		return -ENAMETOOLONG;
+	}
+	strcpy(addr.sun_path, path);
+
+	/* A daemon that still accepts owns the board, only a stale socket goes */
+	fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (fd < 0)
+		return -errno;
+
+	if (!connect(fd, (struct sockaddr *)&addr, sizeof(addr)) || errno == EAGAIN) {
+		fprintf(stderr, "jesd_monitord already running on %s\n", path);
+		close(fd);
+		return -EADDRINUSE;
+	}
+
+	if (errno == ECONNREFUSED)
+		unlink(path);
+	close(fd);
+
+	fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (fd < 0)
+		return -errno;
+
+	if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) || listen(fd, 16)) {
+		ret = -errno;
+		fprintf(stderr, "Failed to listen on %s: %s\n", path, strerror(-ret));
+		close(fd);
+		return ret;
+	}
+
+	return fd;
+}
+
+static void usage(const char *name)
+{
+	fprintf(stderr, "%s [-p PATH | -u URI] [-s SOCKET] [-r REFRESH_MS]\n"
+		"  -p PATH   sysfs root (default /)\n"
+		"  -u URI    libiio context, or sim:[OPTIONS] for simulated transceivers\n"
+		"  -s PATH   Unix socket (default %s)\n"
+		"  -r MS     link refresh interval (default %d)\n",
+		name, JESD_MONITOR_SOCKET, MONITORD_REFRESH_MS);
+}
+
+int main(int argc, char *argv[])
+{
+	const char *socket_path = JESD_MONITOR_SOCKET;
+	unsigned refresh_ms = MONITORD_REFRESH_MS;
+	struct signalfd_siginfo si;
+	struct pollfd pfd[2];
+	pthread_condattr_t attr;
+	pthread_t thread;
+	char *path = "", *uri = NULL;
+	int c, i, lfd = -1, sfd = -1, fd, ret = 1;
+	sigset_t mask;
+
+	while ((c = getopt(argc, argv, "p:u:s:r:h")) != -1)
+		switch (c) {
+		case 'p':
+			path = optarg;
+			break;
+		case 'u':
+			uri = optarg;
+			break;
+		case 's':
+			socket_path = optarg;
+			break;
+		case 'r':
+			refresh_ms = strtoul(optarg, NULL, 0);
+			if (!refresh_ms) {
+				fprintf(stderr, "Refresh interval must be at least 1 ms\n");
+				return 1;
+			}
+			break;
+		default:
+			usage(argv[0]);
+			return c != 'h';
+		}
+
+	if (uri && !strncmp(uri, JESD_EYE_SIM_PREFIX, strlen(JESD_EYE_SIM_PREFIX))) {
+		if (jesd_eye_sim_create(uri + strlen(JESD_EYE_SIM_PREFIX)))
+			return 1;
+		strcpy(basedir, JESD_EYE_SIM_BASEDIR);
+	} else if (uri) {
+		g_jesd_iio_ctx = jesd_iio_create_context(uri);
+		if (!g_jesd_iio_ctx) {
+			fprintf(stderr, "Failed to create IIO context\n");
+			return 1;
+		}
+		strcpy(basedir, "iio:context");
+	} else {
+		snprintf(basedir, sizeof(basedir), "%s/sys/bus/platform/drivers", path);
+	}
+
+	if (monitord_region_create()) {
+		perror("memfd");
+		goto out;
+	}
+	region->refresh_ms = refresh_ms;
+
+	if (monitord_find_devices() <= 0) {
+		fprintf(stderr, "Failed to find JESD devices\n");
+		goto out;
+	}
+
+	sigemptyset(&mask);
+	sigaddset(&mask, SIGINT);
+	sigaddset(&mask, SIGTERM);
+	pthread_sigmask(SIG_BLOCK, &mask, NULL);
+	sfd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+	if (sfd < 0) {
+		perror("signalfd");
+		goto out;
+	}
+
+	lfd = monitord_listen(socket_path);
+	if (lfd < 0)
+		goto out;
+
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	pthread_cond_init(&stop_cond, &attr);
+	pthread_condattr_destroy(&attr);
+
+	if (pthread_create(&thread, NULL, monitord_poll, NULL)) {
+		fprintf(stderr, "Failed to start the poller\n");
+		goto out_socket;
+	}
+
+	fprintf(stderr, "Monitoring %u JESD204 links and %u transceivers on %s\n",
+		region->num_links, region->num_xcvrs, socket_path);
+
+	pfd[0] = (struct pollfd) { .fd = lfd, .events = POLLIN };
+	pfd[1] = (struct pollfd) { .fd = sfd, .events = POLLIN };
+
+	while (true) {
+		if (poll(pfd, 2, -1) < 0) {
+			if (errno == EINTR)
+				continue;
+			perror("poll");
+			break;
+		}
+
+		if (pfd[1].revents & POLLIN && read(sfd, &si, sizeof(si)) == sizeof(si)) {
+			ret = 0;
+			break;
+		}
+
+		if (!(pfd[0].revents & POLLIN))
+			continue;
+
+		while ((fd = accept4(lfd, NULL, NULL, SOCK_CLOEXEC)) >= 0)
+			monitord_accept(fd);
+	}
+
+	/* Clients may be scanning, the transceivers go away below */
+	monitord_reap(true);
+
+	pthread_mutex_lock(&stop_lock);
+	stop = true;
+	pthread_cond_signal(&stop_cond);
+	pthread_mutex_unlock(&stop_lock);
+	pthread_join(thread, NULL);
+
+out_socket:
+	unlink(socket_path);
+out:
+	if (lfd >= 0)
+		close(lfd);
+	if (sfd >= 0)
+		close(sfd);
+
+	for (i = 0; i < MAX_DEVICES; i++)
+		jesd_device_close(links[i]);
+
+	if (g_jesd_iio_ctx)
+		jesd_iio_destroy_context(g_jesd_iio_ctx);
+	jesd_eye_sim_destroy();
+
+	return ret;
+}
@@ -12,19 +12,30 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include <curses.h>
 #include <signal.h>
 #include <dirent.h>
 #include <unistd.h>
 #include <ctype.h>
 #include <string.h>
+#include <stdarg.h>
 #include <errno.h>
 #include <sys/stat.h>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <sys/timerfd.h>
+#include <sys/signalfd.h>
 #include <limits.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/eventfd.h>
 
 #include "jesd_common.h"
+#include "jesd_monitor.h"
 
 #define COL_SPACEING 3
+#define REFRESH_MS	250	/* default status refresh interval */
 
 enum color_pairs {
 	C_NORM = 1,
@@ -35,9 +46,10 @@ enum color_pairs {
 };
 
 static int encoder = 0;
-struct jesd204b_laneinfo lane_info[MAX_LANES];
+static int dev_num, simple, debug, dashboard, json, events;
 char basedir[PATH_MAX];
 char jesd_devices[MAX_DEVICES][PATH_MAX];
+struct jesd_device *jesd_handles[MAX_DEVICES];
 WINDOW *main_win, *stat_win, *dev_win, *lane_win;
 
 static const char *link_status_labels[] = {
@@ -76,6 +88,8 @@ static const char *link_status_labels_64b66b[] = {
 static const char *lane_status_labels[] = {
 	"Lane#",
 	"Errors",
+	"Errors/s",
+	"Error history",
 	"Latency (Multiframes/Octets)",
 	"CGS State",
 	"Initial Frame Sync",
@@ -86,6 +100,8 @@ static const char *lane_status_labels[] = {
 static const char *lane_status_labels_64b66b[] = {
 	"Lane#",
 	"Errors",
+	"Errors/s",
+	"Error history",
 	"Latency (Octets)",
 	"Extended multiblock alignment",
 	NULL
@@ -174,266 +190,1506 @@ int jesd_print_win_exp(WINDOW *win, int y, int x, const char *text,
 	return jesd_print_win(win, y, x, c, text, clear);
 }
 
-int update_lane_status(WINDOW *win, int x, struct jesd204b_laneinfo *info,
-		       unsigned lanes)
+/*
+ * This is a workaround to redraw the right line in the windows boxes/borders.
+ * This happens because `jesd_clear_line_from()` will clear the current line
+ * till the EOL which removes part of the box vertical line.
+ */
+static void jesd_redo_r_box(WINDOW *win, const int simple)
+{
+	int x, y;
+
+	if (simple)
+		return;
+
+	getmaxyx(win, y, x);
+	wmove(win, 1, x - 1);
+	/* redraw vertical line */
+	wvline(win, 0, y - 2);
+}
+
+/*
+ * Text and color last drawn per value cell, so a refresh only writes the cells
+ * that changed. Columns are lanes (one for the status window), rows follow the
+ * labels.
+ */
+#define CELL_ROWS	16
+
+struct jesd_cell {
+	char text[MAX_SYSFS_STRING_SIZE];
+	enum color_pairs c;
+};
+
+struct jesd_cells {
+	bool valid;
+	unsigned cols;
+	int x[MAX_LANES];
+	struct jesd_cell cell[CELL_ROWS][MAX_LANES];
+};
+
+static struct jesd_cells stat_cells, lane_cells;
+
+static int __attribute__((format(printf, 3, 4)))
+jesd_cell_printf(struct jesd_cell *cell, enum color_pairs c, const char *fmt, ...)
+{
+	va_list args;
+
+	va_start(args, fmt);
+	vsnprintf(cell->text, sizeof(cell->text), fmt, args);
+	va_end(args);
+	cell->c = c;
+
+	return strlen(cell->text);
+}
+
+static enum color_pairs jesd_exp_color(const char *text, const char *expected,
+				       unsigned invert)
+{
+	if (strcmp(text, expected))
+		return invert ? C_GOOD : C_ERR;
+
+	return invert ? C_ERR : C_GOOD;
+}
+
+/*
+ * Draws @next over what @prev left in @win, cell row 0 on line @top. Columns
+ * left of the first one that moved are compared cell by cell, a shorter value
+ * is padded with blanks over the old one. From the first moved column on the
+ * lines are cleared and redrawn. Returns true if the right border needs to be
+ * redrawn.
+ */
+static bool jesd_draw_cells(WINDOW *win, struct jesd_cells *prev,
+			    const struct jesd_cells *next, int top, unsigned rows)
+{
+	unsigned row, col, moved = 0, cols = MAX(prev->cols, next->cols);
+	const struct jesd_cell *n;
+	struct jesd_cell *p;
+	int x, len, old;
+
+	if (prev->valid)
+		while (moved < prev->cols && moved < next->cols &&
+		       prev->x[moved] == next->x[moved])
+			moved++;
+
+	for (row = 0; row < rows; row++) {
+		if (moved < cols) {
+			x = moved < next->cols ? next->x[moved] : prev->x[moved];
+			if (prev->valid && moved < prev->cols)
+				x = MIN(x, prev->x[moved]);
+			jesd_clear_line_from(win, top + row, x);
+		}
+
+		for (col = 0; col < next->cols; col++) {
+			n = &next->cell[row][col];
+			p = &prev->cell[row][col];
+
+			if (col < moved && n->c == p->c && !strcmp(n->text, p->text))
+				continue;
+
+			wcolor_set(win, n->c, NULL);
+			mvwprintw(win, top + row, next->x[col], "%s", n->text);
+
+			len = strlen(n->text);
+			old = col < moved ? (int)strlen(p->text) : 0;
+			if (old > len)
+				wprintw(win, "%*s", old - len, "");
+		}
+	}
+
+	wcolor_set(win, C_NORM, NULL);
+	*prev = *next;
+	prev->valid = true;
+
+	return moved < cols;
+}
+
+/*
+ * Error history per device and lane: a ring of the last HISTORY_SAMPLES reads.
+ * The errors since the previous read are kept per sample and summed up as the
+ * ring advances, so the rate over the window costs nothing to update.
+ */
+#define HISTORY_SAMPLES	60	/* 15 s at the default refresh interval */
+#define SPARK_WIDTH	6	/* HISTORY_SAMPLES / SPARK_WIDTH samples per char */
+
+struct jesd_lane_sample {
+	unsigned long long time_us;
+	unsigned errors;	/* lane_errors as read */
+	unsigned delta;		/* errors since the previous sample */
+	unsigned latency;	/* octets */
+};
+
+struct jesd_lane_history {
+	struct jesd_lane_sample sample[HISTORY_SAMPLES];
+	unsigned head;		/* next sample to write */
+	unsigned count;
+	unsigned long long window_errors;	/* sum of delta of all samples */
+};
+
+static struct jesd_lane_history history[MAX_DEVICES][MAX_LANES];
+
+#define history_at(h, age) \
+	(&(h)->sample[((h)->head + HISTORY_SAMPLES - 1 - (age)) % HISTORY_SAMPLES])
+
+static void jesd_history_add(struct jesd_lane_history *h,
+			     unsigned long long time_us,
+			     const struct jesd204b_laneinfo *lane)
+{
+	struct jesd_lane_sample *sample = &h->sample[h->head], *prev;
+	unsigned delta = 0;
+
+	if (h->count) {
+		prev = history_at(h, 0);
+		/* The same read, e.g. a dashboard snapshot drawn twice */
+		if (prev->time_us == time_us)
+			return;
+		/* A counter that went backwards was reset */
+		if (lane->lane_errors >= prev->errors)
+			delta = lane->lane_errors - prev->errors;
+		else
+			delta = lane->lane_errors;
+	}
+
+	if (h->count == HISTORY_SAMPLES)
+		h->window_errors -= sample->delta;
+	else
+		h->count++;
+
+	sample->time_us = time_us;
+	sample->errors = lane->lane_errors;
+	sample->delta = delta;
+	sample->latency = lane->k * lane->f * lane->lane_latency_multiframes +
+			  lane->lane_latency_octets;
+	h->window_errors += delta;
+	h->head = (h->head + 1) % HISTORY_SAMPLES;
+}
+
+/* Errors per second over the window, the oldest delta lies before it */
+static double jesd_history_rate(const struct jesd_lane_history *h)
+{
+	const struct jesd_lane_sample *newest, *oldest;
+
+	if (h->count < 2)
+		return 0;
+
+	newest = history_at(h, 0);
+	oldest = history_at(h, h->count - 1);
+
+	return (h->window_errors - oldest->delta) * 1e6 /
+	       (newest->time_us - oldest->time_us);
+}
+
+/*
+ * One char per HISTORY_SAMPLES / SPARK_WIDTH samples, newest on the right, on
+ * a log2 scale of the errors so a single error still shows: '_' none, '.' 1,
+ * ':' 2-3, '-' 4-7 ... '@' 256 and more. Blank where there is no history yet.
+ */
+static void jesd_history_spark(const struct jesd_lane_history *h,
+			       char spark[SPARK_WIDTH + 1])
 {
-	struct jesd204b_laneinfo *lane;
+	static const char levels[] = "_.:-=+*#%@";
+	const unsigned per_char = HISTORY_SAMPLES / SPARK_WIDTH;
+	unsigned long long errors;
+	unsigned i, age, level;
+
+	for (i = 0; i < SPARK_WIDTH; i++) {
+		age = (SPARK_WIDTH - 1 - i) * per_char;
+		if (age >= h->count) {
+			spark[i] = ' ';
+			continue;
+		}
+
+		for (errors = 0; age < h->count && age < (SPARK_WIDTH - i) * per_char; age++)
+			errors += history_at(h, age)->delta;
+
+		for (level = 0; errors && level < sizeof(levels) - 2; errors >>= 1)
+			level++;
+		spark[i] = levels[level];
+	}
+
+	spark[SPARK_WIDTH] = '\0';
+}
+
+/* "0.017", "2.50", "1234" */
+#define jesd_rate_fmt(rate)	((rate) < 10 ? "%.2f" : "%.0f")
+
+int update_lane_status(WINDOW *win, int x, const struct jesd204b_laneinfo *info,
+		       const struct jesd_lane_history *hist, unsigned lanes)
+{
+	char spark[SPARK_WIDTH + 1];
+	double rate;
+	static struct jesd_cells next;
+	const struct jesd204b_laneinfo *lane;
 	enum color_pairs c = C_ERR;
 	int octets_per_multifame, latency_min, latency, i, y, pos = 0;
-	struct jesd204b_laneinfo *tmp = info;
+	const struct jesd204b_laneinfo *tmp = info;
 	bool not_available = false;
 
-	if (!lanes)
-		return 0;
+	if (!lanes)
+		return 0;
+
+	for (i = 0, latency_min = INT_MAX; i < lanes; i++) {
+		lane = tmp++;
+		octets_per_multifame = lane->k * lane->f;
+
+		latency_min = MIN(latency_min, octets_per_multifame *
+				  lane->lane_latency_multiframes +
+				  lane->lane_latency_octets);
+	}
+
+	next.cols = lanes;
+
+	for (i = 0; i < lanes; i++) {
+		y = 0;
+
+		lane = info++;
+
+		if (encoder == JESD204_ENCODER_64B66B) {
+			if (lane->lane_latency_octets == 0 && lane->lane_latency_min == 0 && lane->lane_latency_max == 0) {
+				c = C_GOOD;
+				not_available = true;
+			} else if (lane->lane_latency_octets < lane->lane_latency_min || lane->lane_latency_octets > lane->lane_latency_max) {
+				c = C_ERR;
+			} else {
+				c = C_GOOD;
+			}
+		} else {
+			octets_per_multifame = lane->k * lane->f;
+
+			latency = octets_per_multifame * lane->lane_latency_multiframes +
+				  lane->lane_latency_octets;
+
+			if ((latency - latency_min) >= octets_per_multifame)
+				c = C_ERR;
+			else if ((latency - latency_min) > (octets_per_multifame / 2))
+				c = C_CRIT;
+			else
+				c = C_GOOD;
+		}
+
+		next.x[i] = x;
+
+#define lane_cell(col)	(&next.cell[y++][col])
+
+		pos = jesd_maxx(pos, jesd_cell_printf(lane_cell(i), C_NORM, "%d", i));
+		pos = jesd_maxx(pos, jesd_cell_printf(lane_cell(i),
+						      lane->lane_errors ? C_ERR : C_GOOD,
+						      "%d", lane->lane_errors));
+
+		rate = jesd_history_rate(&hist[i]);
+		jesd_history_spark(&hist[i], spark);
+		pos = jesd_maxx(pos, jesd_cell_printf(lane_cell(i),
+						      hist[i].window_errors ? C_ERR : C_GOOD,
+						      jesd_rate_fmt(rate), rate));
+		pos = jesd_maxx(pos, jesd_cell_printf(lane_cell(i),
+						      hist[i].window_errors ? C_ERR : C_GOOD,
+						      "%s", spark));
+
+		if (encoder == JESD204_ENCODER_64B66B) {
+			if (not_available)
+				pos = jesd_maxx(pos, jesd_cell_printf(lane_cell(i), c, "N/A"));
+			else
+				pos = jesd_maxx(pos, jesd_cell_printf(lane_cell(i), c, "%u",
+								      lane->lane_latency_octets));
+
+			pos = jesd_maxx(pos, jesd_cell_printf(lane_cell(i),
+					jesd_exp_color(lane->ext_multiblock_align_state, "EMB_LOCK", 0),
+					"%s", lane->ext_multiblock_align_state));
+			x += pos + COL_SPACEING;
+			continue;
+		}
+
+		pos = jesd_maxx(pos, jesd_cell_printf(lane_cell(i), c, "%d/%d",
+						      lane->lane_latency_multiframes,
+						      lane->lane_latency_octets));
+		pos = jesd_maxx(pos, jesd_cell_printf(lane_cell(i),
+				jesd_exp_color(lane->cgs_state, "DATA", 0),
+				"%s", lane->cgs_state));
+		pos = jesd_maxx(pos, jesd_cell_printf(lane_cell(i),
+				jesd_exp_color(lane->init_frame_sync, "Yes", 0),
+				"%s", lane->init_frame_sync));
+		pos = jesd_maxx(pos, jesd_cell_printf(lane_cell(i),
+				jesd_exp_color(lane->init_lane_align_seq, "Yes", 0),
+				"%s", lane->init_lane_align_seq));
+#undef lane_cell
+
+		x += pos + COL_SPACEING;
+	}
+
+	if (jesd_draw_cells(win, &lane_cells, &next, 1, y))
+		jesd_redo_r_box(win, simple);
+
+	return x;
+}
+
+/* C_ERR if @value is off @reference by more than CLOCK_ACCURACY */
+static enum color_pairs jesd_clock_color(const char *value, const char *reference)
+{
+	float val, ref;
+
+	if (sscanf(value, "%f", &val) != 1)
+		val = 0.0f;
+	if (sscanf(reference, "%f", &ref) != 1)
+		ref = 0.0f;
+
+	if (val > (ref * (1 + PPM(CLOCK_ACCURACY))) ||
+	    val < (ref * (1 - PPM(CLOCK_ACCURACY))))
+		return C_ERR;
+
+	return C_GOOD;
+}
+
+int jesd_update_status(WINDOW *win, int x,
+		       const struct jesd204b_jesd204_status *info)
+{
+	static struct jesd_cells next = { .cols = 1 };
+	enum color_pairs c_measured_link_clock, c_lane_rate_div,
+	     c_measured_device_clock, c_reported_device_clock;
+	int y = 0, pos = 0;
+
+	c_measured_link_clock = jesd_clock_color(info->measured_link_clock,
+						 info->reported_link_clock);
+	c_lane_rate_div = jesd_clock_color(info->reported_link_clock,
+					   info->lane_rate_div);
+
+	if (info->measured_device_clock[0] != 'N') {
+		c_measured_device_clock = jesd_clock_color(info->measured_device_clock,
+							   info->reported_device_clock);
+		c_reported_device_clock = jesd_clock_color(info->reported_device_clock,
+							   info->desired_device_clock);
+	} else {
+		c_measured_device_clock = C_NORM;
+		c_reported_device_clock = C_NORM;
+	}
+
+	next.x[0] = x;
+
+#define stat_cell(c, text)	jesd_cell_printf(&next.cell[y++][0], c, "%s", text)
+
+	pos = jesd_maxx(pos, stat_cell(jesd_exp_color(info->link_state, "enabled", 0),
+				       info->link_state));
+	pos = jesd_maxx(pos, stat_cell(jesd_exp_color(info->link_status, "DATA", 0),
+				       info->link_status));
+	pos = jesd_maxx(pos, stat_cell(c_measured_link_clock, info->measured_link_clock));
+	pos = jesd_maxx(pos, stat_cell(C_NORM, info->reported_link_clock));
+	pos = jesd_maxx(pos, stat_cell(c_measured_device_clock, info->measured_device_clock));
+	pos = jesd_maxx(pos, stat_cell(c_reported_device_clock, info->reported_device_clock));
+	pos = jesd_maxx(pos, stat_cell(C_NORM, info->desired_device_clock));
+	pos = jesd_maxx(pos, stat_cell(C_NORM, info->lane_rate));
+	pos = jesd_maxx(pos, stat_cell(c_lane_rate_div, info->lane_rate_div));
+	pos = jesd_maxx(pos, stat_cell(C_NORM, info->lmfc_rate));
+	pos = jesd_maxx(pos, stat_cell(jesd_exp_color(info->sysref_captured, "No", 1),
+				       info->sysref_captured));
+	pos = jesd_maxx(pos, stat_cell(jesd_exp_color(info->sysref_alignment_error, "Yes", 1),
+				       info->sysref_alignment_error));
+	if (encoder == JESD204_ENCODER_8B10B)
+		pos = jesd_maxx(pos, stat_cell(jesd_exp_color(info->sync_state, "deasserted", 0),
+					       info->sync_state));
+#undef stat_cell
+
+	if (jesd_draw_cells(win, &stat_cells, &next, 1, y))
+		jesd_redo_r_box(win, simple);
+
+	return pos + COL_SPACEING;
+}
+
+/* Returns the value column of @labels, draws them if @draw is set */
+int jesd_setup_subwin(WINDOW *win, const char *name, const char **labels,
+		      bool draw)
+{
+	int i = 0, pos = 0;
+
+	if (draw)
+		mvwprintw(win, 0, 1, "%s", name);
+
+	while (labels[i]) {
+		if (draw)
+			pos = jesd_maxx(pos, jesd_print_win(win, i + 1, 1, C_NORM,
+							    labels[i], false));
+		else
+			pos = jesd_maxx(pos, strlen(labels[i]));
+		i++;
+	}
+
+	return pos + COL_SPACEING;
+}
+
+static void jesd_set_current_device(const int dev_idx)
+{
+	wcolor_set(dev_win, C_GOOD, NULL);
+	mvwprintw(dev_win, 2 + dev_idx, strlen(jesd_devices[dev_idx]) + 8, "[*]");
+	wcolor_set(dev_win, C_NORM, NULL);
+	wrefresh(dev_win);
+}
+
+/* Handles are opened on first use and kept for the lifetime of the tool */
+static struct jesd_device *jesd_get_device(const int dev_idx)
+{
+	char *path;
+
+	if (jesd_handles[dev_idx])
+		return jesd_handles[dev_idx];
+
+	if (g_jesd_iio_ctx) {
+		jesd_handles[dev_idx] = jesd_device_open(jesd_devices[dev_idx]);
+	} else {
+		path = get_full_device_path(basedir, jesd_devices[dev_idx]);
+		if (!path)
+			return NULL;
+		jesd_handles[dev_idx] = jesd_device_open(path);
+		free(path);
+	}
+
+	return jesd_handles[dev_idx];
+}
+
+static void jesd_move_device(const int old_idx, const int new_idx,
+			     const int simple)
+{
+	if (old_idx == new_idx)
+		return;
+	/* clear the old selected dev, the dashboard columns stay */
+	mvwprintw(dev_win, 2 + old_idx, strlen(jesd_devices[old_idx]) + 8, "   ");
+	jesd_set_current_device(new_idx);
+	/* Clear the lane window since the next device might not have lane info */
+	jesd_clear_win(lane_win, true);
+	wrefresh(lane_win);
+	jesd_clear_win(stat_win, simple);
+	stat_cells.valid = lane_cells.valid = false;
+}
+
+/* One read of the status and lanes of a device */
+struct jesd_snapshot {
+	int valid;
+	int err;
+	int encoder;
+	unsigned lanes;
+	unsigned long long time_us;	/* CLOCK_MONOTONIC, start of the read */
+	unsigned long long read_us;
+	struct jesd204b_jesd204_status status;
+	struct jesd204b_laneinfo lane[MAX_LANES];
+};
+
+static void jesd_read_snapshot(const int dev_idx, struct jesd_snapshot *snap)
+{
+	unsigned long long start = jesd_time_us();
+	struct jesd_device *jdev = jesd_get_device(dev_idx);
+
+	memset(snap, 0, sizeof(*snap));
+	snap->valid = 1;
+	snap->time_us = start;
+
+	if (!jdev) {
+		snap->err = -ENODEV;
+		return;
+	}
+
+	/* Backend handles learn the encoder with the first good read */
+	snap->err = MIN(jesd_device_read_status(jdev, &snap->status), 0);
+	snap->encoder = jesd_device_encoder(jdev);
+	snap->lanes = jesd_device_read_all_laneinfo(jdev, snap->lane);
+	snap->read_us = jesd_time_us() - start;
+}
+
+/* Called from the main thread only, the workers just take snapshots */
+static void jesd_history_update(const int dev_idx, const struct jesd_snapshot *snap)
+{
+	unsigned i;
+
+	if (!snap->valid || snap->err)
+		return;
+
+	for (i = 0; i < snap->lanes; i++)
+		jesd_history_add(&history[dev_idx][i], snap->time_us, &snap->lane[i]);
+}
+
+/*
+ * Dashboard mode reads all devices at once, one worker per device, so a round
+ * takes as long as the slowest device. Each finished device is signaled on an
+ * eventfd the main loop polls, a new round is only started once the last one
+ * completed.
+ */
+static struct jesd_pool {
+	pthread_t thread[MAX_DEVICES];
+	unsigned workers;
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	int next;		/* next device to read in this round */
+	int pending;		/* devices not read yet in this round */
+	bool stop;
+	int efd;
+	struct jesd_snapshot snap[MAX_DEVICES];	/* latest per device */
+} pool = {
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+	.cond = PTHREAD_COND_INITIALIZER,
+	.next = MAX_DEVICES,
+	.efd = -1,
+};
+
+static void *jesd_pool_worker(void *arg)
+{
+	struct jesd_snapshot *snap;
+	uint64_t one = 1;
+	int idx;
+
+	snap = malloc(sizeof(*snap));
+	if (!snap)
+		return NULL;
+
+	pthread_mutex_lock(&pool.lock);
+
+	while (true) {
+		while (!pool.stop && pool.next >= dev_num)
+			pthread_cond_wait(&pool.cond, &pool.lock);
+		if (pool.stop)
+			break;
+
+		idx = pool.next++;
+		pthread_mutex_unlock(&pool.lock);
+
+		jesd_read_snapshot(idx, snap);
+
+		pthread_mutex_lock(&pool.lock);
+		pool.snap[idx] = *snap;
+		pool.pending--;
+
+		if (write(pool.efd, &one, sizeof(one)) < 0)
+			break;
+	}
+
+	pthread_mutex_unlock(&pool.lock);
+	free(snap);
+
+	return NULL;
+}
+
+static int jesd_pool_start(unsigned workers)
+{
+	sigset_t mask, old;
+	unsigned i;
+	int ret;
+
+	pool.efd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (pool.efd < 0)
+		return -errno;
+
+	/*
+	 * Workers inherit the signal mask. Block everything so SIGWINCH,
+	 * SIGINT and SIGTERM reach the main loop's signalfd, not a worker.
+	 */
+	sigfillset(&mask);
+	pthread_sigmask(SIG_SETMASK, &mask, &old);
+
+	for (i = 0, ret = 0; i < workers && !ret; i++) {
+		ret = pthread_create(&pool.thread[i], NULL, jesd_pool_worker, NULL);
+		if (!ret)
+			pool.workers++;
+	}
+
+	pthread_sigmask(SIG_SETMASK, &old, NULL);
+
+	return -ret;
+}
+
+static int jesd_pool_round(void)
+{
+	int ret = 0;
+
+	pthread_mutex_lock(&pool.lock);
+
+	if (pool.pending) {
+		ret = -EBUSY;
+	} else {
+		pool.next = 0;
+		pool.pending = dev_num;
+		pthread_cond_broadcast(&pool.cond);
+	}
+
+	pthread_mutex_unlock(&pool.lock);
+
+	return ret;
+}
+
+static void jesd_pool_get(const int dev_idx, struct jesd_snapshot *snap)
+{
+	pthread_mutex_lock(&pool.lock);
+	*snap = pool.snap[dev_idx];
+	pthread_mutex_unlock(&pool.lock);
+}
+
+static void jesd_pool_stop(void)
+{
+	unsigned i;
+
+	pthread_mutex_lock(&pool.lock);
+	pool.stop = true;
+	pthread_cond_broadcast(&pool.cond);
+	pthread_mutex_unlock(&pool.lock);
+
+	for (i = 0; i < pool.workers; i++)
+		pthread_join(pool.thread[i], NULL);
+
+	if (pool.efd >= 0)
+		close(pool.efd);
+}
+
+static const char *dashboard_labels[] = {
+	"Link",
+	"Status",
+	"Lanes",
+	"Synced",
+	"Errors",
+	"Errors/s",
+	"Link Clock (MHz)",
+	"Lane rate (MHz)",
+	"SYSREF",
+	"Read (ms)",
+	NULL
+};
+
+static struct jesd_cells dash_cells;
+
+/* One summary row per link in the device window, header in row 0 */
+static void jesd_update_dashboard(const struct jesd_snapshot *snaps)
+{
+	static struct jesd_cells next;
+	const struct jesd_snapshot *snap;
+	const struct jesd204b_laneinfo *lane;
+	unsigned errors, synced, i;
+	int row, col, x = 0, pos;
+	double rate;
+
+	for (row = 0; row < dev_num; row++)
+		x = jesd_maxx(x, strlen(jesd_devices[row]));
+	x += 12 + COL_SPACEING;
+
+	next.cols = ARRAY_SIZE(dashboard_labels) - 1;
+
+	for (col = 0; col < next.cols; col++)
+		jesd_cell_printf(&next.cell[0][col], C_NORM, "%s", dashboard_labels[col]);
+
+	for (row = 1; row <= dev_num; row++) {
+		struct jesd_cell *cell = next.cell[row];
+
+		snap = &snaps[row - 1];
+
+		for (col = 0; col < next.cols; col++)
+			jesd_cell_printf(&cell[col], C_NORM, "%s", "");
+
+		if (!snap->valid) {
+			jesd_cell_printf(&cell[0], C_NORM, "...");
+			continue;
+		}
+
+		if (snap->err) {
+			jesd_cell_printf(&cell[0], C_ERR, "%s", strerror(-snap->err));
+			continue;
+		}
+
+		for (i = 0, errors = 0, synced = 0, rate = 0; i < snap->lanes; i++) {
+			lane = &snap->lane[i];
+			errors += lane->lane_errors;
+			rate += jesd_history_rate(&history[row - 1][i]);
+
+			if (snap->encoder == JESD204_ENCODER_64B66B)
+				synced += !strcmp(lane->ext_multiblock_align_state,
+						  "EMB_LOCK");
+			else
+				synced += !strcmp(lane->cgs_state, "DATA") &&
+					  !strcmp(lane->init_frame_sync, "Yes") &&
+					  !strcmp(lane->init_lane_align_seq, "Yes");
+		}
+
+		jesd_cell_printf(&cell[0], jesd_exp_color(snap->status.link_state,
+							  "enabled", 0),
+				 "%s", snap->status.link_state);
+		jesd_cell_printf(&cell[1], jesd_exp_color(snap->status.link_status,
+							  "DATA", 0),
+				 "%s", snap->status.link_status);
+		jesd_cell_printf(&cell[2], C_NORM, "%u", snap->lanes);
+		jesd_cell_printf(&cell[3], synced == snap->lanes ? C_GOOD : C_ERR,
+				 "%u/%u", synced, snap->lanes);
+		jesd_cell_printf(&cell[4], errors ? C_ERR : C_GOOD, "%u", errors);
+		jesd_cell_printf(&cell[5], rate > 0 ? C_ERR : C_GOOD,
+				 jesd_rate_fmt(rate), rate);
+		jesd_cell_printf(&cell[6],
+				 jesd_clock_color(snap->status.measured_link_clock,
+						  snap->status.reported_link_clock),
+				 "%s", snap->status.measured_link_clock);
+		jesd_cell_printf(&cell[7], C_NORM, "%s", snap->status.lane_rate);
+		jesd_cell_printf(&cell[8], jesd_exp_color(snap->status.sysref_captured,
+							  "No", 1),
+				 "%s", snap->status.sysref_captured);
+		/* Whole ms, sub ms jitter would redraw the cell every time */
+		jesd_cell_printf(&cell[9], C_NORM, "%llu", (snap->read_us + 500) / 1000);
+	}
+
+	for (col = 0; col < next.cols; col++) {
+		next.x[col] = x;
+		for (row = 0, pos = 0; row <= dev_num; row++)
+			pos = jesd_maxx(pos, strlen(next.cell[row][col].text));
+		x += pos + COL_SPACEING;
+	}
+
+	if (jesd_draw_cells(dev_win, &dash_cells, &next, 1, dev_num + 1))
+		jesd_redo_r_box(dev_win, simple);
+}
+
+/*
+ * NDJSON output (-j): one object per device and refresh, collected in a static
+ * buffer and written with a single write() per refresh. Nothing is allocated
+ * and numbers are formatted by hand, sysfs values that already are decimal
+ * numbers are copied as they are.
+ */
+#define JSON_BUF_SIZE	(64 * 1024)
+
+static char json_buf[JSON_BUF_SIZE];
+static size_t json_len;
+static int json_err;
+
+static int jesd_json_flush(void)
+{
+	size_t done = 0;
+	ssize_t ret;
+
+	while (done < json_len && !json_err) {
+		ret = write(STDOUT_FILENO, json_buf + done, json_len - done);
+		if (ret < 0 && errno == EINTR)
+			continue;
+		if (ret < 0)
+			json_err = -errno;
+		else
+			done += ret;
+	}
+
+	json_len = 0;
+
+	return json_err;
+}
+
+static void jesd_json_raw(const char *str, size_t len)
+{
+	size_t n;
+
+	while (len) {
+		if (json_len == sizeof(json_buf) && jesd_json_flush())
+			return;
+
+		n = MIN(len, sizeof(json_buf) - json_len);
+		memcpy(json_buf + json_len, str, n);
+		json_len += n;
+		str += n;
+		len -= n;
+	}
+}
+
+#define jesd_json_lit(str)	jesd_json_raw(str, sizeof(str) - 1)
+
+static void jesd_json_uint(unsigned long long val)
+{
+	char digits[20], *p = digits + sizeof(digits);
+
+	do {
+		*--p = '0' + val % 10;
+		val /= 10;
+	} while (val);
+
+	jesd_json_raw(p, digits + sizeof(digits) - p);
+}
+
+static void jesd_json_str(const char *str)
+{
+	static const char hex[] = "0123456789abcdef";
+	const char *start;
+	char esc[6];
+
+	jesd_json_lit("\"");
+
+	while (*str) {
+		for (start = str; (unsigned char)*str >= 0x20 && *str != '"' &&
+		     *str != '\\'; str++)
+			;
+		jesd_json_raw(start, str - start);
+		if (!*str)
+			break;
+
+		if (*str == '"' || *str == '\\') {
+			esc[0] = '\\';
+			esc[1] = *str;
+			jesd_json_raw(esc, 2);
+		} else {
+			memcpy(esc, "\\u00", 4);
+			esc[4] = hex[(*str >> 4) & 0xf];
+			esc[5] = hex[*str & 0xf];
+			jesd_json_raw(esc, 6);
+		}
+		str++;
+	}
+
+	jesd_json_lit("\"");
+}
+
+/* Plain decimal like "245.761", also a valid JSON number */
+static bool jesd_is_decimal(const char *str)
+{
+	if (*str == '-')
+		str++;
+	if (!isdigit((unsigned char)*str))
+		return false;
+	while (isdigit((unsigned char)*str))
+		str++;
+	if (*str == '.') {
+		if (!isdigit((unsigned char)*++str))
+			return false;
+		while (isdigit((unsigned char)*str))
+			str++;
+	}
+
+	return !*str;
+}
+
+/* "245.761" as a number, anything else ("N/A", empty) as null */
+static void jesd_json_decimal(const char *str)
+{
+	if (jesd_is_decimal(str))
+		jesd_json_raw(str, strlen(str));
+	else
+		jesd_json_lit("null");
+}
+
+/* "Yes"/"No" as booleans, other states as strings, empty as null */
+static void jesd_json_yes_no(const char *str)
+{
+	if (!strcmp(str, "Yes"))
+		jesd_json_lit("true");
+	else if (!strcmp(str, "No"))
+		jesd_json_lit("false");
+	else if (!*str)
+		jesd_json_lit("null");
+	else
+		jesd_json_str(str);
+}
+
+#define jesd_json_key(key)	jesd_json_lit(",\"" key "\":")
+
+static void jesd_json_status(const struct jesd204b_jesd204_status *info)
+{
+	jesd_json_lit("{\"link_state\":");
+	jesd_json_str(info->link_state);
+	jesd_json_key("link_status");
+	jesd_json_str(info->link_status);
+	jesd_json_key("measured_link_clock_mhz");
+	jesd_json_decimal(info->measured_link_clock);
+	jesd_json_key("reported_link_clock_mhz");
+	jesd_json_decimal(info->reported_link_clock);
+	jesd_json_key("measured_device_clock_mhz");
+	jesd_json_decimal(info->measured_device_clock);
+	jesd_json_key("reported_device_clock_mhz");
+	jesd_json_decimal(info->reported_device_clock);
+	jesd_json_key("desired_device_clock_mhz");
+	jesd_json_decimal(info->desired_device_clock);
+	jesd_json_key("lane_rate_mhz");
+	jesd_json_decimal(info->lane_rate);
+	jesd_json_key("lane_rate_div_mhz");
+	jesd_json_decimal(info->lane_rate_div);
+	jesd_json_key("lmfc_rate_mhz");
+	jesd_json_decimal(info->lmfc_rate);
+	jesd_json_key("sync_state");
+	jesd_json_yes_no(info->sync_state);
+	jesd_json_key("sysref_captured");
+	jesd_json_yes_no(info->sysref_captured);
+	jesd_json_key("sysref_alignment_error");
+	jesd_json_yes_no(info->sysref_alignment_error);
+	jesd_json_key("external_reset");
+	jesd_json_yes_no(info->external_reset);
+	jesd_json_lit("}");
+}
+
+static void jesd_json_lane(unsigned idx, const struct jesd204b_laneinfo *lane,
+			   const struct jesd_lane_history *hist)
+{
+	char rate[32];
+	int len;
+
+#define lane_uint(field)	do { \
+	jesd_json_key(#field); \
+	jesd_json_uint(lane->field); \
+} while (0)
+
+	jesd_json_lit("{\"lane\":");
+	jesd_json_uint(idx);
+	jesd_json_key("errors");
+	jesd_json_uint(lane->lane_errors);
+	jesd_json_key("errors_per_s");
+	len = snprintf(rate, sizeof(rate), "%.3f", jesd_history_rate(hist));
+	jesd_json_raw(rate, len);
+	jesd_json_key("latency_multiframes");
+	jesd_json_uint(lane->lane_latency_multiframes);
+	jesd_json_key("latency_octets");
+	jesd_json_uint(lane->lane_latency_octets);
+	jesd_json_key("latency_min");
+	jesd_json_uint(lane->lane_latency_min);
+	jesd_json_key("latency_max");
+	jesd_json_uint(lane->lane_latency_max);
+	jesd_json_key("cgs_state");
+	jesd_json_yes_no(lane->cgs_state);
+	jesd_json_key("init_frame_sync");
+	jesd_json_yes_no(lane->init_frame_sync);
+	jesd_json_key("init_lane_align_seq");
+	jesd_json_yes_no(lane->init_lane_align_seq);
+	jesd_json_key("ext_multiblock_align_state");
+	jesd_json_yes_no(lane->ext_multiblock_align_state);
+	lane_uint(did);
+	lane_uint(bid);
+	lane_uint(lid);
+	lane_uint(l);
+	lane_uint(scr);
+	lane_uint(f);
+	lane_uint(k);
+	lane_uint(m);
+	lane_uint(n);
+	lane_uint(cs);
+	lane_uint(s);
+	lane_uint(nd);
+	lane_uint(hd);
+	lane_uint(fchk);
+	lane_uint(cf);
+	lane_uint(adjcnt);
+	lane_uint(phyadj);
+	lane_uint(adjdir);
+	lane_uint(jesdv);
+	lane_uint(subclassv);
+	lane_uint(fc);
+	jesd_json_lit("}");
+#undef lane_uint
+}
+
+/* Opens the object of a line, @event is left out for plain snapshots */
+static void jesd_json_head(const int dev_idx, unsigned long long seq,
+			   const struct jesd_snapshot *snap, const char *event)
+{
+	jesd_json_lit("{\"time_us\":");
+	jesd_json_uint(snap->time_us);
+	jesd_json_key("seq");
+	jesd_json_uint(seq);
+	jesd_json_key("device");
+	jesd_json_str(jesd_devices[dev_idx]);
+
+	if (event) {
+		jesd_json_key("event");
+		jesd_json_str(event);
+	}
+}
+
+static void jesd_json_snapshot(const int dev_idx, unsigned long long seq,
+			       const struct jesd_snapshot *snap, const char *event)
+{
+	unsigned i;
+
+	jesd_json_head(dev_idx, seq, snap, event);
+
+	if (snap->err) {
+		jesd_json_key("error");
+		jesd_json_str(strerror(-snap->err));
+		jesd_json_lit("}\n");
+		return;
+	}
+
+	jesd_json_key("encoder");
+	if (snap->encoder == JESD204_ENCODER_8B10B)
+		jesd_json_lit("\"8b10b\"");
+	else if (snap->encoder == JESD204_ENCODER_64B66B)
+		jesd_json_lit("\"64b66b\"");
+	else
+		jesd_json_lit("null");
+	jesd_json_key("read_us");
+	jesd_json_uint(snap->read_us);
+	jesd_json_key("status");
+	jesd_json_status(&snap->status);
+
+	jesd_json_key("lanes");
+	jesd_json_lit("[");
+	for (i = 0; i < snap->lanes; i++) {
+		if (i)
+			jesd_json_lit(",");
+		jesd_json_lane(i, &snap->lane[i], &history[dev_idx][i]);
+	}
+	jesd_json_lit("]}\n");
+}
+
+/*
+ * Change events (-e): each read is compared with the previous one of the
+ * device and only the differences are written. The first read, and any read
+ * that changes the shape of the device (read errors, lane count, encoder),
+ * writes a full "snapshot" event instead.
+ */
+struct jesd_field_ref {
+	const char *name;
+	size_t offset;
+};
+
+#define STATUS_REF(field)	{ #field, offsetof(struct jesd204b_jesd204_status, field) }
+#define LANE_REF(field)		{ #field, offsetof(struct jesd204b_laneinfo, field) }
+#define FIELD_STR(base, ref)	((const char *)(base) + (ref)->offset)
+
+static const struct jesd_field_ref status_events[] = {
+	STATUS_REF(link_state),
+	STATUS_REF(link_status),
+	STATUS_REF(sync_state),
+	STATUS_REF(sysref_captured),
+	STATUS_REF(sysref_alignment_error),
+	STATUS_REF(external_reset),
+};
+
+static const struct jesd_field_ref lane_events[] = {
+	LANE_REF(cgs_state),
+	LANE_REF(init_frame_sync),
+	LANE_REF(init_lane_align_seq),
+	LANE_REF(ext_multiblock_align_state),
+};
+
+/* The clock checks of the status window, @ref[0] against @ref[1] */
+static const struct jesd_field_ref clock_events[][2] = {
+	{ STATUS_REF(measured_link_clock), STATUS_REF(reported_link_clock) },
+	{ STATUS_REF(reported_link_clock), STATUS_REF(lane_rate_div) },
+	{ STATUS_REF(measured_device_clock), STATUS_REF(reported_device_clock) },
+	{ STATUS_REF(reported_device_clock), STATUS_REF(desired_device_clock) },
+};
+
+/* 1 within CLOCK_ACCURACY, 0 outside, -1 if either clock is not reported */
+static int jesd_clock_state(const struct jesd204b_jesd204_status *info,
+			    const struct jesd_field_ref ref[2])
+{
+	const char *val = FIELD_STR(info, &ref[0]), *reference = FIELD_STR(info, &ref[1]);
+
+	if (!jesd_is_decimal(val) || !jesd_is_decimal(reference))
+		return -1;
+
+	return jesd_clock_color(val, reference) == C_GOOD;
+}
+
+static void jesd_json_change(const char *from, const char *to)
+{
+	jesd_json_key("from");
+	jesd_json_yes_no(from);
+	jesd_json_key("to");
+	jesd_json_yes_no(to);
+	jesd_json_lit("}\n");
+}
+
+static void jesd_json_clock(const struct jesd204b_jesd204_status *info,
+			    const struct jesd_field_ref ref[2], int state)
+{
+	const char *val = FIELD_STR(info, &ref[0]), *reference = FIELD_STR(info, &ref[1]);
+	char ppm[32];
+	int len;
+
+	jesd_json_key("clock");
+	jesd_json_str(ref[0].name);
+	jesd_json_key("reference");
+	jesd_json_str(ref[1].name);
+	jesd_json_key("value_mhz");
+	jesd_json_decimal(val);
+	jesd_json_key("reference_mhz");
+	jesd_json_decimal(reference);
+	jesd_json_key("deviation_ppm");
+	if (state >= 0 && strtod(reference, NULL)) {
+		len = snprintf(ppm, sizeof(ppm), "%.1f",
+			       (strtod(val, NULL) / strtod(reference, NULL) - 1) * 1e6);
+		jesd_json_raw(ppm, len);
+	} else {
+		jesd_json_lit("null");
+	}
+	jesd_json_key("in_tolerance");
+	if (state < 0)
+		jesd_json_lit("null");
+	else if (state)
+		jesd_json_lit("true");
+	else
+		jesd_json_lit("false");
+	jesd_json_lit("}\n");
+}
+
+static void jesd_json_events(const int dev_idx, unsigned long long seq,
+			     const struct jesd_snapshot *prev,
+			     const struct jesd_snapshot *cur)
+{
+	const struct jesd204b_laneinfo *old, *new;
+	const struct jesd_field_ref *ref;
+	unsigned i, lane;
+	int state;
+
+	if (!prev->valid || prev->err != cur->err || prev->lanes != cur->lanes ||
+	    prev->encoder != cur->encoder) {
+		jesd_json_snapshot(dev_idx, seq, cur, "snapshot");
+		return;
+	}
+
+	if (cur->err)
+		return;
+
+	for (i = 0; i < ARRAY_SIZE(status_events); i++) {
+		ref = &status_events[i];
+		if (!strcmp(FIELD_STR(&prev->status, ref), FIELD_STR(&cur->status, ref)))
+			continue;
 
-	for (i = 0, latency_min = INT_MAX; i < lanes; i++) {
-		lane = tmp++;
-		octets_per_multifame = lane->k * lane->f;
+		jesd_json_head(dev_idx, seq, cur, "status");
+		jesd_json_key("field");
+		jesd_json_str(ref->name);
+		jesd_json_change(FIELD_STR(&prev->status, ref), FIELD_STR(&cur->status, ref));
+	}
 
-		latency_min = MIN(latency_min, octets_per_multifame *
-				  lane->lane_latency_multiframes +
-				  lane->lane_latency_octets);
+	for (i = 0; i < ARRAY_SIZE(clock_events); i++) {
+		state = jesd_clock_state(&cur->status, clock_events[i]);
+		if (state == jesd_clock_state(&prev->status, clock_events[i]))
+			continue;
+
+		jesd_json_head(dev_idx, seq, cur, "clock");
+		jesd_json_clock(&cur->status, clock_events[i], state);
 	}
 
-	for (i = 0; i < lanes; i++) {
-		y = 1;
+	for (lane = 0; lane < cur->lanes; lane++) {
+		old = &prev->lane[lane];
+		new = &cur->lane[lane];
+
+		if (old->lane_errors != new->lane_errors) {
+			jesd_json_head(dev_idx, seq, cur, "lane_errors");
+			jesd_json_key("lane");
+			jesd_json_uint(lane);
+			jesd_json_key("from");
+			jesd_json_uint(old->lane_errors);
+			jesd_json_key("to");
+			jesd_json_uint(new->lane_errors);
+			jesd_json_lit("}\n");
+		}
 
-		lane = info++;
+		for (i = 0; i < ARRAY_SIZE(lane_events); i++) {
+			ref = &lane_events[i];
+			if (!strcmp(FIELD_STR(old, ref), FIELD_STR(new, ref)))
+				continue;
 
-		if (encoder == JESD204_ENCODER_64B66B) {
-			if (lane->lane_latency_octets == 0 && lane->lane_latency_min == 0 && lane->lane_latency_max == 0) {
-				c = C_GOOD;
-				not_available = true;
-			} else if (lane->lane_latency_octets < lane->lane_latency_min || lane->lane_latency_octets > lane->lane_latency_max) {
-				c = C_ERR;
-			} else {
-				c = C_GOOD;
+			jesd_json_head(dev_idx, seq, cur, "lane_state");
+			jesd_json_key("lane");
+			jesd_json_uint(lane);
+			jesd_json_key("field");
+			jesd_json_str(ref->name);
+			jesd_json_change(FIELD_STR(old, ref), FIELD_STR(new, ref));
+		}
+	}
+}
+
+/*
+ * -j, -e: reads all devices every refresh interval until SIGINT or SIGTERM,
+ * writing snapshots or change events.
+ */
+static int jesd_json_loop(struct pollfd pfd[4])
+{
+	static struct jesd_snapshot snap[2][MAX_DEVICES];
+	unsigned long long seq = 0;
+	unsigned cur = 0;
+	struct signalfd_siginfo si;
+	uint64_t expired;
+	int i, update = 1;
+
+	/* No keys without a terminal */
+	pfd[0].fd = -1;
+
+	while (true) {
+		if (update) {
+			seq++;
+			for (i = 0; i < dev_num; i++) {
+				jesd_read_snapshot(i, &snap[cur][i]);
+				jesd_history_update(i, &snap[cur][i]);
+				if (events)
+					jesd_json_events(i, seq, &snap[!cur][i], &snap[cur][i]);
+				else
+					jesd_json_snapshot(i, seq, &snap[cur][i], NULL);
 			}
-		} else {
-			octets_per_multifame = lane->k * lane->f;
+			cur = !cur;
 
-			latency = octets_per_multifame * lane->lane_latency_multiframes +
-				  lane->lane_latency_octets;
+			if (jesd_json_flush())
+				return json_err;
+		}
 
-			if ((latency - latency_min) >= octets_per_multifame)
-				c = C_ERR;
-			else if ((latency - latency_min) > (octets_per_multifame / 2))
-				c = C_CRIT;
-			else
-				c = C_GOOD;
+		update = 0;
+
+		if (poll(pfd, 4, -1) < 0) {
+			if (errno == EINTR)
+				continue;
+			return -errno;
 		}
 
-		wcolor_set(win, C_NORM, NULL);
+		if (pfd[2].revents & POLLIN &&
+		    read(pfd[2].fd, &expired, sizeof(expired)) > 0)
+			update = 1;
 
-		jesd_clear_line_from(win, y, x);
-		mvwprintw(win, y++, x, "%d", i);
-		pos = jesd_maxx(pos, jesd_get_strlen(win, x));
+		while (read(pfd[1].fd, &si, sizeof(si)) == sizeof(si))
+			if (si.ssi_signo != SIGWINCH)
+				return 0;
+	}
+}
 
+/*
+ * Bytes written by the main thread, all of which is terminal output. The
+ * dashboard workers signal through an eventfd and must not be counted.
+ */
+static unsigned long long jesd_term_bytes(void)
+{
+	unsigned long long bytes = 0;
+	char buf[256], *wchar;
+	int fd, len;
 
-		if (lane->lane_errors)
-			wcolor_set(win, C_ERR, NULL);
-		else
-			wcolor_set(win, C_GOOD, NULL);
+	fd = open("/proc/thread-self/io", O_RDONLY);
+	if (fd < 0)
+		return 0;
 
-		jesd_clear_line_from(win, y, x);
-		mvwprintw(win, y++, x, "%d", lane->lane_errors);
-		pos = jesd_maxx(pos, jesd_get_strlen(win, x));
+	len = read(fd, buf, sizeof(buf) - 1);
+	close(fd);
+	if (len <= 0)
+		return 0;
 
-		if (encoder == JESD204_ENCODER_64B66B) {
-			wcolor_set(win, c, NULL);
-			jesd_clear_line_from(win, y, x);
-			if (not_available) {
-				mvwprintw(win, y++, x, "N/A");
-			} else {
-				mvwprintw(win, y++, x, "%u", lane->lane_latency_octets);
-			}
-			pos = jesd_maxx(pos, jesd_get_strlen(win, x));
+	buf[len] = '\0';
+	wchar = strstr(buf, "wchar:");
+	if (wchar)
+		bytes = strtoull(wchar + 6, NULL, 10);
 
-			pos = jesd_maxx(pos, jesd_print_win_exp(win, y++, x,
-								lane->ext_multiblock_align_state,
-								"EMB_LOCK", 0, true));
-			x += pos + COL_SPACEING;
-			continue;
-		}
+	return bytes;
+}
 
-		wcolor_set(win, c, NULL);
-		jesd_clear_line_from(win, y, x);
-		mvwprintw(win, y++, x, "%d/%d", lane->lane_latency_multiframes,
-			  lane->lane_latency_octets);
-		pos = jesd_maxx(pos, jesd_get_strlen(win, x));
+/*
+ * Debug footer with the bytes the last refresh sent to the terminal. The count
+ * is taken before the footer is drawn so the footer does not report itself.
+ */
+static void jesd_debug_footer(void)
+{
+	static unsigned long long last, total, refreshes;
+	unsigned long long now = jesd_term_bytes();
+	int termx, termy;
 
-		pos = jesd_maxx(pos, jesd_print_win_exp(win, y++, x, lane->cgs_state, "DATA",
-							0, true));
-		pos = jesd_maxx(pos, jesd_print_win_exp(win, y++, x, lane->init_frame_sync,
-							"Yes", 0, true));
-		pos = jesd_maxx(pos, jesd_print_win_exp(win, y++, x, lane->init_lane_align_seq,
-							"Yes", 0, true));
+	if (!debug)
+		return;
 
-		x += pos + COL_SPACEING;
+	if (last) {
+		total += now - last;
+		refreshes++;
 	}
 
-	return x;
+	getmaxyx(main_win, termy, termx);
+	jesd_clear_line_from(main_win, termy - 4, 1);
+	mvwprintw(main_win, termy - 4, 1, "(DEBUG) %llu bytes last refresh, %.1f average",
+		  last ? now - last : 0, refreshes ? (double)total / refreshes : 0.0);
+	jesd_redo_r_box(main_win, simple);
+	(void)termx;
+	wrefresh(main_win);
+
+	last = jesd_term_bytes();
 }
 
-int jesd_update_status(WINDOW *win, int x, const char *device)
+/* (Re)creates the windows for the current terminal size */
+static void jesd_setup_windows(void)
 {
-	struct jesd204b_jesd204_status info;
-	float measured, reported, div40;
-	enum color_pairs c_measured_link_clock, c_lane_rate_div,
-	     c_measured_device_clock, c_reported_device_clock;
-	int y = 1, pos = 0;
+	int termx, termy, x = 1, i;
 
-	if (g_jesd_iio_ctx) {
-		jesd_read_jesd204_status(device, &info);
-	} else {
-		char *path = get_full_device_path(basedir, device);
-		if (!path)
-			return -1;
-		jesd_read_jesd204_status(path, &info);
-		free(path);
+	if (main_win) {
+		delwin(lane_win);
+		delwin(stat_win);
+		delwin(dev_win);
+		delwin(main_win);
 	}
 
-	if (sscanf((char *)&info.measured_link_clock, "%f", &measured) != 1)
-		measured = 0.0f;
-	if (sscanf((char *)&info.reported_link_clock, "%f", &reported) != 1)
-		reported = 0.0f;
-	if (sscanf((char *)&info.lane_rate_div, "%f", &div40) != 1)
-		div40 = 0.0f;
+	clear();
+	refresh();
+	stat_cells.valid = lane_cells.valid = dash_cells.valid = false;
 
-	if (measured > (reported * (1 + PPM(CLOCK_ACCURACY))) ||
-	    measured < (reported * (1 - PPM(CLOCK_ACCURACY))))
-		c_measured_link_clock = C_ERR;
-	else
-		c_measured_link_clock = C_GOOD;
+	getmaxyx(stdscr, termy, termx);
+	main_win = newwin(termy, termx, 0, 0);
+	dev_win = newwin(dev_num + 3, termx - 2, 1, 1);
+	stat_win = newwin(ARRAY_SIZE(link_status_labels) + 1, termx - 2, dev_num + 4,
+			  1);
+	lane_win = newwin(ARRAY_SIZE(lane_status_labels) + 1, termx - 2,
+			  dev_num + ARRAY_SIZE(link_status_labels) + 5, 1);
 
-	if (reported > (div40 * (1 + PPM(CLOCK_ACCURACY))) ||
-	    reported < (div40 * (1 - PPM(CLOCK_ACCURACY))))
-		c_lane_rate_div = C_ERR;
-	else
-		c_lane_rate_div = C_GOOD;
-
-	if (info.measured_device_clock[0] != 'N') {
-		if (sscanf((char *)&info.measured_device_clock, "%f", &measured) != 1)
-			measured = 0.0f;
-		if (sscanf((char *)&info.reported_device_clock, "%f", &reported) != 1)
-			reported = 0.0f;
-		if (sscanf((char *)&info.desired_device_clock, "%f", &div40) != 1)
-			div40 = 0.0f;
-
-		if (measured > (reported * (1 + PPM(CLOCK_ACCURACY))) ||
-		    measured < (reported * (1 - PPM(CLOCK_ACCURACY))))
-			c_measured_device_clock = C_ERR;
-		else
-			c_measured_device_clock = C_GOOD;
+	/* The cursor is hidden, do not move it around on every refresh */
+	leaveok(main_win, TRUE);
+	leaveok(dev_win, TRUE);
+	leaveok(stat_win, TRUE);
+	leaveok(lane_win, TRUE);
 
-		if (reported > (div40 * (1 + PPM(CLOCK_ACCURACY))) ||
-		    reported < (div40 * (1 - PPM(CLOCK_ACCURACY))))
-			c_reported_device_clock = C_ERR;
-		else
-			c_reported_device_clock = C_GOOD;
-	} else {
-		c_measured_device_clock = C_NORM;
-		c_reported_device_clock = C_NORM;
+	if (!simple) {
+		box(dev_win, 0, 0);
+		box(main_win, 0, 0);
+		box(stat_win, 0, 0);
+		box(lane_win, 0, 0);
 	}
 
-	pos = jesd_maxx(pos, jesd_print_win_exp(win, y++, x, (char *)&info.link_state,
-						"enabled", 0, true));
-	pos = jesd_maxx(pos, jesd_print_win_exp(win, y++, x, (char *)&info.link_status,
-						"DATA", 0, true));
-	pos = jesd_maxx(pos, jesd_print_win(win, y++, x, c_measured_link_clock,
-					    (char *)&info.measured_link_clock, true));
-	pos = jesd_maxx(pos, jesd_print_win(win, y++, x, C_NORM,
-					    (char *)&info.reported_link_clock, true));
-	pos = jesd_maxx(pos, jesd_print_win(win, y++, x, c_measured_device_clock,
-					    (char *)&info.measured_device_clock, true));
-	pos = jesd_maxx(pos, jesd_print_win(win, y++, x, c_reported_device_clock,
-					    (char *)&info.reported_device_clock, true));
-	pos = jesd_maxx(pos, jesd_print_win(win, y++, x, C_NORM,
-					    (char *)&info.desired_device_clock, true));
-	pos = jesd_maxx(pos, jesd_print_win(win, y++, x, C_NORM,
-					    (char *)&info.lane_rate, true));
-	pos = jesd_maxx(pos, jesd_print_win(win, y++, x, c_lane_rate_div,
-					    (char *)&info.lane_rate_div, true));
-	pos = jesd_maxx(pos, jesd_print_win(win, y++, x, C_NORM,
-					    (char *)&info.lmfc_rate, true));
-	pos = jesd_maxx(pos, jesd_print_win_exp(win, y++, x,
-						(char *)&info.sysref_captured, "No", 1, true));
-	pos = jesd_maxx(pos, jesd_print_win_exp(win, y++, x,
-						(char *)&info.sysref_alignment_error, "Yes", 1, true));
-	if (encoder == JESD204_ENCODER_8B10B)
-		pos = jesd_maxx(pos, jesd_print_win_exp(win, y++, x, (char *)&info.sync_state,
-							"deasserted", 0, true));
+	mvwprintw(dev_win, 0, 1, "(DEVICES) Found %d JESD204 Link Layer peripherals",
+		  dev_num);
 
-	return pos + COL_SPACEING;
+	for (i = 0; i < dev_num; i++) {
+		mvwprintw(dev_win, 2 + i, 1, "(%d): %s", i, jesd_devices[i]);
+		x += jesd_print_win_args(main_win, termy - 2, x, C_NORM, "F%d", i + 1);
+		x += jesd_print_win_args(main_win, termy - 2, x, C_OPT, "%s", jesd_devices[i]);
+	}
+	/* add quit option */
+	x += jesd_print_win_args(main_win, termy - 2, x, C_NORM, "F%d",
+				 MAX_DEVICES + 1);
+	jesd_print_win(main_win, termy - 2, x, C_OPT, "Quit", false);
+
+	jesd_print_win(main_win, termy - 3, 1, C_OPT,
+		       "You can also use 'q' to quit and 'a' or 'd' to move between devices!",
+		       false);
+
+	wrefresh(main_win);
+	wrefresh(dev_win);
 }
 
-int jesd_setup_subwin(WINDOW *win, const char *name, const char **labels)
+/* Redraws the status and lanes windows from @snap of @dev_idx */
+static void jesd_show_device(const int dev_idx, const struct jesd_snapshot *snap)
 {
-	int i = 0, pos = 0;
+	int x;
 
-	mvwprintw(win, 0, 1, "%s", name);
+	encoder = snap->encoder;
 
-	while (labels[i]) {
-		pos = jesd_maxx(pos, jesd_print_win(win, i + 1, 1, C_NORM, labels[i], false));
-		i++;
+	/* Labels and boxes are only drawn after the windows were cleared */
+	if (encoder == JESD204_ENCODER_8B10B)
+		x = jesd_setup_subwin(stat_win, "(STATUS)", link_status_labels,
+				      !stat_cells.valid);
+	else
+		x = jesd_setup_subwin(stat_win, "(STATUS)", link_status_labels_64b66b,
+				      !stat_cells.valid);
+
+	jesd_update_status(stat_win, x, &snap->status);
+
+	if (snap->lanes) {
+		if (!simple && !lane_cells.valid)
+			box(lane_win, 0, 0);
+
+		if (encoder == JESD204_ENCODER_8B10B)
+			x = jesd_setup_subwin(lane_win, "(LANE STATUS)", lane_status_labels,
+					      !lane_cells.valid);
+		else
+			x = jesd_setup_subwin(lane_win, "(LANE STATUS)", lane_status_labels_64b66b,
+					      !lane_cells.valid);
+
+		update_lane_status(lane_win, x + 1, snap->lane, history[dev_idx],
+				   snap->lanes);
+		wnoutrefresh(lane_win);
 	}
 
-	return pos + COL_SPACEING;
+	wnoutrefresh(stat_win);
 }
 
-static void jesd_set_current_device(const int dev_idx)
+/* Replaces the status and lanes of @dev_idx by why it could not be read */
+static void jesd_show_error(const int dev_idx, const struct jesd_snapshot *snap)
 {
-	wcolor_set(dev_win, C_GOOD, NULL);
-	mvwprintw(dev_win, 2 + dev_idx, strlen(jesd_devices[dev_idx]) + 8, "[*]");
-	wcolor_set(dev_win, C_NORM, NULL);
-	wrefresh(dev_win);
+	/* Labels and boxes are redrawn once the device reads again */
+	stat_cells.valid = lane_cells.valid = false;
+
+	werase(lane_win);
+	werase(stat_win);
+
+	if (!simple) {
+		box(lane_win, 0, 0);
+		box(stat_win, 0, 0);
+	}
+
+	mvwprintw(stat_win, 0, 1, "(STATUS)");
+	wcolor_set(stat_win, C_ERR, NULL);
+	mvwprintw(stat_win, 1, 1, "%s unavailable: %s", jesd_devices[dev_idx],
+		  strerror(-snap->err));
+	wcolor_set(stat_win, C_NORM, NULL);
+
+	wnoutrefresh(lane_win);
+	wnoutrefresh(stat_win);
 }
 
 /*
- * This is a workaround to redraw the right line in the windows boxes/borders.
- * This happens because `jesd_clear_line_from()` will clear the current line
- * till the EOL which removes part of the box vertical line.
+ * Redraws @dev_idx, re-reading it unless in dashboard mode where the workers
+ * keep the snapshots of all devices current.
  */
-static void jesd_redo_r_box(WINDOW *win, const int simple)
+static void jesd_refresh(const int dev_idx)
 {
-	int x, y;
+	static struct jesd_snapshot snaps[MAX_DEVICES];
+	int i;
 
-	if (simple)
-		return;
+	if (dashboard) {
+		for (i = 0; i < dev_num; i++) {
+			jesd_pool_get(i, &snaps[i]);
+			jesd_history_update(i, &snaps[i]);
+		}
 
-	getmaxyx(win, y, x);
-	wmove(win, 1, x - 1);
-	/* redraw vertical line */
-	wvline(win, 0, y - 2);
+		jesd_update_dashboard(snaps);
+		wnoutrefresh(dev_win);
+	} else {
+		/* A device that cannot be opened is retried on the next refresh */
+		jesd_read_snapshot(dev_idx, &snaps[dev_idx]);
+		jesd_history_update(dev_idx, &snaps[dev_idx]);
+	}
+
+	if (snaps[dev_idx].valid && snaps[dev_idx].err)
+		jesd_show_error(dev_idx, &snaps[dev_idx]);
+	else if (snaps[dev_idx].valid)
+		jesd_show_device(dev_idx, &snaps[dev_idx]);
+
+	doupdate();
+
+	jesd_debug_footer();
 }
 
-static void jesd_move_device(const int old_idx, const int new_idx,
-			     const int simple)
+/*
+ * Terminal resizes and quit requests arrive through a signalfd, the refresh
+ * interval through a timerfd, so the loop sleeps in poll() until one of them
+ * or a key press needs handling.
+ */
+static int jesd_event_fds(struct pollfd pfd[4], unsigned refresh_ms)
 {
-	if (old_idx == new_idx)
-		return;
-	/* clear the old selected dev */
-	jesd_clear_line_from(dev_win, 2 + old_idx, strlen(jesd_devices[old_idx]) + 6);
-	jesd_redo_r_box(dev_win, simple);
-	jesd_set_current_device(new_idx);
-	/* Clear the lane window since the next device might not have lane info */
-	jesd_clear_win(lane_win, true);
-	wrefresh(lane_win);
-	jesd_clear_win(stat_win, simple);
+	struct itimerspec its = {
+		.it_interval.tv_sec = refresh_ms / 1000,
+		.it_interval.tv_nsec = (refresh_ms % 1000) * 1000000L,
+	};
+	sigset_t mask;
+
+	sigemptyset(&mask);
+	sigaddset(&mask, SIGWINCH);
+	sigaddset(&mask, SIGINT);
+	sigaddset(&mask, SIGTERM);
+
+	if (sigprocmask(SIG_BLOCK, &mask, NULL))
+		return -errno;
+
+	pfd[0].fd = STDIN_FILENO;
+	pfd[1].fd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+	pfd[2].fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+	if (pfd[1].fd < 0 || pfd[2].fd < 0)
+		return -errno;
+
+	its.it_value = its.it_interval;
+	if (timerfd_settime(pfd[2].fd, 0, &its, NULL))
+		return -errno;
+
+	/* dashboard workers, a negative fd is ignored by poll() */
+	pfd[3].fd = pool.efd;
+
+	pfd[0].events = pfd[1].events = pfd[2].events = pfd[3].events = POLLIN;
+
+	return 0;
 }
 
 int main(int argc, char *argv[])
 {
-	int c, cnt = 0, x = 1, i, simple = 0;
+	int c, i, quit = 0, update, ret = 0;
 	int up_key = 'a', down_key = 'd';
-	int termx, termy, dev_num = 0;
+	unsigned refresh_ms = REFRESH_MS;
+	struct signalfd_siginfo si;
+	struct pollfd pfd[4];
+	struct winsize ws;
+	uint64_t expired;
 	char *path = NULL;
 	char *uri = NULL;
-	int dev_idx = 0;
+	int dev_idx = 0, old_idx;
 
 	opterr = 0;
 
-	while ((c = getopt(argc, argv, "svp:u:")) != -1)
+	while ((c = getopt(argc, argv, "svDmjep:u:r:")) != -1)
 		switch (c) {
 		case 'p':
 			path = optarg;
@@ -441,6 +1697,19 @@ int main(int argc, char *argv[])
 		case 's': /* Simple mode */
 			simple = 1;
 			break;
+		case 'j': /* NDJSON on stdout, no curses */
+			json = 1;
+			break;
+		case 'e': /* NDJSON change events */
+			json = 1;
+			events = 1;
+			break;
+		case 'm': /* Dashboard of all devices */
+			dashboard = 1;
+			break;
+		case 'D': /* Debug footer */
+			debug = 1;
+			break;
 		case 'v':
 			up_key = 'k';
 			down_key = 'j';
@@ -448,11 +1717,19 @@ int main(int argc, char *argv[])
 		case 'u':
 			uri = optarg;
 			break;
+		case 'r':
+			refresh_ms = strtoul(optarg, NULL, 0);
+			if (!refresh_ms) {
+				fprintf(stderr, "Refresh interval must be at least 1 ms\n");
+				return 1;
+			}
+			break;
 		case '?':
-			if (optopt == 'd' || optopt == 'p')
+			if (optopt == 'p' || optopt == 'u' || optopt == 'r')
 				fprintf(stderr, "Option -%c requires an argument.\n", optopt);
 			else if (isprint(optopt))
-				fprintf(stderr, "Unknown option `-%c'.\n%s [-p PATH]\n",
+				fprintf(stderr, "Unknown option `-%c'.\n"
+					"%s [-p PATH | -u URI] [-s] [-v] [-m] [-D] [-j | -e] [-r REFRESH_MS]\n",
 					optopt, argv[0]);
 			else
 				fprintf(stderr, "Unknown option character `\\x%x'.\n", optopt);
@@ -466,7 +1743,14 @@ int main(int argc, char *argv[])
 	if (!path)
 		path = "";
 
-	if (uri) {
+	if (uri && !strncmp(uri, JESD_MONITOR_PREFIX, strlen(JESD_MONITOR_PREFIX))) {
+		/* Snapshots published by jesd_monitord */
+		if (jesd_monitor_attach(uri + strlen(JESD_MONITOR_PREFIX)))
+			return 1;
+		strcpy(basedir, JESD_MONITOR_BASEDIR);
+		dev_num = jesd_find_devices(basedir, JESD204_RX_DRIVER_NAME, "status", jesd_devices, 0);
+		dev_num = jesd_find_devices(basedir, JESD204_TX_DRIVER_NAME, "status", jesd_devices, dev_num);
+	} else if (uri) {
 		/* Use libiio */
 		g_jesd_iio_ctx = jesd_iio_create_context(uri);
 		if (!g_jesd_iio_ctx) {
@@ -486,6 +1770,26 @@ int main(int argc, char *argv[])
 		return 0;
 	}
 
+	/* A libiio context is not shared between threads */
+	if (dashboard && !json && jesd_pool_start(g_jesd_iio_ctx ? 1 : dev_num)) {
+		fprintf(stderr, "Failed to start the dashboard workers\n");
+		jesd_pool_stop();
+		return 1;
+	}
+
+	/* Before initscr(), ncurses must not see SIGWINCH */
+	if (jesd_event_fds(pfd, refresh_ms)) {
+		fprintf(stderr, "Failed to set up the event loop: %s\n", strerror(errno));
+		return 1;
+	}
+
+	if (json) {
+		ret = jesd_json_loop(pfd);
+		if (ret)
+			fprintf(stderr, "Failed to write JSON: %s\n", strerror(-ret));
+		goto out;
+	}
+
 	terminal_start();
 
 	if (has_colors() /*&& COLOR_PAIRS >= 3*/) {
@@ -498,127 +1802,96 @@ int main(int argc, char *argv[])
 		bkgd(COLOR_PAIR(1));
 	}
 
-	refresh();
-
-	getmaxyx(stdscr, termy, termx);
-	main_win = newwin(termy, termx, 0, 0);
-	dev_win = newwin(dev_num + 3, termx - 2, 1, 1);
-	stat_win = newwin(ARRAY_SIZE(link_status_labels) + 1, termx - 2, dev_num + 4,
-			  1);
-	lane_win = newwin(ARRAY_SIZE(lane_status_labels) + 1, termx - 2,
-			  dev_num + ARRAY_SIZE(link_status_labels) + 5, 1);
-
-	if (!simple) {
-		box(dev_win, 0, 0);
-		box(main_win, 0, 0);
-		box(stat_win, 0, 0);
-		box(lane_win, 0, 0);
-	}
-
-	mvwprintw(dev_win, 0, 1, "(DEVICES) Found %d JESD204 Link Layer peripherals",
-		  dev_num);
-
-	for (i = 0; i < dev_num; i++) {
-		mvwprintw(dev_win, 2 + i, 1, "(%d): %s", i, jesd_devices[i]);
-		x += jesd_print_win_args(main_win, termy - 2, x, C_NORM, "F%d", i + 1);
-		x += jesd_print_win_args(main_win, termy - 2, x, C_OPT, "%s", jesd_devices[i]);
-	}
-	/* add quit option */
-	x += jesd_print_win_args(main_win, termy - 2, x, C_NORM, "F%d",
-				 MAX_DEVICES + 1);
-	jesd_print_win(main_win, termy - 2, x, C_OPT, "Quit", false);
-
-	jesd_print_win(main_win, termy - 3, 1, C_OPT,
-		       "You can also use 'q' to quit and 'a' or 'd' to move between devices!",
-		       false);
-
-	wrefresh(main_win);
-	wrefresh(dev_win);
+	jesd_setup_windows();
 
 	/* defaut to first device */
 	jesd_set_current_device(0);
+	update = 1;
 
-	while (true) {
-		char *path = NULL;
-
-		if (g_jesd_iio_ctx) {
-			encoder = jesd_read_encoding(jesd_devices[dev_idx]);
-		} else {
-			path = get_full_device_path(basedir, jesd_devices[dev_idx]);
-			if (!path)
-				continue;
-			encoder = jesd_read_encoding(path);
-		}
-
-		if (encoder == JESD204_ENCODER_8B10B)
-			x = jesd_setup_subwin(stat_win, "(STATUS)", link_status_labels);
-		else
-			x = jesd_setup_subwin(stat_win, "(STATUS)", link_status_labels_64b66b);
+	if (dashboard)
+		jesd_pool_round();
 
-		jesd_update_status(stat_win, x, jesd_devices[dev_idx]);
-		jesd_redo_r_box(stat_win, simple);
+	while (!quit) {
+		if (update)
+			jesd_refresh(dev_idx);
 
-		if (g_jesd_iio_ctx) {
-			cnt = jesd_read_all_laneinfo(jesd_devices[dev_idx], lane_info);
-		} else {
-			if (!path) {
-				path = get_full_device_path(basedir, jesd_devices[dev_idx]);
-				if (!path)
-					continue;
-			}
-			cnt = jesd_read_all_laneinfo(path, lane_info);
-		}
+		update = 0;
 
-		if (path) {
-			free(path);
-			path = NULL;
+		if (poll(pfd, ARRAY_SIZE(pfd), -1) < 0) {
+			if (errno == EINTR)
+				continue;
+			break;
 		}
-		if (cnt) {
-			if (!simple)
-				box(lane_win, 0, 0);
 
-			if (encoder == JESD204_ENCODER_8B10B)
-				x = jesd_setup_subwin(lane_win, "(LANE STATUS)", lane_status_labels);
+		if (pfd[2].revents & POLLIN &&
+		    read(pfd[2].fd, &expired, sizeof(expired)) > 0) {
+			/* -EBUSY: a slow device still holds up the last round */
+			if (dashboard)
+				jesd_pool_round();
 			else
-				x = jesd_setup_subwin(lane_win, "(LANE STATUS)", lane_status_labels_64b66b);
+				update = 1;
+		}
 
-			update_lane_status(lane_win, x + 1, lane_info, cnt);
-			jesd_redo_r_box(lane_win, simple);
-			wrefresh(lane_win);
+		/* Dashboard devices are drawn as soon as they were read */
+		if (pfd[3].revents & POLLIN) {
+			if (read(pfd[3].fd, &expired, sizeof(expired)) > 0)
+				update = 1;
 		}
 
-		wrefresh(stat_win);
-		usleep(1000 * 250); /* 250 ms */
+		while (read(pfd[1].fd, &si, sizeof(si)) == sizeof(si)) {
+			if (si.ssi_signo != SIGWINCH) {
+				quit = 1;
+				break;
+			}
 
-		c = getch();
-		if (c >= KEY_F(1) && c <= KEY_F0 + dev_num) {
-			int old_idx = dev_idx;
-			dev_idx = c - KEY_F0 - 1;
-			jesd_move_device(old_idx, dev_idx, simple);
-		} else if (c == down_key) {
-			int old_idx = dev_idx;
+			if (!ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws))
+				resizeterm(ws.ws_row, ws.ws_col);
+			jesd_setup_windows();
+			jesd_set_current_device(dev_idx);
+			update = 1;
+		}
 
-			if (dev_idx + 1 >= dev_num)
-				dev_idx = 0;
-			else
-				dev_idx++;
-			jesd_move_device(old_idx, dev_idx, simple);
-		} else if (c == up_key) {
-			int old_idx = dev_idx;
-			if (!dev_idx)
-				dev_idx = dev_num - 1;
-			else
-				dev_idx--;
-			jesd_move_device(old_idx, dev_idx, simple);
-		} else if (c == KEY_F0 + MAX_DEVICES + 1 || c == 'q')
-			break;
+		/* Keys take effect right away, not at the next refresh */
+		while (!quit && (c = getch()) != ERR) {
+			old_idx = dev_idx;
+
+			if (c >= KEY_F(1) && c <= KEY_F0 + dev_num) {
+				dev_idx = c - KEY_F0 - 1;
+			} else if (c == down_key) {
+				if (dev_idx + 1 >= dev_num)
+					dev_idx = 0;
+				else
+					dev_idx++;
+			} else if (c == up_key) {
+				if (!dev_idx)
+					dev_idx = dev_num - 1;
+				else
+					dev_idx--;
+			} else if (c == KEY_F0 + MAX_DEVICES + 1 || c == 'q') {
+				quit = 1;
+			}
 
+			if (dev_idx != old_idx) {
+				jesd_move_device(old_idx, dev_idx, simple);
+				update = 1;
+			}
+		}
 	}
 
 	terminal_stop();
 
+	if (dashboard)
+		jesd_pool_stop();
+out:
+	for (i = 0; i < dev_num; i++)
+		jesd_device_close(jesd_handles[i]);
+
+	close(pfd[1].fd);
+	close(pfd[2].fd);
+
 	if (g_jesd_iio_ctx)
 		jesd_iio_destroy_context(g_jesd_iio_ctx);
+	jesd_monitor_detach();
 
-	return 0;
+	return !!ret;
 }